@@ -19,6 +19,7 @@
 
 #include <QObject>
 #include <QPoint>
+#include <QRect>
 #include <QSize>
 #include <QMutex>
 
@@ -62,6 +63,9 @@ struct ExtraWindowInfo {
 
     bool allowClientResize{true};
 
+    // Saved restore rect of a window placed maximized or fullscreen, applied once Mir created it
+    QRect savedRestoreRect;
+
     QMutex mutex;
 };
 
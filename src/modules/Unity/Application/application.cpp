@@ -18,10 +18,13 @@
 #include "application.h"
 #include "applicationinfo.h"
 #include "application_manager.h"
+#include "lifecyclescheduler.h"
 #include "mirsurfaceinterface.h"
 #include "session.h"
+#include "sessionmodel.h"
 #include "sharedwakelock.h"
 #include "timer.h"
+#include "tracepoints.h" // generated from tracepoints.tp
 
 // common
 #include <debughelpers.h>
@@ -34,7 +37,9 @@
 #include <unity/shell/application/MirSurfaceInterface.h>
 
 // std
+#include <algorithm>
 #include <csignal>
+#include <iterator>
 
 namespace unityapp = unity::shell::application;
 
@@ -59,9 +64,14 @@ Application::Application(const QSharedPointer<SharedWakelock>& sharedWakelock,
     , m_stopTimer(nullptr)
     , m_exemptFromLifecycle(false)
     , m_proxyPromptSurfaceList(new ProxySurfaceListModel(this))
+    , m_timeSource(new RealTimeSource)
 {
     INFO_MSG << "()";
 
+    std::fill(std::begin(m_stateTimestamps), std::end(m_stateTimestamps), -1);
+    std::fill(std::begin(m_latencies), std::end(m_latencies), -1);
+    m_stateTimestamps[static_cast<int>(InternalState::Starting)] = m_timeSource->msecsSinceReference();
+
     // Because m_state is InternalState::Starting
     acquireWakelock();
 
@@ -69,9 +79,10 @@ Application::Application(const QSharedPointer<SharedWakelock>& sharedWakelock,
 
     m_rotatesWindowContents = m_appInfo->rotatesWindowContents();
 
-    setStopTimer(new Timer);
+    setStopTimer(new BatchedTimer);
 
     connect(&m_surfaceList, &unityapp::MirSurfaceListInterface::countChanged, this, &unityapp::ApplicationInfoInterface::surfaceCountChanged);
+    connect(&m_surfaceList, &QAbstractItemModel::rowsInserted, this, &Application::onSurfacesInserted);
 }
 
 Application::~Application()
@@ -316,6 +327,7 @@ void Application::applyClosing()
     case InternalState::Running:
     case InternalState::RunningInBackground:
         if (!m_stopTimer->isRunning()) {
+            m_stopRequested.start();
             m_stopTimer->start();
         }
         if (m_closing) {
@@ -548,6 +560,7 @@ void Application::setInternalState(Application::InternalState state)
     INFO_MSG << "(state=" << internalStateToStr(state) << ")";
 
     auto oldPublicState = this->state();
+    recordStateTimestamp(m_state, state);
     m_state = state;
 
     switch (m_state) {
@@ -577,6 +590,7 @@ void Application::setInternalState(Application::InternalState state)
             break;
     };
 
+    Q_EMIT internalStateChanged(m_state);
     if (this->state() != oldPublicState) {
         Q_EMIT stateChanged(this->state());
     }
@@ -694,9 +708,113 @@ void Application::stop()
 {
     INFO_MSG << "()";
 
+    if (m_stopRequested.isValid()) {
+        LifecycleScheduler::instance()->recordTransition(LifecycleScheduler::ApplicationStop,
+                                                         m_stopRequested.elapsed());
+        m_stopRequested.invalidate();
+    }
+
     Q_EMIT stopProcessRequested();
 }
 
+void Application::recordStateTimestamp(InternalState oldState, InternalState newState)
+{
+    const qint64 now = m_timeSource->msecsSinceReference();
+    m_stateTimestamps[static_cast<int>(newState)] = now;
+
+    switch (newState) {
+    case InternalState::Starting:
+        m_firstFrameTimestamp = -1;
+        m_awaitedFrame = AwaitedFrame::Launch;
+        break;
+    case InternalState::Running:
+        if (oldState == InternalState::SuspendingWaitSession
+                || oldState == InternalState::SuspendingWaitProcess
+                || oldState == InternalState::Suspended) {
+            m_awaitedFrame = AwaitedFrame::Resume;
+        }
+        break;
+    case InternalState::Suspended: {
+        // measured from asking the sessions to suspend, unless that went unrecorded (eg, new time source)
+        const qint64 suspendRequested = m_stateTimestamps[static_cast<int>(InternalState::SuspendingWaitSession)];
+        if (oldState == InternalState::SuspendingWaitProcess && suspendRequested >= 0) {
+            measureLatency(LifecycleMetrics::SuspendAcknowledgment, suspendRequested);
+        }
+        m_awaitedFrame = AwaitedFrame::None;
+        break;
+    }
+    default:
+        // won't be drawing anything the user waits for
+        m_awaitedFrame = AwaitedFrame::None;
+        break;
+    }
+}
+
+void Application::measureLatency(LifecycleMetrics::Metric metric, qint64 since)
+{
+    const qint64 ms = m_timeSource->msecsSinceReference() - since;
+    m_latencies[metric] = ms;
+
+    DEBUG_MSG << "(" << LifecycleMetrics::metricName(metric) << "=" << ms << "ms)";
+    tracepoint(qtmir, appLatency, appId().toLatin1().constData(), static_cast<int>(metric), ms);
+
+    Q_EMIT lifecycleLatencyMeasured(metric, ms);
+    Q_EMIT lifecycleLatenciesChanged();
+}
+
+void Application::onSurfacesInserted(const QModelIndex & /*parent*/, int first, int last)
+{
+    for (int row = first; row <= last; ++row) {
+        auto surface = static_cast<MirSurfaceInterface*>(m_surfaceList.get(row));
+        connect(surface, &MirSurfaceInterface::ready, this, &Application::onSurfaceReady, Qt::UniqueConnection);
+        connect(surface, &MirSurfaceInterface::framesPosted, this, &Application::onSurfaceFramesPosted,
+                Qt::UniqueConnection);
+        if (surface->isReady()) {
+            onSurfaceReady();
+        }
+    }
+}
+
+void Application::onSurfaceReady()
+{
+    if (m_awaitedFrame != AwaitedFrame::Launch) {
+        return;
+    }
+    m_awaitedFrame = AwaitedFrame::None;
+    m_firstFrameTimestamp = m_timeSource->msecsSinceReference();
+    measureLatency(LifecycleMetrics::LaunchToFirstFrame, m_stateTimestamps[static_cast<int>(InternalState::Starting)]);
+}
+
+void Application::onSurfaceFramesPosted()
+{
+    if (m_awaitedFrame != AwaitedFrame::Resume) {
+        return;
+    }
+    m_awaitedFrame = AwaitedFrame::None;
+    measureLatency(LifecycleMetrics::ResumeToFirstFrame, m_stateTimestamps[static_cast<int>(InternalState::Running)]);
+}
+
+QVariantMap Application::lifecycleLatencies() const
+{
+    QVariantMap result;
+    for (int metric = 0; metric < LifecycleMetrics::MetricCount; ++metric) {
+        if (m_latencies[metric] >= 0) {
+            result.insert(QString::fromLatin1(LifecycleMetrics::metricName(static_cast<LifecycleMetrics::Metric>(metric))),
+                          m_latencies[metric]);
+        }
+    }
+    return result;
+}
+
+void Application::setTimeSource(const SharedTimeSource &timeSource)
+{
+    m_timeSource = timeSource;
+
+    // Timestamps from the previous time source are meaningless now
+    std::fill(std::begin(m_stateTimestamps), std::end(m_stateTimestamps), -1);
+    m_stateTimestamps[static_cast<int>(m_state)] = m_timeSource->msecsSinceReference();
+}
+
 bool Application::isTouchApp() const
 {
     return m_appInfo->isTouchApp();
@@ -913,4 +1031,25 @@ QVector<SessionInterface*> Application::sessions() const
     return m_sessions;
 }
 
+namespace {
+void collectProcessIds(SessionInterface *session, QVector<pid_t> &pids)
+{
+    if (!pids.contains(session->pid())) {
+        pids.append(session->pid());
+    }
+    for (SessionInterface *child : session->childSessions()->list()) {
+        collectProcessIds(child, pids);
+    }
+}
+} // namespace {
+
+QVector<pid_t> Application::processIds() const
+{
+    QVector<pid_t> pids;
+    for (SessionInterface *session : m_sessions) {
+        collectProcessIds(session, pids);
+    }
+    return pids;
+}
+
 } // namespace qtmir
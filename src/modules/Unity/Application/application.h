@@ -29,8 +29,10 @@
 // Unity API
 #include <unity/shell/application/ApplicationInfoInterface.h>
 
+#include "lifecyclemetrics.h"
 #include "mirsurfacelistmodel.h"
 #include "session_interface.h"
+#include "timesource.h"
 
 namespace qtmir
 {
@@ -47,6 +49,9 @@ class Application : public unity::shell::application::ApplicationInfoInterface
 
     Q_PROPERTY(bool fullscreen READ fullscreen NOTIFY fullscreenChanged)
 
+    // Latest measurement of each LifecycleMetrics::Metric, in milliseconds, by metric name
+    Q_PROPERTY(QVariantMap lifecycleLatencies READ lifecycleLatencies NOTIFY lifecycleLatenciesChanged)
+
 public:
     Q_DECLARE_FLAGS(Stages, Stage)
 
@@ -116,6 +121,9 @@ public:
     void removeSession(SessionInterface *session);
     QVector<SessionInterface*> sessions() const;
 
+    // Processes of all sessions, child sessions included
+    QVector<pid_t> processIds() const;
+
     bool isValid() const;
     bool fullscreen() const;
 
@@ -128,11 +136,22 @@ public:
 
     void terminate();
 
+    // When the given state was last entered, or when the first frame of the latest launch got drawn,
+    // in milliseconds from the time source reference. -1 if it never happened.
+    qint64 stateTimestamp(InternalState state) const { return m_stateTimestamps[static_cast<int>(state)]; }
+    qint64 firstFrameTimestamp() const { return m_firstFrameTimestamp; }
+
+    QVariantMap lifecycleLatencies() const;
+
     // for tests
     void setStopTimer(AbstractTimer *timer);
     AbstractTimer *stopTimer() const { return m_stopTimer; }
+    void setTimeSource(const SharedTimeSource &timeSource);
 Q_SIGNALS:
     void fullscreenChanged(bool fullscreen);
+    void internalStateChanged(qtmir::Application::InternalState state);
+    void lifecycleLatencyMeasured(qtmir::LifecycleMetrics::Metric metric, qint64 ms);
+    void lifecycleLatenciesChanged();
 
     void startProcessRequested();
     void stopProcessRequested();
@@ -146,6 +165,10 @@ private Q_SLOTS:
 
     void respawn();
 
+    void onSurfacesInserted(const QModelIndex &parent, int first, int last);
+    void onSurfaceReady();
+    void onSurfaceFramesPosted();
+
 private:
 
     void acquireWakelock() const;
@@ -163,6 +186,8 @@ private:
     void applyClosing();
     void onSessionStopped();
     SessionInterface::State combinedSessionState();
+    void recordStateTimestamp(InternalState oldState, InternalState newState);
+    void measureLatency(LifecycleMetrics::Metric metric, qint64 since);
 
     QSharedPointer<SharedWakelock> m_sharedWakelock;
     QSharedPointer<ApplicationInfo> m_appInfo;
@@ -175,12 +200,21 @@ private:
     RequestedState m_requestedState;
     ProcessState m_processState;
     AbstractTimer *m_stopTimer;
+    QElapsedTimer m_stopRequested;
     bool m_exemptFromLifecycle;
     QSize m_initialSurfaceSize;
     bool m_closing{false};
 
     mutable MirSurfaceListModel m_surfaceList;
     ProxySurfaceListModel *m_proxyPromptSurfaceList;
+
+    // Lifecycle latency measurements
+    enum class AwaitedFrame { None, Launch, Resume };
+    SharedTimeSource m_timeSource;
+    qint64 m_stateTimestamps[static_cast<int>(InternalState::Stopped) + 1];
+    qint64 m_firstFrameTimestamp{-1};
+    AwaitedFrame m_awaitedFrame{AwaitedFrame::Launch};
+    qint64 m_latencies[LifecycleMetrics::MetricCount];
 };
 
 } // namespace qtmir
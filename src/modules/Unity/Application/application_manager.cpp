@@ -18,17 +18,21 @@
 #include "application_manager.h"
 #include "application.h"
 #include "applicationinfo.h"
+#include "cgroupfs.h"
 #include "dbusfocusinfo.h"
+#include "lifecyclescheduler.h"
 #include "mirsurfaceinterface.h"
 #include "session.h"
 #include "sharedwakelock.h"
 #include "proc_info.h"
 #include "upstart/taskcontroller.h"
+#include "timesource.h"
 #include "tracepoints.h" // generated from tracepoints.tp
 #include "settings.h"
 
 // mirserver
 #include "nativeinterface.h"
+#include "warmstartsessions.h"
 #include "logging.h"
 
 //miral
@@ -42,6 +46,9 @@
 #include <QDebug>
 #include <QByteArray>
 #include <QDir>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QTimer>
 
 // std
 #include <csignal>
@@ -53,6 +60,14 @@ namespace ms = mir::scene;
 
 namespace unityapi = unity::shell::application;
 
+namespace {
+// Leave the system alone for a while after a launch or an application going away
+const int warmStartRefillDelayMs = 10000;
+
+// Longer than it takes to switch between a couple of apps, so that doesn't toggle the wakelock
+const int wakelockReleaseDelayMs = 3000;
+}
+
 #define DEBUG_MSG qCDebug(QTMIR_APPLICATIONS).nospace() << "ApplicationManager::" << __func__
 
 namespace qtmir
@@ -72,6 +87,36 @@ QString toShortAppIdIfPossible(const QString &appId) {
     return appId;
 }
 
+// Past this, authorization warns about how long resolving a pid takes. It carries on regardless,
+// a slow task controller is no reason to reject a legitimate client.
+const int authorizationDeadlineMs = 1000;
+
+// Asks the task controller which processes an application runs, off the GUI thread
+class ProcessIdResolver : public QRunnable
+{
+public:
+    ProcessIdResolver(const QSharedPointer<TaskController> &taskController,
+                      const QSharedPointer<ProcessIdCache> &processIdCache,
+                      const QString &appId)
+        : m_taskController(taskController)
+        , m_processIdCache(processIdCache)
+        , m_appId(appId)
+        , m_generation(processIdCache->generation(appId))
+    {}
+
+    void run() override
+    {
+        // Dropped if the application stopped meanwhile
+        m_processIdCache->insert(m_appId, m_generation, m_taskController->processIds(m_appId));
+    }
+
+private:
+    const QSharedPointer<TaskController> m_taskController;
+    const QSharedPointer<ProcessIdCache> m_processIdCache;
+    const QString m_appId;
+    const quint64 m_generation;
+};
+
 } // namespace
 
 ApplicationManager* ApplicationManager::create()
@@ -89,7 +134,8 @@ ApplicationManager* ApplicationManager::create()
 
     QSharedPointer<TaskController> taskController(new upstart::TaskController());
     QSharedPointer<ProcInfo> procInfo(new ProcInfo());
-    QSharedPointer<SharedWakelock> sharedWakelock(new SharedWakelock);
+    QSharedPointer<SharedWakelock> sharedWakelock(new SharedWakelock(QDBusConnection::systemBus(),
+                                                                     wakelockReleaseDelayMs));
     QSharedPointer<Settings> settings(new Settings());
 
     // FIXME: We should use a QSharedPointer to wrap this ApplicationManager object, which requires us
@@ -104,6 +150,26 @@ ApplicationManager* ApplicationManager::create()
                                              settings
                                          );
 
+    appManager->memoryReclaimer()->watchPressure();
+
+    // One instance for all, so that the mounts are read and the cgroups watched only once
+    QSharedPointer<CGroupFs> cgroupFs(new CGroupFs);
+    if (cgroupFs->isAvailable()) {
+        appManager->enableCGroupFreezer(cgroupFs);
+        appManager->resourceSampler()->setCGroupFs(cgroupFs);
+        appManager->priorityPolicy()->setCGroupFs(cgroupFs);
+        appManager->dbusFocusInfo()->setCGroupFs(cgroupFs);
+    }
+
+    // Opt-in with QTMIR_PRIORITY_POLICY=1, as the task controller may be managing OOM scores already.
+    // With QTMIR_PRIORITY_POLICY_DRY_RUN=1 the OOM scores and CPU weights that would be given to
+    // applications are only logged
+    if (qgetenv("QTMIR_PRIORITY_POLICY_DRY_RUN") == "1") {
+        appManager->priorityPolicy()->setMode(PriorityPolicy::DryRun);
+    } else if (qgetenv("QTMIR_PRIORITY_POLICY") == "1") {
+        appManager->priorityPolicy()->setMode(PriorityPolicy::Enabled);
+    }
+
     // Emit signal to notify Upstart that Mir is ready to receive client connections
     // see http://upstart.ubuntu.com/cookbook/#expect-stop
     // FIXME: should not be qtmir's job, instead should notify the user of this library
@@ -133,11 +199,16 @@ ApplicationManager::ApplicationManager(
         const QSharedPointer<SettingsInterface>& settings,
         QObject *parent)
     : ApplicationManagerInterface(parent)
-    , m_dbusFocusInfo(new DBusFocusInfo(m_applications))
+    , m_dbusFocusInfo(new DBusFocusInfo)
     , m_taskController(taskController)
     , m_procInfo(procInfo)
     , m_sharedWakelock(sharedWakelock)
     , m_settings(settings)
+    , m_processIdCache(new ProcessIdCache)
+    , m_memoryReclaimer(new MemoryReclaimer(procInfo, SharedTimeSource(new RealTimeSource), this))
+    , m_resourceSampler(new ResourceSampler(procInfo, this))
+    , m_priorityPolicy(new PriorityPolicy(QStringLiteral("/proc"), this))
+    , m_warmStartTimer(new QTimer(this))
     , m_mutex(QMutex::Recursive) // Needs to be recursive since e.g. beginInsertRows will call rowCount
 {
     qCDebug(QTMIR_APPLICATIONS) << "ApplicationManager::ApplicationManager (this=%p)" << this;
@@ -145,6 +216,8 @@ ApplicationManager::ApplicationManager(
 
     QObject::connect(m_taskController.data(), &TaskController::processStarting,
                      this, &ApplicationManager::onProcessStarting);
+    QObject::connect(m_taskController.data(), &TaskController::applicationStarted,
+                     this, &ApplicationManager::onApplicationStarted);
     QObject::connect(m_taskController.data(), &TaskController::processStopped,
                      this, &ApplicationManager::onProcessStopped);
     QObject::connect(m_taskController.data(), &TaskController::processSuspended,
@@ -161,6 +234,17 @@ ApplicationManager::ApplicationManager(
                      this, &ApplicationManager::onSessionStarting);
 
     connect(this, &ApplicationManager::queuedAddApp, this, &ApplicationManager::addApp);
+    connect(m_memoryReclaimer, &MemoryReclaimer::reclaimRequested, this, &ApplicationManager::onReclaimRequested);
+    connect(m_resourceSampler, &ResourceSampler::usageChanged, this, &ApplicationManager::onResourceUsageChanged);
+
+    m_warmStartTimer->setSingleShot(true);
+    m_warmStartTimer->setInterval(warmStartRefillDelayMs);
+    connect(m_warmStartTimer, &QTimer::timeout, this, &ApplicationManager::refillWarmStartPool);
+
+    onSettingsChanged(QStringLiteral("warmStartPoolSize"));
+    onSettingsChanged(QStringLiteral("warmStartMemoryBudget"));
+    onSettingsChanged(QStringLiteral("resourceSamplingInterval"));
+    connect(m_settings.data(), &SettingsInterface::changed, this, &ApplicationManager::onSettingsChanged);
 }
 
 ApplicationManager::~ApplicationManager()
@@ -169,6 +253,13 @@ ApplicationManager::~ApplicationManager()
     delete m_dbusFocusInfo;
 }
 
+QHash<int, QByteArray> ApplicationManager::roleNames() const
+{
+    QHash<int, QByteArray> roleNames = ApplicationManagerInterface::roleNames();
+    roleNames.insert(RoleResourceUsage, "resourceUsage");
+    return roleNames;
+}
+
 int ApplicationManager::rowCount(const QModelIndex &parent) const
 {
     QMutexLocker locker(&m_mutex);
@@ -199,6 +290,8 @@ QVariant ApplicationManager::data(const QModelIndex &index, int role) const
                 return QVariant::fromValue(application->exemptFromLifecycle());
             case RoleApplication:
                 return QVariant::fromValue(application);
+            case RoleResourceUsage:
+                return m_resourceSampler->usage(application->appId()).toVariantMap();
             default:
                 return QVariant();
         }
@@ -226,14 +319,7 @@ Application* ApplicationManager::findApplicationMutexHeld(const QString &inputAp
 {
     // We don't really need this function since the mutex is recursive but is a bit
     // better if we just lock the mutex recursively when really need it
-    const QString appId = toShortAppIdIfPossible(inputAppId);
-
-    for (Application *app : m_applications) {
-        if (app->appId() == appId) {
-            return app;
-        }
-    }
-    return nullptr;
+    return m_applicationsByAppId.value(toShortAppIdIfPossible(inputAppId));
 }
 
 bool ApplicationManager::requestFocusApplication(const QString &inputAppId)
@@ -296,6 +382,28 @@ Application* ApplicationManager::startApplication(const QString &inputAppId,
         return nullptr;
     }
 
+    m_warmStartPool.recordLaunch(appId);
+    scheduleWarmStartRefill();
+
+    application = findWarmApplication(appId);
+    if (application && !m_queuedStartApplications.contains(inputAppId)) {
+        if (arguments.isEmpty()) {
+            qCDebug(QTMIR_APPLICATIONS) << "ApplicationManager::startApplication - resuming pre-started" << appId;
+            trackLaunch(application, true);
+            promoteWarmApplication(application);
+            return application;
+        }
+
+        // A pre-started instance can't be handed arguments, so replace it
+        m_queuedStartApplications.append(inputAppId);
+        connect(application, &QObject::destroyed, this, [this, inputAppId, arguments]() {
+            m_queuedStartApplications.removeAll(inputAppId);
+            startApplication(inputAppId, arguments);
+        }, Qt::QueuedConnection);
+        dropWarmApplication(application);
+        return nullptr;
+    }
+
     if (m_queuedStartApplications.contains(inputAppId)) {
         qWarning() << "ApplicationManager::startApplication - application appId=" << appId << " is queued to start";
         return nullptr;
@@ -337,6 +445,7 @@ Application* ApplicationManager::startApplication(const QString &inputAppId,
 
         add(application);
     }
+    trackLaunch(application, false);
     return application;
 }
 
@@ -347,7 +456,13 @@ void ApplicationManager::onProcessStarting(const QString &appId)
     tracepoint(qtmir, onProcessStarting);
     qCDebug(QTMIR_APPLICATIONS) << "ApplicationManager::onProcessStarting - appId=" << appId;
 
-    Application *application = findApplicationMutexHeld(appId);
+    Application *application = findWarmApplication(appId);
+    if (application) {
+        application->setProcessState(Application::ProcessRunning);
+        return;
+    }
+
+    application = findApplicationMutexHeld(appId);
     if (!application) { // then shell did not start this application, so ubuntu-app-launch must have - add to list
         auto appInfo = m_taskController->getInfoForApp(appId);
         if (!appInfo) {
@@ -408,6 +523,335 @@ void ApplicationManager::onApplicationClosing(Application *application)
     m_closingApplications.append(application);
 }
 
+WarmStartPool::Stats ApplicationManager::warmStartStats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_warmStartPool.stats();
+}
+
+LifecycleMetrics ApplicationManager::lifecycleMetrics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lifecycleMetrics;
+}
+
+QString ApplicationManager::dumpLifecycleMetrics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lifecycleMetrics.dump();
+}
+
+void ApplicationManager::enableCGroupFreezer(const QSharedPointer<CGroupFs> &cgroupFs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cgroupFs = cgroupFs;
+}
+
+void ApplicationManager::suspendProcess(const QString &appId)
+{
+    m_suspendRequested[appId].start();
+
+    if (!m_cgroupFs) {
+        m_taskController->suspend(appId);
+        return;
+    }
+
+    // Applications sent to the background together get frozen together, once control returns
+    // to the event loop.
+    if (m_pendingSuspends.isEmpty()) {
+        QMetaObject::invokeMethod(this, "suspendPendingProcesses", Qt::QueuedConnection);
+    }
+    if (!m_pendingSuspends.contains(appId)) {
+        m_pendingSuspends.append(appId);
+    }
+}
+
+void ApplicationManager::suspendPendingProcesses()
+{
+    QMutexLocker locker(&m_mutex);
+
+    const QStringList appIds = m_pendingSuspends;
+    m_pendingSuspends.clear();
+
+    qCDebug(QTMIR_APPLICATIONS) << "ApplicationManager::suspendPendingProcesses - appIds=" << appIds;
+
+    for (const QString &appId : appIds) {
+        Application *application = findApplicationMutexHeld(appId);
+        if (!application) {
+            application = findWarmApplication(appId);
+        }
+        if (!application || application->internalState() != Application::InternalState::SuspendingWaitProcess) {
+            continue;
+        }
+
+        if (freezeProcess(application)) {
+            onProcessSuspended(appId);
+        } else {
+            m_taskController->suspend(appId);
+        }
+    }
+}
+
+void ApplicationManager::resumeProcess(const QString &appId)
+{
+    m_suspendRequested.remove(appId);
+
+    if (m_pendingSuspends.removeAll(appId) > 0) {
+        // never got suspended in the first place
+        return;
+    }
+
+    if (!thawProcess(appId)) {
+        m_taskController->resume(appId);
+    }
+}
+
+bool ApplicationManager::freezeProcess(Application *application)
+{
+    const auto sessions = application->sessions();
+    if (sessions.isEmpty()) {
+        return false;
+    }
+
+    // Only freeze cgroups the application has to itself, not the shell's or someone else's
+    const QString cgroup = m_cgroupFs->cgroupOfPid(QStringLiteral("freezer"), sessions.first()->pid());
+    if (cgroup.isEmpty() || !CGroupFs::isApplicationCGroup(cgroup)) {
+        return false;
+    }
+
+    if (!m_cgroupFs->setFrozen(cgroup, true)) {
+        return false;
+    }
+
+    qCDebug(QTMIR_APPLICATIONS) << "ApplicationManager::freezeProcess - froze" << cgroup
+                                << "of" << application->appId();
+    m_frozenCGroups.insert(application->appId(), cgroup);
+    return true;
+}
+
+bool ApplicationManager::thawProcess(const QString &appId)
+{
+    const QString cgroup = m_frozenCGroups.take(appId);
+    if (cgroup.isNull()) {
+        return false;
+    }
+
+    if (!m_cgroupFs->setFrozen(cgroup, false)) {
+        qCWarning(QTMIR_APPLICATIONS) << "ApplicationManager::thawProcess - failed to thaw" << cgroup
+                                      << "of" << appId;
+        return false;
+    }
+    return true;
+}
+
+void ApplicationManager::onSettingsChanged(const QString &key)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (key == QLatin1String("resourceSamplingInterval")) {
+        m_resourceSampler->setInterval(m_settings->get(key).toInt());
+        return;
+    }
+
+    if (key == QLatin1String("warmStartPoolSize")) {
+        m_warmStartPool.setCapacity(m_settings->get(key).toInt());
+    } else if (key == QLatin1String("warmStartMemoryBudget")) {
+        m_warmStartPool.setMemoryBudget(m_settings->get(key).toLongLong() * 1024 * 1024); // in MiB
+    } else {
+        return;
+    }
+    scheduleWarmStartRefill();
+}
+
+void ApplicationManager::scheduleWarmStartRefill()
+{
+    if (m_warmStartPool.isEnabled() || !m_warmApplications.isEmpty()) {
+        m_warmStartTimer->start(); // restarts it if already running
+    }
+}
+
+void ApplicationManager::refillWarmStartPool()
+{
+    QMutexLocker locker(&m_mutex);
+
+    QSet<QString> inUse;
+    for (Application *application : m_applications) {
+        inUse.insert(application->appId());
+    }
+    for (Application *application : m_closingApplications) {
+        inUse.insert(application->appId());
+    }
+    for (const QString &appId : m_queuedStartApplications) {
+        inUse.insert(toShortAppIdIfPossible(appId));
+    }
+
+    const QStringList wanted = m_warmStartPool.candidates(inUse);
+
+    const QList<Application*> warmApplications = m_warmApplications;
+    for (Application *application : warmApplications) {
+        if (!wanted.contains(application->appId())) {
+            dropWarmApplication(application);
+        }
+    }
+
+    for (const QString &appId : wanted) {
+        if (!findWarmApplication(appId)) {
+            prewarmApplication(appId);
+        }
+    }
+}
+
+Application *ApplicationManager::findWarmApplication(const QString &appId) const
+{
+    for (Application *application : m_warmApplications) {
+        if (application->appId() == appId) {
+            return application;
+        }
+    }
+    return nullptr;
+}
+
+void ApplicationManager::prewarmApplication(const QString &appId)
+{
+    auto appInfo = m_taskController->getInfoForApp(appId);
+    if (!appInfo) {
+        return;
+    }
+
+    qCDebug(QTMIR_APPLICATIONS) << "ApplicationManager::prewarmApplication - appId=" << appId;
+
+    Application *application = new Application(m_sharedWakelock, appInfo, QStringList(), this);
+    // It gets suspended as soon as it's up and running
+    application->setRequestedState(Application::RequestedSuspended);
+
+    // Only what's needed to get it suspended or stopped. add() takes over once it gets launched.
+    QVector<QMetaObject::Connection> &connections = m_warmConnections[application];
+    connections << connect(application, &Application::suspendProcessRequested, this, [=]() { suspendProcess(appId); });
+    connections << connect(application, &Application::resumeProcessRequested, this, [=]() { resumeProcess(appId); });
+    connections << connect(application, &Application::stopProcessRequested, this, [=]() { m_taskController->stop(appId); });
+    connections << connect(application, &Application::stopped, this, [=]() { forgetWarmApplication(application); });
+    connections << connect(application, &Application::stateChanged, this, [=](Application::State state) {
+        if (state == Application::Suspended) {
+            measureMemory(application);
+        }
+    });
+
+    m_warmApplications.append(application);
+    m_memoryReclaimer->addApplication(application, true /* expendable */);
+
+    if (!m_taskController->start(appId, QStringList())) {
+        qCWarning(QTMIR_APPLICATIONS) << "ApplicationManager::prewarmApplication - failed to start" << appId;
+        m_memoryReclaimer->removeApplication(application);
+        m_warmApplications.removeAll(application);
+        m_warmConnections.remove(application);
+        delete application;
+    }
+}
+
+void ApplicationManager::promoteWarmApplication(Application *application)
+{
+    m_warmApplications.removeAll(application);
+    m_memoryReclaimer->removeApplication(application);
+    // Only the pre-start connections, the launch is being tracked already
+    for (const QMetaObject::Connection &connection : m_warmConnections.take(application)) {
+        disconnect(connection);
+    }
+
+    for (SessionInterface *session : application->sessions()) {
+        WarmStartSessions::remove(session->pid());
+    }
+
+    add(application);
+
+    auto surfaces = application->surfaceList();
+    for (int i = 0; i < surfaces->count(); ++i) {
+        auto surface = surfaces->get(i);
+        if (surface->state() == Mir::HiddenState) {
+            surface->requestState(Mir::RestoredState);
+        }
+    }
+
+    application->setRequestedState(Application::RequestedRunning);
+    application->requestFocus();
+}
+
+void ApplicationManager::dropWarmApplication(Application *application)
+{
+    qCDebug(QTMIR_APPLICATIONS) << "ApplicationManager::dropWarmApplication - appId=" << application->appId();
+
+    // Stays warm until its process is gone, then forgetWarmApplication() cleans up
+    if (!m_taskController->stop(application->appId())) {
+        application->terminate();
+        forgetWarmApplication(application);
+    }
+}
+
+void ApplicationManager::forgetWarmApplication(Application *application)
+{
+    if (!m_warmApplications.removeAll(application)) {
+        return;
+    }
+
+    m_memoryReclaimer->removeApplication(application);
+    m_warmConnections.remove(application);
+    for (SessionInterface *session : application->sessions()) {
+        WarmStartSessions::remove(session->pid());
+    }
+    application->deleteLater();
+}
+
+void ApplicationManager::trackLaunch(Application *application, bool warm)
+{
+    // How long it takes from the launch request until it's running
+    QElapsedTimer launchTimer;
+    launchTimer.start();
+    const QString appId = application->appId();
+    auto connection = QSharedPointer<QMetaObject::Connection>::create();
+    *connection = connect(application, &Application::stateChanged, this,
+                          [this, appId, launchTimer, warm, connection](Application::State state) {
+        if (state != Application::Running) {
+            return;
+        }
+        disconnect(*connection);
+
+        QMutexLocker locker(&m_mutex);
+        if (warm) {
+            m_warmStartPool.recordWarmStart(appId, launchTimer.elapsed());
+        } else {
+            m_warmStartPool.recordColdStart(appId, launchTimer.elapsed());
+        }
+    });
+}
+
+void ApplicationManager::measureMemory(Application *application)
+{
+    if (!m_warmStartPool.isEnabled()) {
+        return;
+    }
+
+    qint64 bytes = 0;
+    for (SessionInterface *session : application->sessions()) {
+        const ProcInfo::MemoryUsage usage = m_procInfo->memoryUsage(session->pid());
+        bytes += usage.pssBytes > 0 ? usage.pssBytes : usage.rssBytes;
+    }
+    m_warmStartPool.setMemoryEstimate(application->appId(), bytes);
+}
+
+void ApplicationManager::onReclaimRequested(Application *application)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Kill it the way the OOM killer would. The task controller then reports the process as failed,
+    // which leaves the application StoppedResumable, to be respawned once the user gets back to it.
+    for (SessionInterface *session : application->sessions()) {
+        qCDebug(QTMIR_APPLICATIONS) << "ApplicationManager::onReclaimRequested - killing pid" << session->pid()
+                                    << "of" << application->appId();
+        kill(session->pid(), SIGKILL);
+    }
+    // A frozen process only gets to die once thawed
+    thawProcess(application->appId());
+}
+
 void ApplicationManager::onProcessFailed(const QString &appId, TaskController::Error error)
 {
     QMutexLocker locker(&m_mutex);
@@ -415,7 +859,18 @@ void ApplicationManager::onProcessFailed(const QString &appId, TaskController::E
 
     qCDebug(QTMIR_APPLICATIONS) << "ApplicationManager::onProcessFailed - appId=" << appId;
 
-    Application *application = findApplicationMutexHeld(appId);
+    m_processIdCache->removeApp(appId);
+    m_pendingSuspends.removeAll(appId);
+    m_suspendRequested.remove(appId);
+    thawProcess(appId); // its cgroup might get reused by the next instance
+
+    Application *application = findWarmApplication(appId);
+    if (application) {
+        forgetWarmApplication(application);
+        return;
+    }
+
+    application = findApplicationMutexHeld(appId);
     if (!application) {
         qWarning() << "ApplicationManager::onProcessFailed - upstart reports failure of application" << appId
                    << "that AppManager is not managing";
@@ -426,6 +881,12 @@ void ApplicationManager::onProcessFailed(const QString &appId, TaskController::E
     application->setProcessState(Application::ProcessFailed);
 }
 
+void ApplicationManager::onApplicationStarted(const QString &appId)
+{
+    // Resolve the processes of the application now, so that authorizing its connection is a lookup
+    QThreadPool::globalInstance()->start(new ProcessIdResolver(m_taskController, m_processIdCache, appId));
+}
+
 void ApplicationManager::onProcessStopped(const QString &appId)
 {
     QMutexLocker locker(&m_mutex);
@@ -433,7 +894,19 @@ void ApplicationManager::onProcessStopped(const QString &appId)
     tracepoint(qtmir, onProcessStopped);
     qCDebug(QTMIR_APPLICATIONS) << "ApplicationManager::onProcessStopped - appId=" << appId;
 
-    Application *application = findApplicationMutexHeld(appId);
+    m_processIdCache->removeApp(appId);
+    m_pendingSuspends.removeAll(appId);
+    m_suspendRequested.remove(appId);
+    thawProcess(appId); // its cgroup might get reused by the next instance
+    scheduleWarmStartRefill();
+
+    Application *application = findWarmApplication(appId);
+    if (application) {
+        forgetWarmApplication(application);
+        return;
+    }
+
+    application = findApplicationMutexHeld(appId);
     if (!application) {
         application = findClosingApplication(appId);
     }
@@ -458,6 +931,9 @@ void ApplicationManager::onProcessSuspended(const QString &appId)
     qCDebug(QTMIR_APPLICATIONS) << "ApplicationManager::onProcessSuspended - appId=" << appId;
 
     Application *application = findApplicationMutexHeld(appId);
+    if (!application) {
+        application = findWarmApplication(appId);
+    }
 
     if (!application) {
         qDebug() << "ApplicationManager::onProcessSuspended reports stop of appId=" << appId
@@ -465,6 +941,13 @@ void ApplicationManager::onProcessSuspended(const QString &appId)
         return;
     }
 
+    auto requested = m_suspendRequested.find(appId);
+    if (requested != m_suspendRequested.end()) {
+        LifecycleScheduler::instance()->recordTransition(LifecycleScheduler::ProcessSuspend,
+                                                         requested.value().elapsed());
+        m_suspendRequested.erase(requested);
+    }
+
     application->setProcessState(Application::ProcessSuspended);
 }
 
@@ -498,41 +981,131 @@ void ApplicationManager::onResumeRequested(const QString& appId)
     }
 }
 
-void ApplicationManager::onAppDataChanged(const int role)
+void ApplicationManager::onAppDataChanged(Application *application, int role)
+{
+    // Applications often change several roles at once, eg. state and focus when brought to front.
+    // Those get merged into a single dataChanged per row, emitted once control returns to the event loop.
+    QVector<int> &roles = m_pendingDataChanges[application];
+    if (!roles.contains(role)) {
+        roles.append(role);
+    }
+
+    if (!m_dataChangesFlushScheduled) {
+        m_dataChangesFlushScheduled = true;
+        QMetaObject::invokeMethod(this, "flushDataChanges", Qt::QueuedConnection);
+    }
+}
+
+void ApplicationManager::flushDataChanges()
 {
     QMutexLocker locker(&m_mutex);
-    if (sender()) {
-        Application *application = static_cast<Application*>(sender());
-        QModelIndex appIndex = findIndex(application);
-        Q_EMIT dataChanged(appIndex, appIndex, QVector<int>() << role);
+    m_dataChangesFlushScheduled = false;
+
+    const auto pending = m_pendingDataChanges;
+    m_pendingDataChanges.clear();
+
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        QModelIndex appIndex = findIndex(it.key());
+        if (appIndex.isValid()) {
+            Q_EMIT dataChanged(appIndex, appIndex, it.value());
+        }
+    }
+}
+
+void ApplicationManager::onResourceUsageChanged(const QStringList &appIds)
+{
+    QMutexLocker locker(&m_mutex);
+
+    for (const QString &appId : appIds) {
+        if (Application *application = m_applicationsByAppId.value(appId)) {
+            onAppDataChanged(application, RoleResourceUsage);
+        }
     }
 }
 
 void ApplicationManager::authorizeSession(const pid_t pid, bool &authorized)
 {
     // This is the only function that is called from a different thread than the one
-    // in which the object lives, that's why we use queuedAddApp
-
-    QMutexLocker locker(&m_mutex);
+    // in which the object lives, that's why we use queuedAddApp.
+    // As it blocks the connection of the client, the mutex is only held while touching our own state.
 
     tracepoint(qtmir, authorizeSession);
-    authorized = false; //to be proven wrong
+    QElapsedTimer authorizationTimer;
+    authorizationTimer.start();
 
     qCDebug(QTMIR_APPLICATIONS) << "ApplicationManager::authorizeSession - pid=" << pid;
 
-    Q_FOREACH (Application *app, m_applications) {
-        if (app->state() == Application::Starting) {
+    authorized = authorizeStartingApplication(pid, authorizationTimer)
+              || authorizeUnmanagedProcess(pid);
+
+    tracepoint(qtmir, authorizeSession_end, pid, authorized, authorizationTimer.nsecsElapsed() / 1000);
+}
+
+bool ApplicationManager::authorizeStartingApplication(const pid_t pid, const QElapsedTimer &authorizationTimer)
+{
+    QStringList startingAppIds;
+    {
+        QMutexLocker locker(&m_mutex);
+        Q_FOREACH (Application *app, m_applications) {
+            if (app->state() == Application::Starting) {
+                startingAppIds.append(app->appId());
+            }
+        }
+        Q_FOREACH (Application *app, m_warmApplications) {
+            if (app->state() == Application::Starting) {
+                startingAppIds.append(app->appId());
+            }
+        }
+    }
+
+    if (startingAppIds.isEmpty()) {
+        return false;
+    }
+
+    QString appId = m_processIdCache->appIdFor(pid);
+    if (!appId.isNull() && !startingAppIds.contains(appId)) {
+        // A leftover of an application which is no longer starting. The pid might have been recycled
+        // by one which is, so ask the task controller.
+        appId = QString();
+    }
+
+    if (appId.isNull()) {
+        bool deadlineMissed = false;
+        Q_FOREACH (const QString &startingAppId, startingAppIds) {
+            if (!deadlineMissed && authorizationTimer.elapsed() > authorizationDeadlineMs) {
+                deadlineMissed = true;
+                qCWarning(QTMIR_APPLICATIONS) << "ApplicationManager::authorizeSession - still resolving pid" << pid
+                                              << "after" << authorizationTimer.elapsed() << "ms";
+                tracepoint(qtmir, authorizeSession_deadlineMissed, pid);
+            }
+
             tracepoint(qtmir, appIdHasProcessId_start);
-            if (m_taskController->appIdHasProcessId(app->appId(), pid)) {
-                authorized = true;
-                m_authorizedPids.insertMulti(pid, app->appId());
+            const quint64 generation = m_processIdCache->generation(startingAppId);
+            if (m_taskController->appIdHasProcessId(startingAppId, pid)) {
                 tracepoint(qtmir, appIdHasProcessId_end, 1); //found
-                return;
+                appId = startingAppId;
+                m_processIdCache->insert(appId, generation, pid);
+                break;
             }
             tracepoint(qtmir, appIdHasProcessId_end, 0); // not found
         }
+
+        if (appId.isNull()) {
+            return false;
+        }
     }
 
+    QMutexLocker locker(&m_mutex);
+    m_authorizedPids.insertMulti(pid, appId);
+    if (findWarmApplication(appId)) {
+        // before it gets the chance to create any window
+        WarmStartSessions::add(pid);
+    }
+    return true;
+}
+
+bool ApplicationManager::authorizeUnmanagedProcess(const pid_t pid)
+{
     /*
      * Hack: Allow applications to be launched without being managed by upstart, where AppManager
      * itself manages processes executed with a "--desktop_file_hint=/path/to/desktopFile.desktop"
@@ -543,12 +1116,11 @@ void ApplicationManager::authorizeSession(const pid_t pid, bool &authorized)
     if (!info) {
         qWarning() << "ApplicationManager REJECTED connection from app with pid" << pid
                    << "as unable to read the process command line";
-        return;
+        return false;
     }
 
     if (info->startsWith("maliit-server") || info->contains("qt5/libexec/QtWebProcess")) {
-        authorized = true;
-        return;
+        return true;
     }
 
     QString desktopFileName = info->getParameter("--desktop_file_hint=");
@@ -558,7 +1130,7 @@ void ApplicationManager::authorizeSession(const pid_t pid, bool &authorized)
         if (!environment->contains("DESKTOP_FILE_HINT")) {
             qCritical() << "ApplicationManager REJECTED connection from app with pid" << pid
                         << "as it was not launched by upstart, and no desktop_file_hint is specified";
-            return;
+            return false;
         }
         desktopFileName = environment->getParameter("DESKTOP_FILE_HINT");
     }
@@ -572,24 +1144,25 @@ void ApplicationManager::authorizeSession(const pid_t pid, bool &authorized)
     if (!appInfo) {
         qCritical() << "ApplicationManager REJECTED connection from app with pid" << pid
                     << "as the app specified by the desktop_file_hint argument could not be found";
-        return;
+        return false;
     }
 
+    QMutexLocker locker(&m_mutex);
+
     // some naughty applications use a script to launch the actual application. Check for the
     // case where shell actually launched the script.
     Application *application = findApplicationMutexHeld(appInfo->appId());
     if (application) {
         qCDebug(QTMIR_APPLICATIONS) << "Process with pid" << pid << "appeared, attaching to existing entry"
                                     << "in application list with appId:" << application->appId();
-        authorized = true;
         m_authorizedPids.insertMulti(pid, appInfo->appId());
-        return;
+        return true;
     }
 
     const QStringList arguments(info->asStringList());
     queuedAddApp(appInfo, arguments, pid);
-    authorized = true;
     m_authorizedPids.insertMulti(pid, appInfo->appId());
+    return true;
 }
 
 
@@ -609,17 +1182,34 @@ Application* ApplicationManager::findApplicationWithSession(const std::shared_pt
     if (!session)
         return nullptr;
 
-    for (auto *application : m_applications) {
-        for (auto *qmlSession : application->sessions()) {
-            if (qmlSession->session() == session) {
-                return application;
-            }
-        }
+    Application *application = m_applicationsBySession.value(session.get());
+    if (!application) {
+        return nullptr;
     }
 
+    // The index entry may be left over from a session which has since gone and whose address got reused
+    for (auto *qmlSession : application->sessions()) {
+        if (qmlSession->session() == session) {
+            return application;
+        }
+    }
     return nullptr;
 }
 
+void ApplicationManager::indexSession(Application *application, SessionInterface *session)
+{
+    const mir::scene::Session *key = session->session().get();
+    m_applicationsBySession.insert(key, application);
+
+    connect(session, &QObject::destroyed, this, [this, key, application]() {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_applicationsBySession.find(key);
+        if (it != m_applicationsBySession.end() && it.value() == application) {
+            m_applicationsBySession.erase(it);
+        }
+    });
+}
+
 void ApplicationManager::addApp(const QSharedPointer<qtmir::ApplicationInfo> &appInfo, const QStringList &arguments, const pid_t pid)
 {
     QMutexLocker locker(&m_mutex);
@@ -639,7 +1229,7 @@ void ApplicationManager::add(Application* application)
 {
     Q_ASSERT(application != nullptr);
 
-    if (m_applications.indexOf(application) != -1) {
+    if (m_rows.contains(application)) {
         DEBUG_MSG << "(appId=" << application->appId() << ") - already exists";
         return;
     }
@@ -661,12 +1251,17 @@ void ApplicationManager::add(Application* application)
         getting removed from the model.
      */
     // TODO: That might not be the case anymore with miral. Investigate if we can do a direct connection now
-    connect(application, &Application::focusedChanged, this, [this](bool) {
-        onAppDataChanged(RoleFocused);
+    connect(application, &Application::focusedChanged, this, [this, application](bool) {
+        onAppDataChanged(application, RoleFocused);
         Q_EMIT focusedApplicationIdChanged();
     }, Qt::QueuedConnection);
 
-    connect(application, &Application::stateChanged, this, [this](Application::State) { onAppDataChanged(RoleState); });
+    connect(application, &Application::stateChanged, this, [this, application](Application::State state) {
+        onAppDataChanged(application, RoleState);
+        if (state == Application::Suspended) {
+            measureMemory(application);
+        }
+    });
     connect(application, &Application::closing, this, [this, application]() { onApplicationClosing(application); });
     connect(application, &unityapi::ApplicationInfoInterface::focusRequested, this, [this, application]() {
         Q_EMIT focusRequested(application->appId());
@@ -693,16 +1288,31 @@ void ApplicationManager::add(Application* application)
         }
     });
 
-    connect(application, &Application::suspendProcessRequested, this, [=]() { m_taskController->suspend(appId); } );
-    connect(application, &Application::resumeProcessRequested, this, [=]() { m_taskController->resume(appId); } );
+    connect(application, &Application::suspendProcessRequested, this, [=]() { suspendProcess(appId); } );
+    connect(application, &Application::resumeProcessRequested, this, [=]() { resumeProcess(appId); } );
+
+    connect(application, &Application::lifecycleLatencyMeasured, this,
+            [=](LifecycleMetrics::Metric metric, qint64 ms) {
+        QMutexLocker locker(&m_mutex);
+        m_lifecycleMetrics.record(appId, metric, ms);
+    });
 
     connect(application, &Application::stopped, this, [=]() {
         remove(application);
         application->deleteLater();
     });
 
+    m_memoryReclaimer->addApplication(application);
+    m_resourceSampler->addApplication(application);
+    m_priorityPolicy->addApplication(application);
+
     beginInsertRows(QModelIndex(), m_applications.count(), m_applications.count());
+    m_rows.insert(application, m_applications.count());
     m_applications.append(application);
+    m_applicationsByAppId.insert(application->appId(), application);
+    for (SessionInterface *session : application->sessions()) {
+        indexSession(application, session);
+    }
     endInsertRows();
     Q_EMIT countChanged();
 
@@ -715,7 +1325,7 @@ void ApplicationManager::remove(Application *application)
 {
     Q_ASSERT(application != nullptr);
 
-    int index = m_applications.indexOf(application);
+    int index = m_rows.value(application, -1);
     if (index == -1) {
         DEBUG_MSG << "(appId=" << application->appId() << ") - not found";
         return;
@@ -728,6 +1338,17 @@ void ApplicationManager::remove(Application *application)
 
     beginRemoveRows(QModelIndex(), index, index);
     m_applications.removeAt(index);
+    m_rows.remove(application);
+    for (int row = index; row < m_applications.count(); ++row) {
+        m_rows.insert(m_applications.at(row), row);
+    }
+    if (m_applicationsByAppId.value(application->appId()) == application) {
+        m_applicationsByAppId.remove(application->appId());
+    }
+    for (SessionInterface *session : application->sessions()) {
+        m_applicationsBySession.remove(session->session().get());
+    }
+    m_pendingDataChanges.remove(application);
     endRemoveRows();
     Q_EMIT countChanged();
 
@@ -737,6 +1358,10 @@ void ApplicationManager::remove(Application *application)
     disconnect(application, &Application::closing, this, 0);
     disconnect(application, &unityapi::ApplicationInfoInterface::focusRequested, this, 0);
 
+    m_memoryReclaimer->removeApplication(application);
+    m_resourceSampler->removeApplication(application);
+    m_priorityPolicy->removeApplication(application);
+
     // don't remove (as it's already being removed) but still delete the guy.
     disconnect(application, &Application::stopped, this, 0);
     connect(application, &Application::stopped, this, [application]() { application->deleteLater(); });
@@ -748,13 +1373,8 @@ void ApplicationManager::remove(Application *application)
 
 QModelIndex ApplicationManager::findIndex(Application* application)
 {
-    for (int i = 0; i < m_applications.size(); ++i) {
-        if (m_applications.at(i) == application) {
-            return index(i);
-        }
-    }
-
-    return QModelIndex();
+    const int row = m_rows.value(application, -1);
+    return row != -1 ? index(row) : QModelIndex();
 }
 
 QString ApplicationManager::toString() const
@@ -791,12 +1411,19 @@ void ApplicationManager::onSessionStarting(SessionInterface *qmlSession)
         if (iter != m_authorizedPids.end()) {
             QString appId = iter.value();
             application = findApplication(appId);
+            if (!application) {
+                application = findWarmApplication(appId);
+            }
             m_authorizedPids.erase(iter);
         }
     }
 
     if (application) {
         application->addSession(qmlSession);
+        if (m_rows.contains(application)) {
+            indexSession(application, qmlSession);
+        } // else it's a warm application, indexed once it's added to the model
+        m_dbusFocusInfo->registerSession(qmlSession);
     }
 }
 
@@ -21,17 +21,25 @@
 #include <memory>
 
 // Qt
+#include <QElapsedTimer>
 #include <QObject>
 #include <QStringList>
 
 // local
 #include "application.h"
+#include "memoryreclaimer.h"
+#include "prioritypolicy.h"
+#include "processidcache.h"
+#include "resourcesampler.h"
 #include "sessionmap_interface.h"
 #include "taskcontroller.h"
+#include "warmstartpool.h"
 
 // Unity API
 #include <unity/shell/application/ApplicationManagerInterface.h>
 
+class QTimer;
+
 namespace mir {
     namespace scene {
         class Session;
@@ -50,6 +58,7 @@ namespace unity {
 
 namespace qtmir {
 
+class CGroupFs;
 class DBusFocusInfo;
 class DBusWindowStack;
 class ProcInfo;
@@ -62,6 +71,11 @@ class ApplicationManager : public unity::shell::application::ApplicationManagerI
     Q_OBJECT
 
 public:
+    enum Roles {
+        // QVariantMap with the latest ResourceUsage of the application
+        RoleResourceUsage = Qt::UserRole + 100,
+    };
+
     static ApplicationManager* create();
     static ApplicationManager* singleton();
 
@@ -86,13 +100,29 @@ public:
     // QAbstractListModel
     int rowCount(const QModelIndex & parent = QModelIndex()) const override;
     QVariant data(const QModelIndex & index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
 
     SessionInterface *findSession(const mir::scene::Session* session) const override;
 
+    ProcessIdCache::Stats processIdCacheStats() const { return m_processIdCache->stats(); }
+    MemoryReclaimer *memoryReclaimer() const { return m_memoryReclaimer; }
+    WarmStartPool::Stats warmStartStats() const;
+    LifecycleMetrics lifecycleMetrics() const;
+    ResourceSampler *resourceSampler() const { return m_resourceSampler; }
+    PriorityPolicy *priorityPolicy() const { return m_priorityPolicy; }
+    DBusFocusInfo *dbusFocusInfo() const { return m_dbusFocusInfo; }
+
+    // Launch, resume and suspend latencies of every application seen so far, as text
+    Q_INVOKABLE QString dumpLifecycleMetrics() const;
+
+    // Suspends applications by freezing their cgroup, in batches, instead of asking the task controller
+    void enableCGroupFreezer(const QSharedPointer<CGroupFs> &cgroupFs);
+
 public Q_SLOTS:
     void authorizeSession(const pid_t pid, bool &authorized);
 
     void onProcessStarting(const QString& appId);
+    void onApplicationStarted(const QString& appId);
     void onProcessStopped(const QString& appId);
     void onProcessSuspended(const QString& appId);
     void onProcessFailed(const QString& appId, TaskController::Error error);
@@ -101,8 +131,13 @@ public Q_SLOTS:
     void onSessionStarting(SessionInterface *session);
 
 private Q_SLOTS:
-    void onAppDataChanged(const int role);
+    void flushDataChanges();
     void onApplicationClosing(Application *application);
+    void onReclaimRequested(Application *application);
+    void onResourceUsageChanged(const QStringList &appIds);
+    void onSettingsChanged(const QString &key);
+    void refillWarmStartPool();
+    void suspendPendingProcesses();
     void addApp(const QSharedPointer<qtmir::ApplicationInfo> &appInfo, const QStringList &arguments, const pid_t pid);
 
 Q_SIGNALS:
@@ -118,13 +153,40 @@ private:
     void remove(Application* application);
 
     QModelIndex findIndex(Application* application);
+    void onAppDataChanged(Application *application, int role);
+    void indexSession(Application *application, SessionInterface *session);
     void resumeApplication(Application *application);
     QString toString() const;
 
     Application* findApplicationWithPromptSession(const mir::scene::PromptSession* promptSession);
     Application *findClosingApplication(const QString &inputAppId) const;
 
+    Application *findWarmApplication(const QString &appId) const;
+    void prewarmApplication(const QString &appId);
+    void promoteWarmApplication(Application *application);
+    void dropWarmApplication(Application *application);
+    void forgetWarmApplication(Application *application);
+    void scheduleWarmStartRefill();
+    void trackLaunch(Application *application, bool warm);
+    void measureMemory(Application *application);
+
+    void suspendProcess(const QString &appId);
+    void resumeProcess(const QString &appId);
+    bool freezeProcess(Application *application);
+    bool thawProcess(const QString &appId);
+
+    // Called without the mutex held
+    bool authorizeStartingApplication(const pid_t pid, const QElapsedTimer &authorizationTimer);
+    bool authorizeUnmanagedProcess(const pid_t pid);
+
     QList<Application*> m_applications;
+    QHash<QString, Application*> m_applicationsByAppId; // by short appId
+    QHash<const mir::scene::Session*, Application*> m_applicationsBySession;
+    QHash<Application*, int> m_rows;
+
+    // Roles changed per application since the last dataChanged emission
+    QHash<Application*, QVector<int>> m_pendingDataChanges;
+    bool m_dataChangesFlushScheduled{false};
     DBusFocusInfo *m_dbusFocusInfo;
     QSharedPointer<TaskController> m_taskController;
     QSharedPointer<ProcInfo> m_procInfo;
@@ -136,6 +198,22 @@ private:
     static ApplicationManager* the_application_manager;
 
     QHash<pid_t, QString> m_authorizedPids;
+    QSharedPointer<ProcessIdCache> m_processIdCache;
+    MemoryReclaimer *m_memoryReclaimer;
+    LifecycleMetrics m_lifecycleMetrics;
+    ResourceSampler *m_resourceSampler;
+    PriorityPolicy *m_priorityPolicy;
+
+    // Pre-started applications, suspended and not part of the model until launched
+    WarmStartPool m_warmStartPool;
+    QList<Application*> m_warmApplications;
+    QHash<Application*, QVector<QMetaObject::Connection>> m_warmConnections; // undone once launched
+    QTimer *m_warmStartTimer;
+
+    QSharedPointer<CGroupFs> m_cgroupFs; // null unless the freezer is to be used
+    QStringList m_pendingSuspends;
+    QHash<QString, QString> m_frozenCGroups; // by appId
+    QHash<QString, QElapsedTimer> m_suspendRequested; // by appId
 
     mutable QMutex m_mutex;
 };
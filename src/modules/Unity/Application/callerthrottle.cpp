@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "callerthrottle.h"
+
+#include <QtGlobal>
+
+using namespace qtmir;
+
+const int CallerThrottle::basePenaltyMs = 50;
+const int CallerThrottle::maxPenaltyMs = 5000;
+const int CallerThrottle::penaltyResetMs = 10000;
+const int CallerThrottle::maxCallers = 256;
+
+CallerThrottle::CallerThrottle(const SharedTimeSource &timeSource, int burst, int queriesPerSecond)
+    : m_timeSource(timeSource)
+    , m_burst(burst)
+    , m_queriesPerSecond(queriesPerSecond)
+{
+}
+
+bool CallerThrottle::admit(const QString &caller)
+{
+    const qint64 now = m_timeSource->msecsSinceReference();
+
+    auto it = m_callers.find(caller);
+    if (it == m_callers.end()) {
+        if (m_callers.count() >= maxCallers) {
+            pruneIdleCallers(now);
+        }
+        it = m_callers.insert(caller, Caller{static_cast<double>(m_burst), now, 0, 0});
+    }
+
+    Caller &state = it.value();
+    state.tokens = qMin<double>(m_burst, state.tokens + (now - state.lastRefill) * m_queriesPerSecond / 1000.0);
+    state.lastRefill = now;
+
+    if (state.tokens < 1.0) {
+        ++m_stats.rejected;
+        return false;
+    }
+
+    state.tokens -= 1.0;
+    ++m_stats.admitted;
+    return true;
+}
+
+int CallerThrottle::recordLookup(const QString &caller, bool found)
+{
+    auto it = m_callers.find(caller);
+    if (it == m_callers.end()) {
+        return 0;
+    }
+
+    Caller &state = it.value();
+    const qint64 now = m_timeSource->msecsSinceReference();
+
+    if (found || (state.negativeStreak > 0 && now - state.lastNegative > penaltyResetMs)) {
+        state.negativeStreak = 0;
+    }
+
+    if (found) {
+        return 0;
+    }
+
+    state.lastNegative = now;
+    ++state.negativeStreak;
+    ++m_stats.penalized;
+
+    // 50, 100, 200, ... capped at maxPenaltyMs
+    const int shift = qMin(state.negativeStreak - 1, 16);
+    return qMin(basePenaltyMs << shift, maxPenaltyMs);
+}
+
+void CallerThrottle::pruneIdleCallers(qint64 now)
+{
+    // Forget callers whose budget is back to full and that aren't serving a penalty. Those are
+    // indistinguishable from newcomers anyway.
+    const qint64 refillMs = m_queriesPerSecond > 0 ? m_burst * 1000 / m_queriesPerSecond : 0;
+    for (auto it = m_callers.begin(); it != m_callers.end();) {
+        const Caller &state = it.value();
+        const bool refilled = now - state.lastRefill >= refillMs;
+        const bool penalized = state.negativeStreak > 0 && now - state.lastNegative <= penaltyResetMs;
+        if (refilled && !penalized) {
+            it = m_callers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
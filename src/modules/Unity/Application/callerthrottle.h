@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_CALLERTHROTTLE_H
+#define QTMIR_CALLERTHROTTLE_H
+
+#include <QHash>
+#include <QString>
+
+#include "timesource.h"
+
+namespace qtmir {
+
+/*
+  Per-caller budget for queries coming in over D-Bus.
+
+  Each caller gets a token bucket, so a burst of queries is fine but a sustained flood gets rejected.
+  On top of that, lookups of unknown ids are penalized: every consecutive one is held back for twice
+  as long as the previous one, so that brute-forcing valid ids is slow for the prober. Answers about
+  known ids, focused or not, are never held back and end the streak, so that well-behaved clients
+  polling focus aren't affected. A streak is also forgotten after a quiet period.
+ */
+class CallerThrottle
+{
+public:
+    explicit CallerThrottle(const SharedTimeSource &timeSource = SharedTimeSource(new RealTimeSource),
+                            int burst = 20, int queriesPerSecond = 10);
+
+    // Returns false if the caller has used up its budget and the query should be rejected
+    bool admit(const QString &caller);
+
+    // Records whether the id the caller asked about is known. Returns for how many milliseconds the
+    // answer should be held back.
+    int recordLookup(const QString &caller, bool found);
+
+    struct Stats {
+        quint64 admitted{0};
+        quint64 rejected{0};
+        quint64 penalized{0};
+    };
+    Stats stats() const { return m_stats; }
+
+    int callerCount() const { return m_callers.count(); }
+
+    static const int basePenaltyMs;
+    static const int maxPenaltyMs;
+    static const int penaltyResetMs;
+    static const int maxCallers;
+
+private:
+    struct Caller {
+        double tokens;
+        qint64 lastRefill;
+        qint64 lastNegative;
+        int negativeStreak;
+    };
+
+    void pruneIdleCallers(qint64 now);
+
+    SharedTimeSource m_timeSource;
+    const int m_burst;
+    const int m_queriesPerSecond;
+    QHash<QString, Caller> m_callers;
+    Stats m_stats;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_CALLERTHROTTLE_H
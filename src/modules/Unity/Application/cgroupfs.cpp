@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cgroupfs.h"
+
+// QPA mirserver
+#include <logging.h>
+
+#include <QFile>
+#include <QFileInfo>
+
+using namespace qtmir;
+
+namespace {
+
+// Keeps the number of inotify watches bounded
+const int maxCachedCGroups = 64;
+
+} // namespace {
+
+CGroupFs::CGroupFs(QObject *parent)
+    : CGroupFs(QStringLiteral("/proc"), QStringLiteral("/proc/self/mountinfo"), parent)
+{
+}
+
+CGroupFs::CGroupFs(const QString &procPath, const QString &mountInfoPath, QObject *parent)
+    : QObject(parent)
+    , m_procPath(procPath)
+{
+    readMountInfo(mountInfoPath);
+
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &CGroupFs::onPathChanged);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &CGroupFs::onPathChanged);
+}
+
+void CGroupFs::readMountInfo(const QString &mountInfoPath)
+{
+    QFile mountInfo(mountInfoPath);
+    if (!mountInfo.open(QIODevice::ReadOnly)) {
+        qCWarning(QTMIR_DBUS) << "CGroupFs: unable to read" << mountInfoPath;
+        return;
+    }
+
+    // Format: id parent major:minor root mount-point options [optional fields] - fstype source super-options
+    Q_FOREACH (const QByteArray &line, mountInfo.readAll().split('\n')) {
+        const QList<QByteArray> fields = line.split(' ');
+        const int separator = fields.indexOf("-");
+        if (separator < 5 || separator + 3 >= fields.count()) {
+            continue;
+        }
+
+        const QByteArray &fsType = fields[separator + 1];
+        Hierarchy hierarchy;
+        hierarchy.mountPoint = QString::fromUtf8(fields[4]);
+
+        if (fsType == "cgroup2") {
+            m_hierarchies.append(hierarchy);
+        } else if (fsType == "cgroup") {
+            Q_FOREACH (const QByteArray &option, fields[separator + 3].split(',')) {
+                if (option != "rw" && option != "ro" && !option.startsWith("name=")) {
+                    hierarchy.controllers.append(QString::fromLatin1(option));
+                }
+            }
+            if (!hierarchy.controllers.isEmpty()) {
+                m_hierarchies.append(hierarchy);
+            }
+        }
+    }
+
+    qCDebug(QTMIR_DBUS) << "CGroupFs: found" << m_hierarchies.count() << "cgroup hierarchies";
+}
+
+const CGroupFs::Hierarchy *CGroupFs::hierarchyFor(const QString &controller) const
+{
+    const Hierarchy *unified = nullptr;
+    for (const Hierarchy &hierarchy : m_hierarchies) {
+        if (hierarchy.controllers.contains(controller)) {
+            return &hierarchy;
+        }
+        if (hierarchy.controllers.isEmpty()) {
+            unified = &hierarchy;
+        }
+    }
+    return unified;
+}
+
+QString CGroupFs::cgroupOfPid(const QString &controller, pid_t pid) const
+{
+    const Hierarchy *hierarchy = hierarchyFor(controller);
+    if (!hierarchy) {
+        return QString();
+    }
+    const bool unified = hierarchy->controllers.isEmpty();
+
+    QFile file(QStringLiteral("%1/%2/cgroup").arg(m_procPath).arg(pid));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    // Format: hierarchy-id:controller-list:path, the unified hierarchy being "0::path"
+    Q_FOREACH (const QByteArray &line, file.readAll().split('\n')) {
+        const int firstColon = line.indexOf(':');
+        const int secondColon = line.indexOf(':', firstColon + 1);
+        if (firstColon < 0 || secondColon < 0) {
+            continue;
+        }
+
+        const QByteArray controllers = line.mid(firstColon + 1, secondColon - firstColon - 1);
+        const bool matches = unified ? controllers.isEmpty()
+                                     : controllers.split(',').contains(controller.toLatin1());
+        if (matches) {
+            return QString::fromUtf8(line.mid(secondColon + 1));
+        }
+    }
+
+    return QString();
+}
+
+QSet<pid_t> CGroupFs::processes(const QString &controller, const QString &cgroup, pid_t knownMember)
+{
+    const Hierarchy *hierarchy = hierarchyFor(controller);
+    if (!hierarchy || cgroup.isEmpty()) {
+        return QSet<pid_t>();
+    }
+
+    const QString cgroupPath = hierarchy->mountPoint + cgroup;
+
+    auto cached = m_processCache.constFind(cgroupPath);
+    if (cached != m_processCache.constEnd() && (knownMember == 0 || cached->contains(knownMember))) {
+        return cached.value();
+    }
+
+    QFile procs(cgroupPath + QStringLiteral("/cgroup.procs"));
+    if (!procs.open(QIODevice::ReadOnly)) {
+        qCDebug(QTMIR_DBUS) << "CGroupFs: unable to read processes of" << cgroupPath;
+        return QSet<pid_t>();
+    }
+
+    QSet<pid_t> pidSet;
+    Q_FOREACH (const QByteArray &line, procs.readAll().split('\n')) {
+        bool ok;
+        const pid_t pid = line.toInt(&ok);
+        if (ok) {
+            pidSet.insert(pid);
+        }
+    }
+
+    if (cached == m_processCache.constEnd()) {
+        if (m_processCache.count() >= maxCachedCGroups) {
+            Q_FOREACH (const QString &path, m_processCache.keys()) {
+                forget(path);
+            }
+        }
+
+        // Membership changes don't raise inotify events on cgroup.procs, so watch what does change:
+        // the directory when the cgroup goes away, and cgroup.events when it (un)populates (v2 only)
+        m_watcher.addPath(cgroupPath);
+        const QString eventsPath = cgroupPath + QStringLiteral("/cgroup.events");
+        if (QFileInfo::exists(eventsPath)) {
+            m_watcher.addPath(eventsPath);
+        }
+    }
+    m_processCache.insert(cgroupPath, pidSet);
+
+    return pidSet;
+}
+
+bool CGroupFs::setFrozen(const QString &cgroup, bool frozen)
+{
+    const Hierarchy *hierarchy = hierarchyFor(QStringLiteral("freezer"));
+    if (!hierarchy || cgroup.isEmpty()) {
+        return false;
+    }
+
+    const bool unified = hierarchy->controllers.isEmpty();
+    QFile file(hierarchy->mountPoint + cgroup + (unified ? QStringLiteral("/cgroup.freeze")
+                                                         : QStringLiteral("/freezer.state")));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(QTMIR_DBUS) << "CGroupFs: unable to open" << file.fileName();
+        return false;
+    }
+
+    const QByteArray state = unified ? (frozen ? "1" : "0") : (frozen ? "FROZEN" : "THAWED");
+    return file.write(state) == state.size();
+}
+
+qint64 CGroupFs::memoryUsage(const QString &cgroup) const
+{
+    const Hierarchy *hierarchy = hierarchyFor(QStringLiteral("memory"));
+    if (!hierarchy || cgroup.isEmpty()) {
+        return -1;
+    }
+
+    const bool unified = hierarchy->controllers.isEmpty();
+    QFile file(hierarchy->mountPoint + cgroup + (unified ? QStringLiteral("/memory.current")
+                                                         : QStringLiteral("/memory.usage_in_bytes")));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    bool ok;
+    const qint64 bytes = file.readAll().trimmed().toLongLong(&ok);
+    return ok ? bytes : -1;
+}
+
+QString CGroupFs::controlDirectory(const QString &controller, const QString &cgroup, bool *unified) const
+{
+    const Hierarchy *hierarchy = hierarchyFor(controller);
+    if (!hierarchy || cgroup.isEmpty()) {
+        return QString();
+    }
+
+    if (unified) {
+        *unified = hierarchy->controllers.isEmpty();
+    }
+    return hierarchy->mountPoint + cgroup;
+}
+
+bool CGroupFs::isApplicationCGroup(const QString &cgroup)
+{
+    const QStringList components = cgroup.split('/');
+    const bool isSystemdAppUnit = components.count() >= 2
+            && components.at(components.count() - 2) == QLatin1String("app.slice");
+    return components.contains(QStringLiteral("upstart")) || isSystemdAppUnit;
+}
+
+void CGroupFs::onPathChanged(const QString &path)
+{
+    const QString cgroupPath = path.endsWith(QStringLiteral("/cgroup.events"))
+            ? QFileInfo(path).path()
+            : path;
+    forget(cgroupPath);
+}
+
+void CGroupFs::forget(const QString &cgroupPath)
+{
+    if (m_processCache.remove(cgroupPath) == 0) {
+        return;
+    }
+    m_watcher.removePath(cgroupPath);
+    const QString eventsPath = cgroupPath + QStringLiteral("/cgroup.events");
+    if (m_watcher.files().contains(eventsPath)) {
+        m_watcher.removePath(eventsPath);
+    }
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_CGROUPFS_H
+#define QTMIR_CGROUPFS_H
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+#include <sys/types.h>
+
+namespace qtmir {
+
+/*
+  Answers the same questions as CGManager, but straight from the kernel: /proc/<pid>/cgroup tells the
+  cgroup of a process and the cgroup.procs file of that cgroup lists its processes. Works with both
+  the legacy per-controller (v1) hierarchies and the unified (v2) one. When a v1 hierarchy for the
+  requested controller is not mounted, the unified hierarchy is used.
+
+  Process lists are cached per cgroup. An entry is dropped when inotify reports a change to the cgroup
+  directory or to its cgroup.events file, and refreshed whenever it doesn't contain a process which
+  /proc says is in that cgroup.
+
+  A single instance is shared by everything in qtmir that reads cgroups. Thread safety: the mount table
+  is only read on construction, so the const methods cgroupOfPid(), memoryUsage() and
+  controlDirectory() may be called from any thread, which is what worker threads are limited to.
+  Everything else must be called from the thread the instance lives in.
+ */
+class CGroupFs : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CGroupFs(QObject *parent = nullptr);
+
+    // For tests: where to find the proc filesystem and the mount table
+    CGroupFs(const QString &procPath, const QString &mountInfoPath, QObject *parent = nullptr);
+
+    // Whether any cgroup hierarchy is mounted. If not, nothing else here will work.
+    bool isAvailable() const { return !m_hierarchies.isEmpty(); }
+
+    // Returns a null string if unknown
+    QString cgroupOfPid(const QString &controller, pid_t pid) const;
+
+    // knownMember is a process /proc says belongs to the cgroup. A cached list lacking it is stale.
+    QSet<pid_t> processes(const QString &controller, const QString &cgroup, pid_t knownMember = 0);
+
+    int cachedCGroupCount() const { return m_processCache.count(); }
+
+    // Freezes or thaws all processes in a cgroup at once, through freezer.state with the v1 freezer
+    // controller or cgroup.freeze with the unified hierarchy. Returns false if that's not possible.
+    bool setFrozen(const QString &cgroup, bool frozen);
+
+    // Whether all processes in the cgroup belong to a single application, eg:
+    // /user.slice/user-32011.slice/session-c3.scope/upstart/application-legacy-puritine_gedit_0.0-
+    // /user.slice/user-1000.slice/user@1000.service/app.slice/app-gedit-1234.scope
+    static bool isApplicationCGroup(const QString &cgroup);
+
+    // Memory charged to the cgroup, page cache included, from memory.current with the unified
+    // hierarchy or memory.usage_in_bytes with the v1 memory controller. -1 if unknown.
+    qint64 memoryUsage(const QString &cgroup) const;
+
+    // Directory holding the control files of the cgroup for the given controller, and whether those
+    // are the unified hierarchy ones. Returns a null string if the controller is not mounted.
+    QString controlDirectory(const QString &controller, const QString &cgroup, bool *unified = nullptr) const;
+
+private Q_SLOTS:
+    void onPathChanged(const QString &path);
+
+private:
+    struct Hierarchy {
+        QString mountPoint;
+        QStringList controllers; // empty for the unified hierarchy
+        int id{-1};
+    };
+
+    void readMountInfo(const QString &mountInfoPath);
+    const Hierarchy *hierarchyFor(const QString &controller) const;
+    void forget(const QString &cgroupPath);
+
+    const QString m_procPath;
+    QVector<Hierarchy> m_hierarchies;
+
+    QHash<QString, QSet<pid_t>> m_processCache; // keyed by cgroup directory
+    QFileSystemWatcher m_watcher;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_CGROUPFS_H
@@ -18,20 +18,22 @@
 
 // local
 #include "cgmanager.h"
-#include "mirsurfacelistmodel.h"
-#include "mirsurfaceinterface.h"
+#include "cgroupfs.h"
 #include "session_interface.h"
+#include "windowstacksnapshot.h"
 
 // QPA mirserver
 #include <logging.h>
 #include <shelluuid.h>
 
 #include <QDBusConnection>
+#include <QDBusMessage>
+#include <QTimer>
 
 using namespace qtmir;
 
-DBusFocusInfo::DBusFocusInfo(const QList<Application*> &applications)
-    : m_applications(applications)
+DBusFocusInfo::DBusFocusInfo(QObject *parent)
+    : QObject(parent)
 {
     QDBusConnection::sessionBus().registerService("com.canonical.Unity.FocusInfo");
     QDBusConnection::sessionBus().registerObject("/com/canonical/Unity/FocusInfo", this, QDBusConnection::ExportScriptableSlots);
@@ -39,28 +41,91 @@ DBusFocusInfo::DBusFocusInfo(const QList<Application*> &applications)
     m_cgManager = new CGManager(this);
 }
 
+void DBusFocusInfo::setCGroupFs(const QSharedPointer<CGroupFs> &cgroupFs)
+{
+    m_cgroupFs = cgroupFs;
+}
+
+void DBusFocusInfo::registerSession(SessionInterface *session)
+{
+    const pid_t pid = session->pid();
+    if (m_sessionForPid.value(pid) == session) {
+        return;
+    }
+
+    m_sessionForPid.insert(pid, session);
+    // Only the pointer value is used once it's being destroyed
+    connect(session, &QObject::destroyed, this, [this, session, pid]() { forgetSession(session, pid); });
+
+    SessionModel *children = session->childSessions();
+    if (children) {
+        connect(children, &QAbstractItemModel::rowsInserted, this,
+                [this, children](const QModelIndex &, int first, int last) {
+            for (int i = first; i <= last; ++i) {
+                registerSession(children->list().at(i));
+            }
+        });
+        connect(children, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+                [this, children](const QModelIndex &, int first, int last) {
+            for (int i = first; i <= last; ++i) {
+                SessionInterface *childSession = children->list().at(i);
+                disconnect(childSession, nullptr, this, nullptr);
+                forgetSession(childSession, childSession->pid());
+            }
+        });
+    }
+    session->foreachChildSession([this](SessionInterface *childSession) {
+        registerSession(childSession);
+    });
+}
+
+void DBusFocusInfo::forgetSession(SessionInterface *session, pid_t pid)
+{
+    auto it = m_sessionForPid.find(pid);
+    if (it != m_sessionForPid.end() && it.value() == session) {
+        m_sessionForPid.erase(it);
+    }
+}
+
 bool DBusFocusInfo::isPidFocused(unsigned int pid)
 {
+    if (!admitCaller()) {
+        return false;
+    }
+
+    bool result = false;
+    bool found = true;
     if (QCoreApplication::applicationPid() == (qint64)pid) {
         // Shell itself.
         // Don't bother checking if it has a QML with activeFocus() which is not a MirSurfaceItem.
-        return true;
+        result = true;
     } else {
         auto pidSet = fetchAssociatedPids((pid_t)pid);
         SessionInterface *session = findSessionWithPid(pidSet);
-        return session ? session->activeFocus() : false;
+        found = session != nullptr;
+        result = session ? session->activeFocus() : false;
     }
+    answer(result, found);
+    return result;
 }
 
 QSet<pid_t> DBusFocusInfo::fetchAssociatedPids(pid_t pid)
 {
-    QString cgroup = m_cgManager->getCGroupOfPid("freezer", pid);
+    // Reading the cgroup filesystem directly is much cheaper than two D-Bus round trips to cgmanager
+    bool fromCGroupFs = m_cgroupFs && m_cgroupFs->isAvailable();
+    QString cgroup;
+    if (fromCGroupFs) {
+        cgroup = m_cgroupFs->cgroupOfPid("freezer", pid);
+    }
+    if (cgroup.isNull()) {
+        fromCGroupFs = false;
+        cgroup = m_cgManager->getCGroupOfPid("freezer", pid);
+    }
 
-    // If a cgroup has a format like this:
-    // /user.slice/user-32011.slice/session-c3.scope/upstart/application-legacy-puritine_gedit_0.0-
-    // All PIds in it are associated with a single application.
-    if (cgroup.split("/").contains("upstart")) {
-        QSet<pid_t> pidSet = m_cgManager->getTasks("freezer", cgroup);
+    // All PIds in an application cgroup are associated with a single application.
+    if (CGroupFs::isApplicationCGroup(cgroup)) {
+        QSet<pid_t> pidSet = fromCGroupFs ? m_cgroupFs->processes("freezer", cgroup, pid)
+                                          : m_cgManager->getTasks("freezer", cgroup);
         qCDebug(QTMIR_DBUS) << "DBusFocusInfo: pid" << pid << "is in cgroup" << cgroup << "along with:" << pidSet;
         if (pidSet.isEmpty()) {
             pidSet << pid;
@@ -72,23 +137,12 @@ QSet<pid_t> DBusFocusInfo::fetchAssociatedPids(pid_t pid)
     }
 }
 
-SessionInterface* DBusFocusInfo::findSessionWithPid(const QSet<pid_t> &pidSet)
+SessionInterface* DBusFocusInfo::findSessionWithPid(const QSet<pid_t> &pidSet) const
 {
-    Q_FOREACH (Application* application, m_applications) {
-        QVector<SessionInterface*> sessions = application->sessions();
-        for (auto session : sessions) {
-            if (pidSet.contains(session->pid())) {
-                return session;
-            }
-            SessionInterface *chosenChildSession = nullptr;
-            session->foreachChildSession([&](SessionInterface* childSession) {
-                if (pidSet.contains(childSession->pid())) {
-                    chosenChildSession = childSession;
-                }
-            });
-            if (chosenChildSession) {
-                return chosenChildSession;
-            }
+    for (pid_t pid : pidSet) {
+        SessionInterface *session = m_sessionForPid.value(pid, nullptr);
+        if (session) {
+            return session;
         }
     }
     return nullptr;
@@ -96,42 +150,52 @@ SessionInterface* DBusFocusInfo::findSessionWithPid(const QSet<pid_t> &pidSet)
 
 bool DBusFocusInfo::isSurfaceFocused(const QString &serializedId)
 {
-    // TODO: Implement a penalty for negative queries, such as stalling for some time before answering
-    //       further queries. That's in order to avoid brute-force approaches to find a valid surface id.
-    //       That's particularly important for shell's own surface id as it's always valid.
+    if (!admitCaller()) {
+        return false;
+    }
+
     bool result = false;
+    bool found = true;
     if (serializedId == ShellUuId::toString()) {
         result = true;
     } else {
-        MirSurfaceInterface *qmlSurface = findQmlSurface(serializedId);
-        result = qmlSurface ? qmlSurface->activeFocus() : false;
+        // Answered from the window stack snapshot, no need to walk all applications and their surface lists
+        auto snapshot = WindowStackSnapshot::current();
+        const WindowStackEntry *entry = snapshot->findByPersistentId(serializedId);
+        found = entry != nullptr;
+        result = entry ? entry->activeFocus : false;
     }
     qCDebug(QTMIR_DBUS).nospace() << "DBusFocusInfo: isSurfaceFocused("<<serializedId<<") -> " << result;
+    answer(result, found);
     return result;
 }
 
-MirSurfaceInterface *DBusFocusInfo::findQmlSurface(const QString &serializedId)
+bool DBusFocusInfo::admitCaller()
 {
-    for (Application* application : m_applications) {
-        for (SessionInterface *session : application->sessions()) {
-            if (session) {
-                auto surfaceList = static_cast<MirSurfaceListModel*>(session->surfaceList());
-                for (int i = 0; i < surfaceList->count(); ++i) {
-                    auto qmlSurface = static_cast<MirSurfaceInterface*>(surfaceList->get(i));
-                    if (qmlSurface->persistentId() == serializedId) {
-                        return qmlSurface;
-                    }
-                }
-
-                surfaceList = static_cast<MirSurfaceListModel*>(session->promptSurfaceList());
-                for (int i = 0; i < surfaceList->count(); ++i) {
-                    auto qmlSurface = static_cast<MirSurfaceInterface*>(surfaceList->get(i));
-                    if (qmlSurface->persistentId() == serializedId) {
-                        return qmlSurface;
-                    }
-                }
-            }
-        }
+    if (!calledFromDBus() || m_throttle.admit(message().service())) {
+        return true;
+    }
+
+    qCDebug(QTMIR_DBUS) << "DBusFocusInfo: rejecting query from" << message().service();
+    sendErrorReply(QDBusError::LimitsExceeded, QStringLiteral("Too many focus queries"));
+    return false;
+}
+
+void DBusFocusInfo::answer(bool result, bool found)
+{
+    if (!calledFromDBus()) {
+        return;
+    }
+
+    // Answers about unknown ids are held back so that probing for valid ids is slow. The reply is
+    // sent later from the event loop, the shell itself doesn't wait.
+    const int delayMs = m_throttle.recordLookup(message().service(), found);
+    if (delayMs > 0) {
+        setDelayedReply(true);
+        const QDBusMessage reply = message().createReply(result);
+        const QDBusConnection bus = connection();
+        QTimer::singleShot(delayMs, this, [bus, reply]() mutable {
+            bus.send(reply);
+        });
     }
-    return nullptr;
 }
@@ -14,28 +14,41 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <QList>
+#include <QDBusContext>
+#include <QHash>
 #include <QSet>
+#include <QSharedPointer>
 
 #include "application.h"
+#include "callerthrottle.h"
 
 namespace qtmir {
 
 class CGManager;
-class MirSurfaceInterface;
+class CGroupFs;
 
 /*
    Enables other processes to check what is the currently focused application or surface,
    normally for security purposes.
+
+   Queries are answered from indexes rather than by walking all applications: surfaces come from
+   the WindowStackSnapshot and sessions are indexed by pid as they get registered.
+   Callers are throttled, see CallerThrottle.
  */
-class DBusFocusInfo : public QObject
+class DBusFocusInfo : public QObject, protected QDBusContext
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "com.canonical.Unity.FocusInfo")
 public:
-    explicit DBusFocusInfo(const QList<Application*> &applications);
+    explicit DBusFocusInfo(QObject *parent = nullptr);
     virtual ~DBusFocusInfo() {}
 
+    // Without it the processes of an application are looked up through cgmanager
+    void setCGroupFs(const QSharedPointer<CGroupFs> &cgroupFs);
+
+    // Sessions belonging to an application. Child sessions are followed automatically.
+    void registerSession(SessionInterface *session);
+
 public Q_SLOTS:
 
     /*
@@ -53,12 +66,17 @@ public Q_SLOTS:
 
 private:
     QSet<pid_t> fetchAssociatedPids(pid_t pid);
-    SessionInterface* findSessionWithPid(const QSet<pid_t> &pidSet);
-    MirSurfaceInterface *findQmlSurface(const QString &serializedId);
+    SessionInterface* findSessionWithPid(const QSet<pid_t> &pidSet) const;
+    void forgetSession(SessionInterface *session, pid_t pid);
+
+    bool admitCaller();
+    void answer(bool result, bool found);
 
-    const QList<Application*> &m_applications;
+    QHash<pid_t, SessionInterface*> m_sessionForPid;
+    CallerThrottle m_throttle;
 
-    CGManager *m_cgManager;
+    QSharedPointer<CGroupFs> m_cgroupFs;
+    CGManager *m_cgManager; // fallback for when the cgroup filesystem can't be used
 };
 
 } // namespace qtmir
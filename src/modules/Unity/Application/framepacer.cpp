@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "framepacer.h"
+
+using namespace qtmir;
+
+const qint64 FramePacer::measurementPeriodNs;
+
+void FramePacer::setRefreshRate(qreal hz)
+{
+    m_refreshRate = hz > 0 ? hz : 0;
+    m_intervalNs = hz > 0 ? static_cast<qint64>(1000000000 / hz) : 0;
+    m_nextDueNs = -1;
+}
+
+bool FramePacer::isFrameDue(qint64 nowNs) const
+{
+    return nsUntilDue(nowNs) == 0;
+}
+
+qint64 FramePacer::nsUntilDue(qint64 nowNs) const
+{
+    if (m_intervalNs == 0 || m_nextDueNs < 0) {
+        return 0;
+    }
+
+    // Screens other than the one paced to aren't in phase with it, so a frame rendered by them
+    // a bit before the due time is the one which gets shown at it.
+    return qMax<qint64>(0, m_nextDueNs - m_intervalNs / 4 - nowNs);
+}
+
+void FramePacer::frameConsumed(qint64 nowNs)
+{
+    if (m_intervalNs > 0) {
+        if (m_nextDueNs < 0 || nowNs - m_nextDueNs > m_intervalNs) {
+            // first frame, or the client had stopped drawing for a while: start afresh
+            m_nextDueNs = nowNs + m_intervalNs;
+        } else {
+            m_nextDueNs += m_intervalNs;
+        }
+    }
+
+    if (m_periodStartNs < 0) {
+        m_periodStartNs = nowNs;
+        m_periodFrames = 0;
+        return;
+    }
+
+    ++m_periodFrames;
+    const qint64 elapsedNs = nowNs - m_periodStartNs;
+    if (elapsedNs >= measurementPeriodNs) {
+        m_effectiveFps = m_periodFrames * 1000000000.0 / elapsedNs;
+        m_periodStartNs = nowNs;
+        m_periodFrames = 0;
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_FRAMEPACER_H
+#define QTMIR_FRAMEPACER_H
+
+#include <QtGlobal>
+
+namespace qtmir {
+
+/*
+  Paces the consumption of a surface's buffers to the refresh rate of the output mostly displaying it,
+  whatever the number and speed of the screens rendering that surface. As buffers go back to the client
+  as they get replaced, this is what paces the client too.
+
+  Also measures the frame rate the surface is effectively shown at.
+
+  Times are in nanoseconds, from any fixed reference.
+ */
+class FramePacer
+{
+public:
+    // A refresh rate of 0 leaves consumption unpaced
+    void setRefreshRate(qreal hz);
+    qreal refreshRate() const { return m_refreshRate; }
+
+    // Whether the next buffer may be consumed at the given time
+    bool isFrameDue(qint64 nowNs) const;
+    // How long until it may, 0 if it already may
+    qint64 nsUntilDue(qint64 nowNs) const;
+
+    void frameConsumed(qint64 nowNs);
+    void frameHeld() { ++m_framesHeld; }
+
+    // Frames consumed per second over the latest complete measurement period, 0 until there is one
+    qreal effectiveFps() const { return m_effectiveFps; }
+
+    // How many times a new buffer was left for later as it came too early
+    quint64 framesHeld() const { return m_framesHeld; }
+
+    static const qint64 measurementPeriodNs = 1000000000;
+
+private:
+    qreal m_refreshRate{0};
+    qint64 m_intervalNs{0};
+    qint64 m_nextDueNs{-1};
+
+    qint64 m_periodStartNs{-1};
+    int m_periodFrames{0};
+    qreal m_effectiveFps{0};
+    quint64 m_framesHeld{0};
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_FRAMEPACER_H
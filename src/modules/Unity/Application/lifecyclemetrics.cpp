@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lifecyclemetrics.h"
+
+#include <QTextStream>
+
+using namespace qtmir;
+
+///////////////////////////////// LatencyHistogram /////////////////////////////////
+
+void LatencyHistogram::add(qint64 ms)
+{
+    ms = qMax<qint64>(0, ms);
+
+    int index = 0;
+    while (index < bucketCount - 1 && ms >= bucketUpperBound(index)) {
+        ++index;
+    }
+    ++m_buckets[index];
+
+    m_min = m_count ? qMin(m_min, ms) : ms;
+    m_max = qMax(m_max, ms);
+    m_total += ms;
+    ++m_count;
+}
+
+qint64 LatencyHistogram::percentile(int percent) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+
+    const quint64 rank = (m_count * qBound(0, percent, 100) + 99) / 100;
+    quint64 seen = 0;
+    for (int index = 0; index < bucketCount; ++index) {
+        seen += m_buckets[index];
+        if (seen >= qMax<quint64>(rank, 1)) {
+            return qMin(bucketUpperBound(index), m_max);
+        }
+    }
+    return m_max;
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    return Q_INT64_C(8) << index;
+}
+
+///////////////////////////////// LifecycleMetrics /////////////////////////////////
+
+void LifecycleMetrics::record(const QString &appId, Metric metric, qint64 ms)
+{
+    m_apps[appId].histograms[metric].add(ms);
+    m_overall.histograms[metric].add(ms);
+}
+
+LatencyHistogram LifecycleMetrics::histogram(const QString &appId, Metric metric) const
+{
+    auto it = m_apps.constFind(appId);
+    if (it == m_apps.constEnd()) {
+        return LatencyHistogram();
+    }
+    return it.value().histograms[metric];
+}
+
+QString LifecycleMetrics::dump() const
+{
+    QString result;
+    QTextStream stream(&result);
+
+    auto dumpHistograms = [&](const QString &name, const Histograms &histograms) {
+        for (int metric = 0; metric < MetricCount; ++metric) {
+            const LatencyHistogram &histogram = histograms.histograms[metric];
+            if (histogram.count() == 0) {
+                continue;
+            }
+            stream << name << ' ' << metricName(static_cast<Metric>(metric))
+                   << " count=" << histogram.count()
+                   << " min=" << histogram.min()
+                   << " mean=" << histogram.mean()
+                   << " p50=" << histogram.percentile(50)
+                   << " p90=" << histogram.percentile(90)
+                   << " max=" << histogram.max() << '\n';
+        }
+    };
+
+    dumpHistograms(QStringLiteral("*"), m_overall);
+
+    QStringList appIds = m_apps.keys();
+    appIds.sort();
+    for (const QString &appId : appIds) {
+        dumpHistograms(appId, m_apps.value(appId));
+    }
+
+    stream.flush();
+    return result;
+}
+
+const char *LifecycleMetrics::metricName(Metric metric)
+{
+    switch (metric) {
+    case LaunchToFirstFrame:
+        return "launchToFirstFrame";
+    case ResumeToFirstFrame:
+        return "resumeToFirstFrame";
+    case SuspendAcknowledgment:
+        return "suspendAcknowledgment";
+    case MetricCount:
+        break;
+    }
+    return "???";
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_LIFECYCLEMETRICS_H
+#define QTMIR_LIFECYCLEMETRICS_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+namespace qtmir {
+
+/*
+  Distribution of latencies, in milliseconds, in exponentially sized buckets.
+  Bucket i holds values below 2^(i+3) ms, the last one anything above.
+ */
+class LatencyHistogram
+{
+public:
+    void add(qint64 ms);
+
+    quint64 count() const { return m_count; }
+    qint64 min() const { return m_count ? m_min : 0; }
+    qint64 max() const { return m_max; }
+    qint64 mean() const { return m_count ? m_total / static_cast<qint64>(m_count) : 0; }
+
+    // Upper bound of the bucket the given percentile (0-100) falls in, capped to the maximum seen
+    qint64 percentile(int percent) const;
+
+    quint64 bucket(int index) const { return m_buckets[index]; }
+    static qint64 bucketUpperBound(int index);
+
+    static const int bucketCount = 16;
+
+private:
+    quint64 m_buckets[bucketCount] = {};
+    quint64 m_count{0};
+    qint64 m_total{0};
+    qint64 m_min{0};
+    qint64 m_max{0};
+};
+
+/*
+  Per-application histograms of how long lifecycle transitions take, as perceived by the user.
+ */
+class LifecycleMetrics
+{
+public:
+    enum Metric {
+        LaunchToFirstFrame, // from being asked to start until the first surface draws its first frame
+        ResumeToFirstFrame, // from being asked to resume until a surface posts a new frame
+        SuspendAcknowledgment, // from asking the app to suspend until its process is suspended
+        MetricCount
+    };
+
+    void record(const QString &appId, Metric metric, qint64 ms);
+
+    // Empty histogram if nothing was recorded
+    LatencyHistogram histogram(const QString &appId, Metric metric) const;
+    LatencyHistogram overall(Metric metric) const { return m_overall.histograms[metric]; }
+
+    QStringList appIds() const { return m_apps.keys(); }
+
+    // Human readable summary, one line per application and metric
+    QString dump() const;
+
+    static const char *metricName(Metric metric);
+
+private:
+    struct Histograms {
+        LatencyHistogram histograms[MetricCount];
+    };
+
+    QHash<QString, Histograms> m_apps;
+    Histograms m_overall;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_LIFECYCLEMETRICS_H
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lifecyclescheduler.h"
+#include "timer.h"
+#include "tracepoints.h" // generated from tracepoints.tp
+
+#include <QPointer>
+#include <QVector>
+
+using namespace qtmir;
+
+const int LifecycleScheduler::slackMs = 250;
+
+LifecycleScheduler::LifecycleScheduler(const SharedTimeSource &timeSource, QObject *parent)
+    : QObject(parent)
+    , m_timeSource(timeSource)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::CoarseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &LifecycleScheduler::runDueWork);
+}
+
+LifecycleScheduler *LifecycleScheduler::instance()
+{
+    // Deliberately leaked, sessions and applications may outlive any static object
+    static LifecycleScheduler *scheduler = new LifecycleScheduler;
+    return scheduler;
+}
+
+void LifecycleScheduler::schedule(BatchedTimer *timer, int intervalMs)
+{
+    cancel(timer);
+
+    const qint64 due = m_timeSource->msecsSinceReference() + intervalMs;
+    const qint64 deadline = ((due + slackMs - 1) / slackMs) * slackMs;
+
+    m_pending.insert(deadline, timer);
+    m_deadlineOf.insert(timer, deadline);
+
+    if (m_pending.constBegin().key() == deadline) {
+        rearm();
+    }
+}
+
+void LifecycleScheduler::cancel(BatchedTimer *timer)
+{
+    auto it = m_deadlineOf.find(timer);
+    if (it == m_deadlineOf.end()) {
+        return;
+    }
+    m_pending.remove(it.value(), timer);
+    m_deadlineOf.erase(it);
+    // No need to rearm, waking up for nothing once is cheaper than restarting the timer each time
+}
+
+void LifecycleScheduler::runDueWork()
+{
+    const qint64 now = m_timeSource->msecsSinceReference();
+
+    // Firing a timer may end up destroying others of the same batch
+    QVector<QPointer<BatchedTimer>> due;
+    while (!m_pending.isEmpty() && m_pending.constBegin().key() <= now) {
+        BatchedTimer *timer = m_pending.constBegin().value();
+        m_pending.erase(m_pending.begin());
+        m_deadlineOf.remove(timer);
+        due.append(timer);
+    }
+
+    if (!due.isEmpty()) {
+        ++m_batchStats.batches;
+        m_batchStats.timersFired += due.count();
+        m_batchStats.largestBatch = qMax(m_batchStats.largestBatch, due.count());
+        tracepoint(qtmir, lifecycleBatch, due.count());
+    }
+
+    for (const QPointer<BatchedTimer> &timer : due) {
+        // Firing one timer may stop or restart another one of this batch, don't fire those
+        if (timer && !m_deadlineOf.contains(timer) && timer->isRunning()) {
+            timer->fire();
+        }
+    }
+
+    rearm();
+}
+
+void LifecycleScheduler::recordTransition(Transition transition, qint64 ms)
+{
+    TransitionStats &stats = m_transitionStats[transition];
+    ++stats.count;
+    stats.totalMs += ms;
+    stats.maxMs = qMax(stats.maxMs, ms);
+    tracepoint(qtmir, lifecycleTransition, static_cast<int>(transition), ms);
+}
+
+void LifecycleScheduler::rearm()
+{
+    if (m_pending.isEmpty()) {
+        m_timer.stop();
+        return;
+    }
+
+    const qint64 wait = m_pending.constBegin().key() - m_timeSource->msecsSinceReference();
+    m_timer.start(static_cast<int>(qMax<qint64>(0, wait)));
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_LIFECYCLESCHEDULER_H
+#define QTMIR_LIFECYCLESCHEDULER_H
+
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QTimer>
+
+#include "timesource.h"
+
+namespace qtmir {
+
+class BatchedTimer;
+
+/*
+  Runs the deferred lifecycle work of all sessions and applications (suspending, stopping) off a
+  single timer.
+
+  Deadlines are rounded up to a multiple of slackMs, so that work requested around the same time,
+  like the shell sending a bunch of applications to the background at once, is done in one batch
+  and wakes the shell up once instead of once per application.
+
+  Also collects how long each kind of lifecycle transition takes.
+ */
+class LifecycleScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LifecycleScheduler(const SharedTimeSource &timeSource = SharedTimeSource(new RealTimeSource),
+                                QObject *parent = nullptr);
+
+    static LifecycleScheduler *instance();
+
+    void schedule(BatchedTimer *timer, int intervalMs);
+    void cancel(BatchedTimer *timer);
+
+    int pendingCount() const { return m_pending.count(); }
+
+    enum Transition {
+        SessionSuspend, // from asking the client to suspend until it's considered suspended
+        ProcessSuspend, // from asking for the process to be suspended until it is
+        ApplicationStop, // from losing its last surface until the process is asked to stop
+        TransitionCount
+    };
+    void recordTransition(Transition transition, qint64 ms);
+
+    struct TransitionStats {
+        quint64 count{0};
+        qint64 totalMs{0};
+        qint64 maxMs{0};
+    };
+    TransitionStats transitionStats(Transition transition) const { return m_transitionStats[transition]; }
+
+    struct BatchStats {
+        quint64 batches{0};
+        quint64 timersFired{0};
+        int largestBatch{0};
+    };
+    BatchStats batchStats() const { return m_batchStats; }
+
+    static const int slackMs;
+
+public Q_SLOTS:
+    // Fires all timers that are due. Called by the internal timer, or by tests using a fake time source.
+    void runDueWork();
+
+private:
+    void rearm();
+
+    SharedTimeSource m_timeSource;
+    QTimer m_timer;
+    QMultiMap<qint64, BatchedTimer*> m_pending; // by deadline
+    QHash<BatchedTimer*, qint64> m_deadlineOf;
+
+    TransitionStats m_transitionStats[TransitionCount];
+    BatchStats m_batchStats;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_LIFECYCLESCHEDULER_H
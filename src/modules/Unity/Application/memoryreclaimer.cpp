@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "memoryreclaimer.h"
+
+#include "application.h"
+#include "proc_info.h"
+#include "session_interface.h"
+#include "tracepoints.h" // generated from tracepoints.tp
+
+// QPA mirserver
+#include "logging.h"
+
+#include <QFile>
+#include <QSocketNotifier>
+#include <QTimer>
+
+// std
+#include <cstring>
+#include <limits>
+
+// system
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace qtmir;
+
+const int MemoryReclaimer::cooldownMs = 5000;
+// Some task stalled on memory for 150ms within a 2s window
+const char *const MemoryReclaimer::pressureTrigger = "some 150000 2000000";
+const int MemoryReclaimer::pollIntervalMs = 2000;
+const double MemoryReclaimer::pollThreshold = 7.5; // "some" avg10, in percent
+
+MemoryReclaimer::MemoryReclaimer(const QSharedPointer<ProcInfo> &procInfo,
+                                 const SharedTimeSource &timeSource,
+                                 QObject *parent)
+    : QObject(parent)
+    , m_procInfo(procInfo)
+    , m_timeSource(timeSource)
+{
+}
+
+MemoryReclaimer::~MemoryReclaimer()
+{
+    delete m_pressureNotifier;
+    if (m_pressureFd >= 0) {
+        ::close(m_pressureFd);
+    }
+}
+
+bool MemoryReclaimer::watchPressure(const QString &pressurePath)
+{
+    m_pressurePath = pressurePath;
+
+    const QByteArray path = QFile::encodeName(pressurePath);
+    m_pressureFd = ::open(path.constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (m_pressureFd >= 0) {
+        // the kernel wants the terminating NUL as well
+        if (::write(m_pressureFd, pressureTrigger, std::strlen(pressureTrigger) + 1) >= 0) {
+            m_pressureNotifier = new QSocketNotifier(m_pressureFd, QSocketNotifier::Exception);
+            connect(m_pressureNotifier, &QSocketNotifier::activated, this, &MemoryReclaimer::onPressure);
+            qCDebug(QTMIR_APPLICATIONS) << "MemoryReclaimer - using a PSI trigger on" << pressurePath;
+            return true;
+        }
+        ::close(m_pressureFd);
+        m_pressureFd = -1;
+    }
+
+    // Triggers need a 5.2 kernel and, before 5.10, CAP_SYS_RESOURCE. Reading works everywhere PSI does.
+    if (!QFile(pressurePath).open(QIODevice::ReadOnly)) {
+        qCDebug(QTMIR_APPLICATIONS) << "MemoryReclaimer - memory pressure is not available";
+        return false;
+    }
+
+    m_pollTimer = new QTimer(this);
+    m_pollTimer->setInterval(pollIntervalMs);
+    connect(m_pollTimer, &QTimer::timeout, this, &MemoryReclaimer::pollPressure);
+    m_pollTimer->start();
+    qCDebug(QTMIR_APPLICATIONS) << "MemoryReclaimer - polling" << pressurePath;
+    return true;
+}
+
+void MemoryReclaimer::addApplication(Application *application, bool expendable)
+{
+    m_lastUsed.insert(application, expendable ? std::numeric_limits<qint64>::min()
+                                              : m_timeSource->msecsSinceReference());
+
+    connect(application, &Application::focusedChanged, this, [this, application]() {
+        m_lastUsed.insert(application, m_timeSource->msecsSinceReference());
+    });
+}
+
+void MemoryReclaimer::removeApplication(Application *application)
+{
+    m_lastUsed.remove(application);
+    disconnect(application, nullptr, this, nullptr);
+}
+
+Application *MemoryReclaimer::reclaim()
+{
+    Application *victim = nullptr;
+    qint64 victimLastUsed = 0;
+    for (auto it = m_lastUsed.constBegin(); it != m_lastUsed.constEnd(); ++it) {
+        if (mayBeStopped(it.key()) && (!victim || it.value() < victimLastUsed)) {
+            victim = it.key();
+            victimLastUsed = it.value();
+        }
+    }
+
+    if (!victim) {
+        ++m_stats.noCandidate;
+        qCDebug(QTMIR_APPLICATIONS) << "MemoryReclaimer - under memory pressure but no application can be stopped";
+        return nullptr;
+    }
+
+    const qint64 bytes = memoryOf(victim);
+    ++m_stats.reclaimDecisions;
+    m_stats.reclaimedBytes += bytes;
+    m_lastReclaim = m_timeSource->msecsSinceReference();
+    m_hasReclaimed = true;
+
+    qCInfo(QTMIR_APPLICATIONS) << "MemoryReclaimer - stopping" << victim->appId() << "to reclaim" << bytes / 1024 << "kB";
+    tracepoint(qtmir, appReclaimed, victim->appId().toUtf8().constData(), bytes);
+
+    Q_EMIT reclaimRequested(victim);
+    return victim;
+}
+
+void MemoryReclaimer::onPressure()
+{
+    ++m_stats.pressureEvents;
+
+    if (m_hasReclaimed && m_timeSource->msecsSinceReference() - m_lastReclaim < cooldownMs) {
+        return;
+    }
+
+    reclaim();
+}
+
+void MemoryReclaimer::pollPressure()
+{
+    QFile file(m_pressurePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    // some avg10=1.23 avg60=0.50 avg300=0.10 total=123456
+    const QByteArray line = file.readLine();
+    if (!line.startsWith("some ")) {
+        return;
+    }
+    const int start = line.indexOf("avg10=");
+    if (start < 0) {
+        return;
+    }
+    const int valueStart = start + int(sizeof("avg10=")) - 1;
+    const int end = line.indexOf(' ', valueStart);
+    const double avg10 = line.mid(valueStart, end - valueStart).toDouble();
+
+    if (avg10 >= pollThreshold) {
+        onPressure();
+    }
+}
+
+bool MemoryReclaimer::mayBeStopped(Application *application) const
+{
+    // Only suspended applications managed by the task controller can be brought back transparently
+    return application->internalState() == Application::InternalState::Suspended
+            && application->processState() != Application::ProcessUnknown
+            && !application->focused()
+            && !application->exemptFromLifecycle();
+}
+
+qint64 MemoryReclaimer::memoryOf(Application *application) const
+{
+    qint64 bytes = 0;
+    for (SessionInterface *session : application->sessions()) {
+        const ProcInfo::MemoryUsage usage = m_procInfo->memoryUsage(session->pid());
+        bytes += usage.pssBytes > 0 ? usage.pssBytes : usage.rssBytes;
+    }
+    return bytes;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_MEMORYRECLAIMER_H
+#define QTMIR_MEMORYRECLAIMER_H
+
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+
+#include "timesource.h"
+
+class QSocketNotifier;
+class QTimer;
+
+namespace qtmir {
+
+class Application;
+class ProcInfo;
+
+/*
+  Frees memory by stopping background applications when the system is under memory pressure,
+  instead of leaving it to swapping or to the OOM killer picking a victim at random.
+
+  Pressure is reported by the kernel through PSI (/proc/pressure/memory). A trigger is registered
+  when possible, otherwise the file is polled. On pressure the least recently used application that
+  is suspended, not focused and not exempt from lifecycle is picked, and reclaimRequested() emitted.
+  Only one application is picked per cooldown period so that the effect of stopping it can show up
+  in the pressure figures before deciding on another one.
+ */
+class MemoryReclaimer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MemoryReclaimer(const QSharedPointer<ProcInfo> &procInfo,
+                             const SharedTimeSource &timeSource = SharedTimeSource(new RealTimeSource),
+                             QObject *parent = nullptr);
+    virtual ~MemoryReclaimer();
+
+    // Returns false if the kernel doesn't report memory pressure
+    bool watchPressure(const QString &pressurePath = QStringLiteral("/proc/pressure/memory"));
+
+    // Expendable applications are picked before any other, as if they were used the longest ago
+    void addApplication(Application *application, bool expendable = false);
+    void removeApplication(Application *application);
+
+    // Returns the application picked to be stopped, if any
+    Application *reclaim();
+
+    struct Stats {
+        quint64 pressureEvents{0};
+        quint64 reclaimDecisions{0};
+        quint64 noCandidate{0}; // under pressure but nothing could be stopped
+        qint64 reclaimedBytes{0}; // proportional set size of the applications stopped
+    };
+    Stats stats() const { return m_stats; }
+
+    static const int cooldownMs;
+    static const char *const pressureTrigger;
+    static const int pollIntervalMs;
+    static const double pollThreshold;
+
+Q_SIGNALS:
+    void reclaimRequested(Application *application);
+
+private Q_SLOTS:
+    void onPressure();
+    void pollPressure();
+
+private:
+    bool mayBeStopped(Application *application) const;
+    qint64 memoryOf(Application *application) const;
+
+    QSharedPointer<ProcInfo> m_procInfo;
+    SharedTimeSource m_timeSource;
+    QHash<Application*, qint64> m_lastUsed;
+
+    QString m_pressurePath;
+    int m_pressureFd{-1};
+    QSocketNotifier *m_pressureNotifier{nullptr};
+    QTimer *m_pollTimer{nullptr};
+
+    qint64 m_lastReclaim{0};
+    bool m_hasReclaimed{false};
+    Stats m_stats;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_MEMORYRECLAIMER_H
@@ -20,6 +20,7 @@
 #include "session_interface.h"
 #include "timer.h"
 #include "timestamp.h"
+#include "tracepoints.h" // generated from tracepoints.tp
 
 // from common dir
 #include <debughelpers.h>
@@ -42,6 +43,7 @@
 
 // Qt
 #include <QElapsedTimer>
+#include <QGuiApplication>
 #include <QQmlEngine>
 #include <QScreen>
 
@@ -87,6 +89,10 @@ public:
 
     void setListener(QObject *listener);
 
+    // Mir may release its reference from one of its threads, hence a thread-safe pool
+    static void *operator new(std::size_t) { return slabPoolFor<sizeof(SurfaceObserverImpl)>().allocate(); }
+    static void operator delete(void *ptr) { slabPoolFor<sizeof(SurfaceObserverImpl)>().deallocate(ptr); }
+
     void attrib_changed(MirWindowAttrib, int) override;
     void resized_to(mir::geometry::Size const&) override;
     void moved_to(mir::geometry::Point const&) override {}
@@ -119,6 +125,7 @@ private:
     QCursor createQCursorFromMirCursorImage(const mir::graphics::CursorImage &cursorImage);
     QObject *m_listener;
     bool m_framesPosted;
+    QSize m_lastFrameSize;
     QMap<QByteArray, Qt::CursorShape> m_cursorNameToShape;
 };
 
@@ -146,7 +153,7 @@ MirSurface::MirSurface(NewWindow newWindowInfo,
     , m_currentFrameNumber(0)
     , m_visible(newWindowInfo.windowInfo.is_visible())
     , m_live(true)
-    , m_surfaceObserver(std::make_shared<SurfaceObserverImpl>())
+    , m_surfaceObserver(new SurfaceObserverImpl)
     , m_size(toQSize(m_window.size()))
     , m_state(toQtState(newWindowInfo.windowInfo.state()))
     , m_shellChrome(toQtShellChrome(newWindowInfo.windowInfo.shell_chrome()))
@@ -183,12 +190,24 @@ MirSurface::MirSurface(NewWindow newWindowInfo,
     m_surfaceObserver->setListener(this);
 
     connect(session, &SessionInterface::stateChanged, this, [this]() {
-        if (clientIsRunning() && m_pendingResize.isValid()) {
-            resize(m_pendingResize.width(), m_pendingResize.height());
-            m_pendingResize = QSize(-1, -1);
+        if (clientIsRunning()) {
+            sendPendingResize();
         }
     });
 
+    // Mir might not apply the size we asked for verbatim (min/max size, size increments...),
+    // in which case a frame of the size it did apply is what we should be waiting for.
+    connect(m_surfaceObserver.get(), &SurfaceObserver::resized, this, [this](const QSize &size) {
+        if (m_resizeInFlight.isValid()) {
+            m_resizeInFlight = size;
+        }
+    });
+
+    // Don't wait forever for a client which doesn't redraw promptly (or at all) after a configure
+    m_resizeAckTimer.setInterval(100);
+    m_resizeAckTimer.setSingleShot(true);
+    connect(&m_resizeAckTimer, &QTimer::timeout, this, &MirSurface::onResizeAckTimedOut);
+
     connect(&m_frameDropperTimer, &QTimer::timeout,
             this, &MirSurface::dropPendingBuffer);
     // Rationale behind the frame dropper and its interval value:
@@ -206,9 +225,20 @@ MirSurface::MirSurface(NewWindow newWindowInfo,
     m_frameDropperTimer.setInterval(200);
     m_frameDropperTimer.setSingleShot(false);
 
+    // A frame held for pacing is the latest the client posted, nothing else would get it rendered
+    m_heldFrameTimer.setSingleShot(true);
+    connect(&m_heldFrameTimer, &QTimer::timeout, this, &MirSurface::framesPosted);
+
+    m_pacingClock.start();
+    if (auto guiApp = qobject_cast<QGuiApplication*>(QCoreApplication::instance())) {
+        connect(guiApp, &QGuiApplication::screenAdded, this, &MirSurface::updatePacingScreen);
+        connect(guiApp, &QGuiApplication::screenRemoved, this, &MirSurface::updatePacingScreen);
+    }
+    updatePacingScreen();
+
     QQmlEngine::setObjectOwnership(this, QQmlEngine::CppOwnership);
 
-    setCloseTimer(new Timer);
+    // The close timer is only created once closing is requested, most surfaces never need one
 
     m_requestedPosition.rx() = std::numeric_limits<int>::min();
     m_requestedPosition.ry() = std::numeric_limits<int>::min();
@@ -228,14 +258,34 @@ MirSurface::~MirSurface()
     Q_EMIT destroyed(this); // Early warning, while MirSurface methods can still be accessed.
 }
 
-void MirSurface::onFramesPostedObserved()
+void MirSurface::onFramesPostedObserved(const QSize &frameSize)
 {
     // restart the frame dropper so that items have enough time to render the next frame.
     m_frameDropperTimer.start();
 
+    if (m_resizeInFlight.isValid()) {
+        if (frameSize == m_resizeInFlight) {
+            ++m_resizeStats.framesAtRequestedSize;
+            tracepoint(qtmir, resizeFrameMatched, frameSize.width(), frameSize.height());
+            m_resizeAckTimer.stop();
+            m_resizeInFlight = QSize();
+            sendPendingResize();
+        } else {
+            ++m_resizeStats.framesAtOtherSize;
+        }
+    }
+
     Q_EMIT framesPosted();
 }
 
+void MirSurface::onResizeAckTimedOut()
+{
+    DEBUG_MSG << "() no frame of size " << m_resizeInFlight << " posted in time";
+    ++m_resizeStats.ackTimeouts;
+    m_resizeInFlight = QSize();
+    sendPendingResize();
+}
+
 void MirSurface::onAttributeChanged(const MirWindowAttrib attribute, const int /*value*/)
 {
     switch (attribute) {
@@ -373,6 +423,20 @@ bool MirSurface::updateTexture()
     }
 
     const void* const userId = (void*)123;
+    const qint64 now = m_pacingClock.nsecsElapsed();
+
+    if (texture->hasBuffer() && !m_framePacer.isFrameDue(now)
+            && m_surface->buffers_ready_for_compositor(userId) > 0) {
+        // Too early for the screen this surface is paced to, show the current buffer once more.
+        // Must be decided before generating renderables, which would consume the queued buffer.
+        m_framePacer.frameHeld();
+        const int dueInMs = (m_framePacer.nsUntilDue(now) + 999999) / 1000000;
+        // queued since the timers live in a different thread
+        QMetaObject::invokeMethod(&m_heldFrameTimer, "start", Qt::QueuedConnection, Q_ARG(int, dueInMs));
+        QMetaObject::invokeMethod(&m_frameDropperTimer, "start", Qt::QueuedConnection);
+        return true;
+    }
+
     auto renderables = m_surface->generate_renderables(userId);
 
     if (renderables.size() > 0 &&
@@ -383,6 +447,7 @@ bool MirSurface::updateTexture()
         texture->freeBuffer();
         texture->setBuffer(renderables[0]->buffer());
         ++m_currentFrameNumber;
+        m_framePacer.frameConsumed(now);
 
         if (texture->textureSize() != size()) {
             m_size = texture->textureSize();
@@ -446,6 +511,8 @@ void MirSurface::setFocused(bool value)
 
 void MirSurface::setViewActiveFocus(qintptr viewId, bool value)
 {
+    const bool hadActiveFocus = activeFocus();
+
     if (value && !m_activelyFocusedViews.contains(viewId)) {
         m_activelyFocusedViews.insert(viewId);
         updateActiveFocus();
@@ -453,6 +520,10 @@ void MirSurface::setViewActiveFocus(qintptr viewId, bool value)
         m_activelyFocusedViews.remove(viewId);
         updateActiveFocus();
     }
+
+    if (activeFocus() != hadActiveFocus) {
+        Q_EMIT activeFocusChanged(activeFocus());
+    }
 }
 
 bool MirSurface::activeFocus() const
@@ -507,6 +578,9 @@ void MirSurface::close()
 
     m_closingState = Closing;
     Q_EMIT closeRequested();
+    if (!m_closeTimer) {
+        setCloseTimer(new Timer);
+    }
     m_closeTimer->start();
 
     if (m_window) {
@@ -516,17 +590,42 @@ void MirSurface::close()
 
 void MirSurface::resize(int width, int height)
 {
-    if (!clientIsRunning()) {
-        m_pendingResize = QSize(width, height);
+    const QSize newSize(width, height);
+
+    if (!clientIsRunning() || m_resizeInFlight.isValid()) {
+        // Only the latest request matters, it gets sent once the client can act on it
+        if (m_pendingResize.isValid()) {
+            ++m_resizeStats.requestsCoalesced;
+        }
+        m_pendingResize = newSize;
         return;
     }
 
-    bool mirSizeIsDifferent = width != m_size.width() || height != m_size.height();
+    sendResize(newSize);
+}
+
+void MirSurface::sendResize(const QSize &size)
+{
+    bool mirSizeIsDifferent = size != m_size;
 
     if (mirSizeIsDifferent) {
-        m_controller->resize(m_window, QSize(width, height));
+        m_controller->resize(m_window, size);
         DEBUG_MSG << " old (" << m_size.width() << "," << m_size.height() << ")"
-                  << ", new (" << width << "," << height << ")";
+                  << ", new (" << size.width() << "," << size.height() << ")";
+
+        ++m_resizeStats.configuresSent;
+        tracepoint(qtmir, resizeConfigureSent, size.width(), size.height());
+        m_resizeInFlight = size;
+        m_resizeAckTimer.start();
+    }
+}
+
+void MirSurface::sendPendingResize()
+{
+    if (m_pendingResize.isValid() && !m_resizeInFlight.isValid() && clientIsRunning()) {
+        const QSize size = m_pendingResize;
+        m_pendingResize = QSize(-1, -1);
+        sendResize(size);
     }
 }
 
@@ -541,6 +640,7 @@ void MirSurface::setPosition(const QPoint newDisplayPosition)
     if (m_position != newPosition) {
         m_position = newPosition;
         Q_EMIT positionChanged(newPosition);
+        updatePacingScreen();
 
         // Parent might have moved but children might stay put (in display coords). This
         // means different local child coords, hence the need to update them.
@@ -608,7 +708,7 @@ QString MirSurface::name() const
 
 QString MirSurface::persistentId() const
 {
-    return m_extraInfo->persistentId;
+    return m_extraInfo ? m_extraInfo->persistentId : QString();
 }
 
 void MirSurface::requestState(Mir::State state)
@@ -811,6 +911,65 @@ void MirSurface::emitSizeChanged()
 {
     qCDebug(QTMIR_SURFACES).nospace() << "MirSurface[" << (void*)this << "," << appId() << "]::sizeChanged(" << m_size << ")";
     Q_EMIT sizeChanged(m_size);
+    updatePacingScreen();
+}
+
+void MirSurface::updatePacingScreen()
+{
+    // Bind to the screen displaying the biggest part of the surface
+    const QRect geometry(convertLocalToDisplayCoords(m_position), m_size);
+    QScreen *bestScreen = nullptr;
+    qint64 bestArea = 0;
+
+    if (qobject_cast<QGuiApplication*>(QCoreApplication::instance())) {
+        Q_FOREACH (QScreen *screen, QGuiApplication::screens()) {
+            const QRect overlap = screen->geometry().intersected(geometry);
+            const qint64 area = static_cast<qint64>(overlap.width()) * overlap.height();
+            if (area > bestArea) {
+                bestArea = area;
+                bestScreen = screen;
+            }
+        }
+    }
+
+    if (bestScreen == m_pacingScreen) {
+        return;
+    }
+
+    if (m_pacingScreen) {
+        disconnect(m_pacingScreen, nullptr, this, nullptr);
+    }
+    m_pacingScreen = bestScreen;
+
+    if (m_pacingScreen) {
+        connect(m_pacingScreen, &QScreen::refreshRateChanged, this, &MirSurface::setPacingRefreshRate);
+        connect(m_pacingScreen, &QScreen::geometryChanged, this, &MirSurface::updatePacingScreen);
+        setPacingRefreshRate(m_pacingScreen->refreshRate());
+    } else {
+        // Off-screen. Left to the frame dropper.
+        setPacingRefreshRate(0);
+    }
+
+    qCDebug(QTMIR_SURFACES).nospace() << "MirSurface[" << (void*)this << "," << appId() << "]::updatePacingScreen("
+                                      << (m_pacingScreen ? m_pacingScreen->name() : QString()) << ")";
+}
+
+void MirSurface::setPacingRefreshRate(qreal hz)
+{
+    QMutexLocker locker(&m_mutex);
+    m_framePacer.setRefreshRate(hz);
+}
+
+qreal MirSurface::effectiveFps() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_framePacer.effectiveFps();
+}
+
+quint64 MirSurface::framesHeldForPacing() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_framePacer.framesHeld();
 }
 
 QString MirSurface::appId() const
@@ -1046,6 +1205,34 @@ std::shared_ptr<SurfaceObserver> MirSurface::surfaceObserver() const
     return m_surfaceObserver;
 }
 
+void *MirSurface::operator new(std::size_t size)
+{
+    // subclasses (ie, test doubles) don't fit in the pool blocks
+    if (size != sizeof(MirSurface)) {
+        return ::operator new(size);
+    }
+    return slabPoolFor<sizeof(MirSurface)>().allocate();
+}
+
+void MirSurface::operator delete(void *ptr, std::size_t size)
+{
+    if (size != sizeof(MirSurface)) {
+        ::operator delete(ptr);
+        return;
+    }
+    slabPoolFor<sizeof(MirSurface)>().deallocate(ptr);
+}
+
+SlabPool::Stats MirSurface::surfacePoolStats()
+{
+    return slabPoolFor<sizeof(MirSurface)>().stats();
+}
+
+SlabPool::Stats MirSurface::observerPoolStats()
+{
+    return slabPoolFor<sizeof(SurfaceObserverImpl)>().stats();
+}
+
 void MirSurface::setInputBounds(const QRect &rect)
 {
     if (m_inputBounds != rect) {
@@ -1195,15 +1382,16 @@ void MirSurface::SurfaceObserverImpl::setListener(QObject *listener)
 {
     m_listener = listener;
     if (m_framesPosted) {
-        Q_EMIT framesPosted();
+        Q_EMIT framesPosted(m_lastFrameSize);
     }
 }
 
-void MirSurface::SurfaceObserverImpl::frame_posted(int /*frames_available*/, mir::geometry::Size const& /*size*/)
+void MirSurface::SurfaceObserverImpl::frame_posted(int /*frames_available*/, mir::geometry::Size const& size)
 {
     m_framesPosted = true;
+    m_lastFrameSize = toQSize(size);
     if (m_listener) {
-        Q_EMIT framesPosted();
+        Q_EMIT framesPosted(m_lastFrameSize);
     }
 }
 
@@ -22,9 +22,11 @@
 
 // Qt
 #include <QCursor>
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QPointer>
 #include <QRect>
+#include <QScreen>
 #include <QSharedPointer>
 #include <QWeakPointer>
 #include <QSet>
@@ -32,7 +34,9 @@
 #include <QVector>
 #include <QKeyEvent>
 
+#include "framepacer.h"
 #include "mirbuffersgtexture.h"
+#include "slabpool.h"
 #include "windowcontrollerinterface.h"
 #include "windowmodelnotifier.h"
 
@@ -175,9 +179,33 @@ public:
     void setReady();
     miral::Window window() const { return m_window; }
 
+    // Interactive resizing is throttled to the pace at which the client redraws: while a configure
+    // is awaiting a frame at its size, further resize requests are coalesced into a single pending one.
+    struct ResizeStats {
+        quint64 configuresSent{0};
+        quint64 requestsCoalesced{0};
+        quint64 framesAtRequestedSize{0};
+        quint64 framesAtOtherSize{0};
+        quint64 ackTimeouts{0};
+    };
+    ResizeStats resizeStats() const { return m_resizeStats; }
+
+    // Buffers are consumed at the refresh rate of the screen showing the biggest part of the surface,
+    // whichever screens render it.
+    QScreen *pacingScreen() const { return m_pacingScreen; }
+    qreal effectiveFps() const;
+    quint64 framesHeldForPacing() const;
+
+    // Surfaces and their observers come and go constantly, so they are carved out of slab pools
+    static void *operator new(std::size_t size);
+    static void operator delete(void *ptr, std::size_t size);
+    static SlabPool::Stats surfacePoolStats();
+    static SlabPool::Stats observerPoolStats();
+
     // useful for tests
     void setCloseTimer(AbstractTimer *timer);
     std::shared_ptr<SurfaceObserver> surfaceObserver() const;
+    void setPacingRefreshRate(qreal hz);
 
 public Q_SLOTS:
     ////
@@ -192,7 +220,8 @@ public Q_SLOTS:
 private Q_SLOTS:
     void dropPendingBuffer();
     void onAttributeChanged(const MirWindowAttrib, const int);
-    void onFramesPostedObserved();
+    void onFramesPostedObserved(const QSize &frameSize);
+    void onResizeAckTimedOut();
     void emitSizeChanged();
     void setCursor(const QCursor &cursor);
     void onCloseTimedOut();
@@ -200,6 +229,8 @@ private Q_SLOTS:
 
 private:
     void syncSurfaceSizeWithItemSize();
+    void sendResize(const QSize &size);
+    void sendPendingResize();
     bool clientIsRunning() const;
     void updateExposure();
     void applyKeymap();
@@ -215,6 +246,7 @@ private:
     QPoint convertDisplayToLocalCoords(const QPoint &displayPos) const;
     QPoint convertLocalToDisplayCoords(const QPoint &localPos) const;
     void updatePosition();
+    void updatePacingScreen();
 
     // Handling of missing key release events from Qt
     bool isKeyPressed(quint32 nativeVirtualKey) const;
@@ -240,6 +272,7 @@ private:
     Mir::OrientationAngle m_orientationAngle;
 
     QTimer m_frameDropperTimer;
+    QTimer m_heldFrameTimer; // asks for a render once a frame held for pacing is due
 
     mutable QMutex m_mutex;
 
@@ -247,6 +280,10 @@ private:
     QWeakPointer<QSGTexture> m_texture;
     bool m_textureUpdated;
     unsigned int m_currentFrameNumber;
+    FramePacer m_framePacer;
+    QElapsedTimer m_pacingClock;
+
+    QPointer<QScreen> m_pacingScreen;
 
     bool m_ready{false};
     bool m_visible;
@@ -265,7 +302,10 @@ private:
     QPoint m_position;
     QPoint m_requestedPosition;
     QSize m_size;
-    QSize m_pendingResize;
+    QSize m_pendingResize; // latest requested size not sent to Mir yet
+    QSize m_resizeInFlight; // sent to Mir, client hasn't posted a frame of that size yet
+    QTimer m_resizeAckTimer;
+    ResizeStats m_resizeStats;
     QString m_keymap;
 
     QCursor m_cursor;
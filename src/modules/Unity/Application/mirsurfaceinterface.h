@@ -121,6 +121,7 @@ Q_SIGNALS:
     void framesPosted();
     void isBeingDisplayedChanged();
     void frameDropped();
+    void activeFocusChanged(bool activeFocus);
 };
 
 } // namespace qtmir
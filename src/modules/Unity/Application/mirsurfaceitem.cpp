@@ -509,7 +509,8 @@ void MirSurfaceItem::updateMirSurfaceExposure()
         return;
     }
 
-    m_surface->setViewExposure((qintptr)this, isVisible());
+    // A window which isn't exposed doesn't get rendered, eg. because its display is off
+    m_surface->setViewExposure((qintptr)this, isVisible() && (!m_window || m_window->isExposed()));
 }
 
 void MirSurfaceItem::updateMirSurfaceActiveFocus()
@@ -648,12 +649,23 @@ void MirSurfaceItem::onWindowChanged(QQuickWindow *window)
 {
     if (m_window) {
         disconnect(m_window, nullptr, this, nullptr);
+        m_window->removeEventFilter(this);
     }
     m_window = window;
     if (m_window) {
         connect(m_window, &QQuickWindow::frameSwapped, this, &MirSurfaceItem::onCompositorSwappedBuffers,
                 Qt::DirectConnection);
+        m_window->installEventFilter(this);
     }
+    updateMirSurfaceExposure();
+}
+
+bool MirSurfaceItem::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_window && event->type() == QEvent::Expose) {
+        updateMirSurfaceExposure();
+    }
+    return QQuickItem::eventFilter(watched, event);
 }
 
 void MirSurfaceItem::releaseResources()
@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "prioritypolicy.h"
+#include "application.h"
+#include "cgroupfs.h"
+
+// QPA mirserver
+#include <logging.h>
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QRunnable>
+
+// std
+#include <cerrno>
+#include <cstring>
+#include <functional>
+
+// system
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace qtmir;
+
+namespace {
+
+class Job : public QRunnable
+{
+public:
+    explicit Job(const std::function<void()> &function) : m_function(function) {}
+    void run() override { m_function(); }
+private:
+    std::function<void()> m_function;
+};
+
+QByteArray percent(int value)
+{
+    return value >= 100 ? QByteArray("max") : QByteArray::number(value) + ".00";
+}
+
+} // namespace {
+
+const int PriorityPolicy::resumeBoostMs = 1000;
+
+bool PriorityPolicy::Priority::operator==(const Priority &other) const
+{
+    return oomScoreAdj == other.oomScoreAdj
+        && cpuWeight == other.cpuWeight
+        && uclampMin == other.uclampMin
+        && uclampMax == other.uclampMax;
+}
+
+PriorityPolicy::PriorityPolicy(const QString &procPath, QObject *parent)
+    : QObject(parent)
+    , m_procPath(procPath)
+{
+    m_clock.start();
+
+    m_boostTimer.setSingleShot(true);
+    connect(&m_boostTimer, &QTimer::timeout, this, &PriorityPolicy::onBoostTimeout);
+
+    m_writer.setMaxThreadCount(1); // keeps batches in order
+}
+
+PriorityPolicy::~PriorityPolicy()
+{
+    m_writer.waitForDone();
+}
+
+void PriorityPolicy::setCGroupFs(const QSharedPointer<CGroupFs> &cgroupFs)
+{
+    Q_ASSERT(m_mode == Disabled);
+    m_writer.waitForDone();
+    m_cgroupFs = cgroupFs;
+}
+
+void PriorityPolicy::setMode(Mode mode)
+{
+    if (m_mode == mode) {
+        return;
+    }
+    m_mode = mode;
+
+    // Start afresh, what got written in another mode is irrelevant
+    const QList<Application*> applications = m_applied.keys();
+    m_applied.clear();
+    m_pending.clear();
+    m_applied.reserve(applications.count());
+    for (Application *application : applications) {
+        m_applied.insert(application, Priority{0, 0, 0, 0});
+        update(application);
+    }
+}
+
+void PriorityPolicy::addApplication(Application *application)
+{
+    if (m_applied.contains(application)) {
+        return;
+    }
+    // a priority no tier has, so that the first update always gets written
+    m_applied.insert(application, Priority{0, 0, 0, 0});
+
+    m_states.insert(application, application->internalState());
+
+    connect(application, &Application::internalStateChanged, this, [this, application](Application::InternalState state) {
+        const Application::InternalState previous = m_states.value(application);
+        m_states.insert(application, state);
+
+        bool resuming = false;
+        if (state == Application::InternalState::Running) {
+            switch (previous) {
+            case Application::InternalState::RunningInBackground:
+            case Application::InternalState::SuspendingWaitSession:
+            case Application::InternalState::SuspendingWaitProcess:
+            case Application::InternalState::Suspended:
+                resuming = true;
+                break;
+            default:
+                break;
+            }
+        }
+        if (resuming && application->focused()) {
+            setBoosted(application, true);
+        }
+        update(application);
+    });
+    connect(application, &Application::focusedChanged, this, [this, application](bool focused) {
+        if (!focused) {
+            setBoosted(application, false);
+        }
+        update(application);
+    });
+    connect(application, &Application::lifecycleLatencyMeasured, this,
+            [this, application](LifecycleMetrics::Metric metric, qint64) {
+        if (metric == LifecycleMetrics::ResumeToFirstFrame) {
+            setBoosted(application, false);
+        }
+    });
+
+    update(application);
+}
+
+void PriorityPolicy::removeApplication(Application *application)
+{
+    disconnect(application, nullptr, this, nullptr);
+    m_applied.remove(application);
+    m_states.remove(application);
+    m_pending.remove(application);
+    m_boosted.remove(application);
+}
+
+PriorityPolicy::Tier PriorityPolicy::tierOf(Application *application)
+{
+    switch (application->internalState()) {
+    case Application::InternalState::Starting:
+    case Application::InternalState::Running:
+        return application->focused() ? Focused : Visible;
+    case Application::InternalState::RunningInBackground:
+    case Application::InternalState::SuspendingWaitSession:
+    case Application::InternalState::SuspendingWaitProcess:
+        return Background;
+    default:
+        return Suspended;
+    }
+}
+
+PriorityPolicy::Priority PriorityPolicy::priorityOf(Tier tier, bool boosted)
+{
+    switch (tier) {
+    case Focused:
+        return boosted ? Priority{0, 400, 50, 100} : Priority{0, 200, 0, 100};
+    case Visible:
+        return Priority{100, 100, 0, 100};
+    case Background:
+        return Priority{300, 50, 0, 50};
+    case Suspended:
+    default:
+        return Priority{700, 10, 0, 10};
+    }
+}
+
+void PriorityPolicy::update(Application *application)
+{
+    if (m_mode == Disabled) {
+        return;
+    }
+
+    switch (application->internalState()) {
+    case Application::InternalState::Closing:
+    case Application::InternalState::StoppedResumable:
+    case Application::InternalState::Stopped:
+        return; // on its way out, nothing to gain
+    default:
+        break;
+    }
+
+    const Priority priority = priorityOf(tierOf(application), isBoosted(application));
+    if (m_applied.value(application) == priority) {
+        QMutexLocker locker(&m_mutex);
+        ++m_stats.unchangedSkipped;
+        return;
+    }
+
+    Update update{application->appId(), application->processIds(), priority};
+    if (update.pids.isEmpty()) {
+        return; // it will be applied once the application has a session and changes state again
+    }
+
+    m_applied.insert(application, priority);
+    m_pending.insert(application, update);
+    scheduleFlush();
+}
+
+void PriorityPolicy::setBoosted(Application *application, bool boosted)
+{
+    if (!boosted) {
+        if (m_boosted.remove(application) > 0) {
+            update(application);
+        }
+        return;
+    }
+
+    m_boosted.insert(application, m_clock.elapsed() + resumeBoostMs);
+    if (!m_boostTimer.isActive()) {
+        m_boostTimer.start(resumeBoostMs);
+    }
+}
+
+void PriorityPolicy::onBoostTimeout()
+{
+    const qint64 now = m_clock.elapsed();
+    qint64 nextDeadline = -1;
+
+    for (Application *application : m_boosted.keys()) {
+        const qint64 deadline = m_boosted.value(application);
+        if (deadline <= now) {
+            setBoosted(application, false);
+        } else if (nextDeadline < 0 || deadline < nextDeadline) {
+            nextDeadline = deadline;
+        }
+    }
+
+    if (nextDeadline >= 0) {
+        m_boostTimer.start(nextDeadline - now);
+    }
+}
+
+void PriorityPolicy::scheduleFlush()
+{
+    if (!m_flushScheduled) {
+        m_flushScheduled = true;
+        QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+    }
+}
+
+void PriorityPolicy::flush()
+{
+    m_flushScheduled = false;
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    const QVector<Update> batch = m_pending.values().toVector();
+    m_pending.clear();
+
+    const bool dryRun = m_mode == DryRun;
+    m_writer.start(new Job([this, batch, dryRun]() { apply(batch, dryRun); }));
+}
+
+// Runs on the writer thread
+void PriorityPolicy::apply(const QVector<Update> &batch, bool dryRun)
+{
+    for (const Update &update : batch) {
+        qCDebug(QTMIR_APPLICATIONS) << "PriorityPolicy - appId=" << update.appId
+                                    << "oomScoreAdj=" << update.priority.oomScoreAdj
+                                    << "cpuWeight=" << update.priority.cpuWeight;
+
+        const QByteArray oomScoreAdj = QByteArray::number(update.priority.oomScoreAdj);
+        for (pid_t pid : update.pids) {
+            write(QStringLiteral("%1/%2/oom_score_adj").arg(m_procPath).arg(pid), oomScoreAdj, dryRun);
+        }
+
+        if (!m_cgroupFs) {
+            continue;
+        }
+
+        // Only touch cgroups belonging to the application alone, not the whole session
+        const QString cgroup = m_cgroupFs->cgroupOfPid(QStringLiteral("cpu"), update.pids.first());
+        if (!CGroupFs::isApplicationCGroup(cgroup)) {
+            continue;
+        }
+        bool unified = false;
+        const QString directory = m_cgroupFs->controlDirectory(QStringLiteral("cpu"), cgroup, &unified);
+        if (directory.isEmpty()) {
+            continue;
+        }
+
+        if (unified) {
+            write(directory + QStringLiteral("/cpu.weight"), QByteArray::number(update.priority.cpuWeight), dryRun);
+        } else {
+            // cpu.shares is 1024 by default where cpu.weight is 100
+            write(directory + QStringLiteral("/cpu.shares"),
+                  QByteArray::number(qMax(2, update.priority.cpuWeight * 1024 / 100)), dryRun);
+        }
+        write(directory + QStringLiteral("/cpu.uclamp.min"), percent(update.priority.uclampMin), dryRun);
+        write(directory + QStringLiteral("/cpu.uclamp.max"), percent(update.priority.uclampMax), dryRun);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    ++m_stats.batches;
+}
+
+// Runs on the writer thread
+void PriorityPolicy::write(const QString &path, const QByteArray &value, bool dryRun)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_stats.writes;
+        if (dryRun) {
+            m_dryRunWrites.append(Write{path, value});
+            return;
+        }
+    }
+
+    // Unbuffered, so that a refused value is noticed here rather than lost when closing
+    int error = 0;
+    const int fd = ::open(QFile::encodeName(path).constData(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = errno;
+    } else {
+        if (::write(fd, value.constData(), value.size()) != value.size()) {
+            error = errno;
+        }
+        ::close(fd);
+    }
+
+    if (error == 0) {
+        return;
+    }
+
+    // Processes may be gone already and uclamp is not supported by every kernel, that's fine
+    if (error == ENOENT || error == ESRCH) {
+        qCDebug(QTMIR_APPLICATIONS) << "PriorityPolicy - unable to write" << value << "to" << path;
+        return;
+    }
+
+    qCWarning(QTMIR_APPLICATIONS) << "PriorityPolicy - unable to write" << value << "to" << path
+                                  << ":" << strerror(error);
+    QMutexLocker locker(&m_mutex);
+    ++m_stats.failedWrites;
+}
+
+void PriorityPolicy::waitForWrites()
+{
+    flush();
+    m_writer.waitForDone();
+}
+
+QList<PriorityPolicy::Write> PriorityPolicy::dryRunWrites() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dryRunWrites;
+}
+
+PriorityPolicy::Stats PriorityPolicy::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
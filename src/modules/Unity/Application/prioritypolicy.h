@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_PRIORITYPOLICY_H
+#define QTMIR_PRIORITYPOLICY_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+#include <sys/types.h>
+
+#include "application.h"
+
+namespace qtmir {
+
+class CGroupFs;
+
+/*
+  Tells the kernel which applications matter most, so that the focused one gets the CPU and the
+  ones in the background are the first to go when memory runs out.
+
+  Each application is put in a tier from its lifecycle state and focus. Its processes then get the
+  oom_score_adj of that tier and, if the application has a cgroup to itself, the cgroup gets the
+  matching cpu.weight (cpu.shares with the v1 controller) and utilization clamps. The focused
+  application is boosted while it resumes, until its first frame or resumeBoostMs at most.
+
+  Changes are gathered over an event loop iteration and written in a batch off the GUI thread.
+  Applications whose priority didn't change are left alone. In dry run mode nothing is written,
+  the writes that would have been made are recorded instead.
+
+  Disabled unless asked for: the task controller may manage oom_score_adj itself when pausing and
+  resuming applications, raising oom_score_adj_min so that lower values get refused. Such refusals
+  are counted as failed writes and warned about.
+ */
+class PriorityPolicy : public QObject
+{
+    Q_OBJECT
+public:
+    enum Tier {
+        Focused,
+        Visible,
+        Background, // running in background or on its way to being suspended
+        Suspended,
+        TierCount
+    };
+
+    enum Mode {
+        Disabled,
+        DryRun,
+        Enabled
+    };
+
+    struct Priority {
+        int oomScoreAdj;
+        int cpuWeight; // 1-10000, 100 being the kernel default
+        int uclampMin; // percent
+        int uclampMax; // percent
+
+        bool operator==(const Priority &other) const;
+        bool operator!=(const Priority &other) const { return !(*this == other); }
+    };
+
+    struct Write {
+        QString path;
+        QByteArray value;
+    };
+
+    struct Stats {
+        quint64 batches{0};
+        quint64 writes{0};
+        quint64 unchangedSkipped{0}; // application updates which didn't need any write
+        quint64 failedWrites{0}; // refused, not counting processes which were already gone
+    };
+
+    explicit PriorityPolicy(const QString &procPath = QStringLiteral("/proc"), QObject *parent = nullptr);
+    virtual ~PriorityPolicy();
+
+    // Without it only oom_score_adj is written. Must be set while disabled.
+    void setCGroupFs(const QSharedPointer<CGroupFs> &cgroupFs);
+
+    void setMode(Mode mode);
+    Mode mode() const { return m_mode; }
+
+    void addApplication(Application *application);
+    void removeApplication(Application *application);
+
+    static Tier tierOf(Application *application);
+    static Priority priorityOf(Tier tier, bool boosted);
+
+    bool isBoosted(Application *application) const { return m_boosted.contains(application); }
+
+    // Blocks until all batches handed to the writer thread are done
+    void waitForWrites();
+
+    // Writes recorded in dry run mode, oldest first
+    QList<Write> dryRunWrites() const;
+
+    Stats stats() const;
+
+    static const int resumeBoostMs;
+
+public Q_SLOTS:
+    // Hands all pending changes to the writer thread right away
+    void flush();
+
+private Q_SLOTS:
+    void onBoostTimeout();
+
+private:
+    struct Update {
+        QString appId;
+        QVector<pid_t> pids;
+        Priority priority;
+    };
+
+    void update(Application *application);
+    void setBoosted(Application *application, bool boosted);
+    void scheduleFlush();
+    void apply(const QVector<Update> &batch, bool dryRun);
+    void write(const QString &path, const QByteArray &value, bool dryRun);
+
+    QSharedPointer<CGroupFs> m_cgroupFs;
+    const QString m_procPath;
+    Mode m_mode{Disabled};
+
+    QHash<Application*, Priority> m_applied;
+    QHash<Application*, Application::InternalState> m_states; // as last seen, to tell resumes apart
+    QHash<Application*, Update> m_pending;
+    QHash<Application*, qint64> m_boosted; // boost deadline, in ms since m_clock started
+    QElapsedTimer m_clock;
+    QTimer m_boostTimer;
+    bool m_flushScheduled{false};
+
+    QThreadPool m_writer;
+    mutable QMutex m_mutex; // guards what the writer thread touches
+    QList<Write> m_dryRunWrites;
+    Stats m_stats;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_PRIORITYPOLICY_H
@@ -17,77 +17,258 @@
 #include "proc_info.h"
 
 // Qt
-#include <QFile>
-#include <QRegularExpression>
+#include <QString>
+
+// std
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+// system
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace qtmir
 {
 
+namespace {
+
+// Views into buffer of each NUL terminated entry. Doesn't copy any data.
+QVector<QByteArray> splitNulSeparated(const QByteArray &buffer)
+{
+    QVector<QByteArray> entries;
+
+    const char *const data = buffer.constData();
+    const int size = buffer.size();
+    int entryStart = 0;
+    for (int i = 0; i < size; ++i) {
+        if (data[i] == '\0') {
+            entries.append(QByteArray::fromRawData(data + entryStart, i - entryStart));
+            entryStart = i + 1;
+        }
+    }
+    if (entryStart < size) { // last entry not terminated
+        entries.append(QByteArray::fromRawData(data + entryStart, size - entryStart));
+    }
+
+    return entries;
+}
+
+} // namespace {
+
+bool ProcInfo::readProcFile(pid_t pid, const char *name, QByteArray &contents)
+{
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/%s", pid, name);
+
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    // The file reports a size of 0, so read until EOF. Most command lines fit in the first read.
+    contents.resize(4096);
+    int size = 0;
+    for (;;) {
+        const ssize_t count = ::read(fd, contents.data() + size, contents.size() - size);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ::close(fd);
+            return false;
+        }
+        if (count == 0) {
+            break;
+        }
+        size += count;
+        if (size == contents.size()) {
+            contents.resize(size * 2);
+        }
+    }
+    ::close(fd);
+
+    contents.resize(size);
+    return true;
+}
+
 std::unique_ptr<ProcInfo::CommandLine> ProcInfo::commandLine(pid_t pid)
 {
-    QFile cmdline(QStringLiteral("/proc/%1/cmdline").arg(pid));
-    if (!cmdline.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    QByteArray contents;
+    if (!readProcFile(pid, "cmdline", contents)) {
         return nullptr;
     }
 
-    return std::unique_ptr<CommandLine>(new CommandLine{ cmdline.readLine().replace('\0', ' ') });
+    return std::unique_ptr<CommandLine>(new CommandLine(contents));
+}
+
+ProcInfo::CommandLine::CommandLine(const QByteArray &nulSeparated)
+    : m_buffer(nulSeparated)
+    , m_arguments(splitNulSeparated(m_buffer))
+{
 }
 
 QStringList ProcInfo::CommandLine::asStringList() const
 {
-    return QString(m_command.data()).split(' ');
+    QStringList list;
+    list.reserve(m_arguments.count());
+    for (const QByteArray &argument : m_arguments) {
+        list.append(QString::fromUtf8(argument));
+    }
+    return list;
 }
 
 bool ProcInfo::CommandLine::startsWith(char const* prefix) const
 {
-    return m_command.startsWith(prefix);
+    return !m_arguments.isEmpty() && m_arguments.first().startsWith(prefix);
 }
 
-bool ProcInfo::CommandLine::contains(char const* prefix) const
+bool ProcInfo::CommandLine::contains(char const* text) const
 {
-    return m_command.contains(prefix);
+    for (const QByteArray &argument : m_arguments) {
+        if (argument.contains(text)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 QString ProcInfo::CommandLine::getParameter(const char* name) const
 {
-    QString pattern = QRegularExpression::escape(name) + "(\\S+)";
-    QRegularExpression regExp(pattern);
-    QRegularExpressionMatch regExpMatch = regExp.match(m_command);
-
-    if (!regExpMatch.hasMatch()) {
-        return QString();
+    // The value is the rest of the argument the name is found in, spaces included
+    const QByteArray needle = QByteArray::fromRawData(name, std::strlen(name));
+    for (const QByteArray &argument : m_arguments) {
+        const int index = argument.indexOf(needle);
+        if (index < 0) {
+            continue;
+        }
+        const int valueStart = index + needle.size();
+        if (valueStart < argument.size()) {
+            return QString::fromUtf8(argument.constData() + valueStart, argument.size() - valueStart);
+        }
     }
-
-    return QString(regExpMatch.captured(1));
+    return QString();
 }
 
 
 std::unique_ptr<ProcInfo::Environment> ProcInfo::environment(pid_t pid)
 {
-    QFile environment(QStringLiteral("/proc/%1/environ").arg(pid));
-    if (!environment.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    QByteArray contents;
+    if (!readProcFile(pid, "environ", contents)) {
         return nullptr;
     }
 
-    return std::unique_ptr<Environment>(new Environment{ environment.readLine().replace('\0', ' ') });
+    return std::unique_ptr<Environment>(new Environment(contents));
 }
 
-bool ProcInfo::Environment::contains(char const* prefix) const
+ProcInfo::Environment::Environment(const QByteArray &nulSeparated)
+    : m_buffer(nulSeparated)
 {
-    return m_environment.contains(prefix);
+    const QVector<QByteArray> entries = splitNulSeparated(m_buffer);
+    m_variables.reserve(entries.count());
+    for (const QByteArray &entry : entries) {
+        const int separator = entry.indexOf('=');
+        if (separator <= 0) {
+            continue;
+        }
+        // first definition wins, like getenv()
+        const QByteArray key = QByteArray::fromRawData(entry.constData(), separator);
+        if (!m_variables.contains(key)) {
+            m_variables.insert(key, QByteArray::fromRawData(entry.constData() + separator + 1,
+                                                            entry.size() - separator - 1));
+        }
+    }
 }
 
-QString ProcInfo::Environment::getParameter(const char* name) const
+bool ProcInfo::Environment::contains(char const* name) const
 {
-    QString pattern = QRegularExpression::escape(name) + "=(\\S+)";
-    QRegularExpression regExp(pattern);
-    QRegularExpressionMatch regExpMatch = regExp.match(m_environment);
+    return m_variables.contains(QByteArray::fromRawData(name, std::strlen(name)));
+}
 
-    if (!regExpMatch.hasMatch()) {
+QString ProcInfo::Environment::getParameter(const char* name) const
+{
+    auto it = m_variables.constFind(QByteArray::fromRawData(name, std::strlen(name)));
+    if (it == m_variables.constEnd()) {
         return QString();
     }
+    return QString::fromUtf8(it.value());
+}
+
+ProcInfo::MemoryUsage ProcInfo::memoryUsage(pid_t pid)
+{
+    QByteArray contents;
+    if (readProcFile(pid, "smaps_rollup", contents)) {
+        return MemoryUsage::fromSmapsRollup(contents);
+    }
 
-    return QString(regExpMatch.captured(1));
+    MemoryUsage usage;
+    if (readProcFile(pid, "statm", contents)) {
+        // size resident shared text lib data dt, in pages
+        const QList<QByteArray> fields = contents.split(' ');
+        if (fields.count() > 1) {
+            usage.rssBytes = fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+            usage.pssBytes = usage.rssBytes;
+        }
+    }
+    return usage;
+}
+
+qint64 ProcInfo::cpuTimeMs(pid_t pid)
+{
+    QByteArray contents;
+    if (!readProcFile(pid, "stat", contents)) {
+        return -1;
+    }
+    return cpuTimeMsFromStat(contents);
+}
+
+qint64 ProcInfo::cpuTimeMsFromStat(const QByteArray &contents)
+{
+    // "pid (comm) state ppid ...", where comm may contain spaces and parentheses itself.
+    // utime and stime are the 14th and 15th fields, in clock ticks.
+    const int commEnd = contents.lastIndexOf(')');
+    if (commEnd < 0) {
+        return -1;
+    }
+
+    const QList<QByteArray> fields = contents.mid(commEnd + 2).split(' ');
+    const int utimeIndex = 14 - 3; // fields here start at the 3rd one, state
+    if (fields.count() <= utimeIndex + 1) {
+        return -1;
+    }
+
+    static const qint64 ticksPerSecond = sysconf(_SC_CLK_TCK);
+    const qint64 ticks = fields[utimeIndex].toLongLong() + fields[utimeIndex + 1].toLongLong();
+    return ticks * 1000 / ticksPerSecond;
+}
+
+ProcInfo::MemoryUsage ProcInfo::MemoryUsage::fromSmapsRollup(const QByteArray &contents)
+{
+    // The first line describes the mapping range, then come "Name:   value kB" lines
+    MemoryUsage usage;
+    int lineStart = 0;
+    while (lineStart < contents.size()) {
+        int lineEnd = contents.indexOf('\n', lineStart);
+        if (lineEnd < 0) {
+            lineEnd = contents.size();
+        }
+        const QByteArray line = QByteArray::fromRawData(contents.constData() + lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        qint64 *field = nullptr;
+        if (line.startsWith("Rss:")) {
+            field = &usage.rssBytes;
+        } else if (line.startsWith("Pss:")) {
+            field = &usage.pssBytes;
+        } else {
+            continue;
+        }
+
+        const QByteArray value = line.mid(4).trimmed();
+        const int unit = value.indexOf(' ');
+        *field = (unit < 0 ? value : value.left(unit)).toLongLong() * 1024;
+    }
+    return usage;
 }
 
 } // namespace qtmir
@@ -24,7 +24,9 @@
 
 // Qt
 #include <QByteArray>
+#include <QHash>
 #include <QStringList>
+#include <QVector>
 
 class QString;
 
@@ -34,25 +36,59 @@ namespace qtmir
 class ProcInfo
 {
 public:
+    // Arguments of a process, split on the NULs of /proc/<pid>/cmdline. The arguments are views
+    // into a single buffer holding the file contents.
     struct CommandLine {
-        QByteArray m_command;
+        explicit CommandLine(const QByteArray &nulSeparated);
 
         bool startsWith(const char* prefix) const;
-        bool contains(const char* prefix) const;
+        bool contains(const char* text) const;
         QString getParameter(const char* name) const;
         QStringList asStringList() const;
+
+        const QVector<QByteArray> &arguments() const { return m_arguments; }
+
+    private:
+        QByteArray m_buffer;
+        QVector<QByteArray> m_arguments;
     };
 
+    // Variables of a process, from /proc/<pid>/environ. Keys and values are views into a single
+    // buffer holding the file contents, indexed by key.
     struct Environment {
-        QByteArray m_environment;
+        explicit Environment(const QByteArray &nulSeparated);
 
-        bool contains(const char* prefix) const;
+        bool contains(const char* name) const;
         QString getParameter(const char* name) const;
+
+    private:
+        QByteArray m_buffer;
+        QHash<QByteArray, QByteArray> m_variables;
+    };
+
+    // Memory used by a process, from /proc/<pid>/smaps_rollup. Kernels older than 4.14 don't have
+    // that file, then only the resident set size is known, from /proc/<pid>/statm.
+    struct MemoryUsage {
+        qint64 rssBytes{0};
+        qint64 pssBytes{0}; // proportional set size, shared pages split among their users
+
+        bool isValid() const { return rssBytes > 0; }
+
+        static MemoryUsage fromSmapsRollup(const QByteArray &contents);
     };
 
     virtual std::unique_ptr<CommandLine> commandLine(pid_t pid);
     virtual std::unique_ptr<Environment> environment(pid_t pid);
+    virtual MemoryUsage memoryUsage(pid_t pid);
+
+    // CPU time, user and system, a process has used so far, from /proc/<pid>/stat. -1 if unknown.
+    virtual qint64 cpuTimeMs(pid_t pid);
+    static qint64 cpuTimeMsFromStat(const QByteArray &contents);
+
     virtual ~ProcInfo() = default;
+
+    // Reads the whole of /proc/<pid>/<name>, which the kernel generates on the fly
+    static bool readProcFile(pid_t pid, const char *name, QByteArray &contents);
 };
 
 } // namespace qtmir
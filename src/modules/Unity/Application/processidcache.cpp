@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "processidcache.h"
+
+#include <QMutexLocker>
+
+using namespace qtmir;
+
+quint64 ProcessIdCache::generation(const QString &appId) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_generations.value(appId);
+}
+
+void ProcessIdCache::insert(const QString &appId, quint64 generation, const QVector<pid_t> &pids)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_generations.value(appId) != generation) {
+        return;
+    }
+    for (pid_t pid : pids) {
+        m_appIdForPid.insert(pid, appId);
+    }
+}
+
+void ProcessIdCache::insert(const QString &appId, quint64 generation, pid_t pid)
+{
+    insert(appId, generation, QVector<pid_t>{pid});
+}
+
+void ProcessIdCache::removeApp(const QString &appId)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_generations[appId];
+    auto it = m_appIdForPid.begin();
+    while (it != m_appIdForPid.end()) {
+        if (it.value() == appId) {
+            it = m_appIdForPid.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+QString ProcessIdCache::appIdFor(pid_t pid) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_appIdForPid.constFind(pid);
+    if (it == m_appIdForPid.constEnd()) {
+        ++m_stats.misses;
+        return QString();
+    }
+    ++m_stats.hits;
+    return it.value();
+}
+
+ProcessIdCache::Stats ProcessIdCache::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_PROCESSIDCACHE_H
+#define QTMIR_PROCESSIDCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <sys/types.h>
+
+namespace qtmir {
+
+/*
+  Remembers which application each known process belongs to, so that authorizing a new client
+  connection doesn't have to ask the task controller about every starting application.
+
+  Each application has a generation, bumped whenever it gets removed. Resolving processes takes a
+  while, inserting with the generation read beforehand drops results which arrive after the
+  application stopped, as its pids may have been recycled by then.
+
+  Thread safety: all methods may be called from any thread.
+ */
+class ProcessIdCache
+{
+public:
+    struct Stats {
+        quint64 hits{0};
+        quint64 misses{0};
+    };
+
+    quint64 generation(const QString &appId) const;
+
+    // Do nothing if the application got removed since the given generation
+    void insert(const QString &appId, quint64 generation, const QVector<pid_t> &pids);
+    void insert(const QString &appId, quint64 generation, pid_t pid);
+    void removeApp(const QString &appId);
+
+    // Returns a null string if the process is not known
+    QString appIdFor(pid_t pid) const;
+
+    Stats stats() const;
+
+private:
+    mutable QMutex m_mutex;
+    QHash<pid_t, QString> m_appIdForPid;
+    QHash<QString, quint64> m_generations;
+    mutable Stats m_stats;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_PROCESSIDCACHE_H
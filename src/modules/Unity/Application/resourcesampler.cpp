@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resourcesampler.h"
+#include "application.h"
+#include "cgroupfs.h"
+#include "proc_info.h"
+
+// QPA mirserver
+#include <logging.h>
+
+#include <QElapsedTimer>
+
+// Unity API
+#include <unity/shell/application/MirSurfaceInterface.h>
+#include <unity/shell/application/MirSurfaceListInterface.h>
+
+using namespace qtmir;
+
+namespace {
+
+// Below these, changes are noise not worth updating the model for
+const int cpuPercentThreshold = 2;
+const qint64 memoryBytesThreshold = 1024 * 1024;
+
+bool differs(qint64 a, qint64 b, qint64 threshold)
+{
+    return qAbs(a - b) >= threshold;
+}
+
+} // namespace {
+
+bool ResourceUsage::differsSignificantlyFrom(const ResourceUsage &other) const
+{
+    return differs(cpuPercent, other.cpuPercent, cpuPercentThreshold)
+        || differs(rssBytes, other.rssBytes, memoryBytesThreshold)
+        || differs(pssBytes, other.pssBytes, memoryBytesThreshold)
+        || differs(cgroupMemoryBytes, other.cgroupMemoryBytes, memoryBytesThreshold)
+        || bufferBytes != other.bufferBytes;
+}
+
+QVariantMap ResourceUsage::toVariantMap() const
+{
+    QVariantMap map;
+    map.insert(QStringLiteral("cpuPercent"), cpuPercent);
+    map.insert(QStringLiteral("rssBytes"), rssBytes);
+    map.insert(QStringLiteral("pssBytes"), pssBytes);
+    map.insert(QStringLiteral("cgroupMemoryBytes"), cgroupMemoryBytes);
+    map.insert(QStringLiteral("bufferBytes"), bufferBytes);
+    return map;
+}
+
+/////////////////////////////////// Worker ///////////////////////////////////
+
+class ResourceSampler::Worker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Worker(const QSharedPointer<ProcInfo> &procInfo)
+        : m_procInfo(procInfo)
+    {
+        m_clock.start();
+    }
+
+public Q_SLOTS:
+    void sample(const QVector<qtmir::ResourceSampler::Target> &targets)
+    {
+        const qint64 now = m_clock.elapsed();
+
+        QHash<QString, ResourceUsage> changed;
+        QHash<QString, CpuSample> cpuSamples;
+        QStringList removed = m_published.keys();
+
+        for (const Target &target : targets) {
+            removed.removeAll(target.appId);
+
+            ResourceUsage usage;
+            usage.bufferBytes = target.bufferBytes;
+
+            CpuSample cpu{now, 0};
+            for (pid_t pid : target.pids) {
+                cpu.cpuTimeMs += qMax<qint64>(0, m_procInfo->cpuTimeMs(pid));
+                const ProcInfo::MemoryUsage memory = m_procInfo->memoryUsage(pid);
+                usage.rssBytes += memory.rssBytes;
+                usage.pssBytes += memory.pssBytes;
+            }
+            cpuSamples.insert(target.appId, cpu);
+
+            auto previous = m_cpuSamples.constFind(target.appId);
+            if (previous != m_cpuSamples.constEnd() && now > previous->timeMs) {
+                // processes going away make the total go down, count that as idle
+                const qint64 used = qMax<qint64>(0, cpu.cpuTimeMs - previous->cpuTimeMs);
+                usage.cpuPercent = static_cast<int>(used * 100 / (now - previous->timeMs));
+            }
+
+            if (m_cgroupFs && !target.pids.isEmpty()) {
+                const QString cgroup = m_cgroupFs->cgroupOfPid(QStringLiteral("memory"), target.pids.first());
+                if (CGroupFs::isApplicationCGroup(cgroup)) {
+                    usage.cgroupMemoryBytes = m_cgroupFs->memoryUsage(cgroup);
+                }
+            }
+
+            auto published = m_published.constFind(target.appId);
+            if (published == m_published.constEnd() || usage.differsSignificantlyFrom(published.value())) {
+                m_published.insert(target.appId, usage);
+                changed.insert(target.appId, usage);
+            }
+        }
+
+        for (const QString &appId : removed) {
+            m_published.remove(appId);
+        }
+        m_cpuSamples = cpuSamples;
+
+        Q_EMIT sampled(changed, removed);
+    }
+
+Q_SIGNALS:
+    void sampled(const QHash<QString, qtmir::ResourceUsage> &changed, const QStringList &removed);
+
+private:
+    friend class ResourceSampler;
+
+    struct CpuSample {
+        qint64 timeMs;
+        qint64 cpuTimeMs;
+    };
+
+    const QSharedPointer<ProcInfo> m_procInfo;
+    QSharedPointer<CGroupFs> m_cgroupFs; // only set before the thread starts
+    QElapsedTimer m_clock;
+    QHash<QString, CpuSample> m_cpuSamples;
+    QHash<QString, ResourceUsage> m_published; // what the GUI thread knows
+};
+
+/////////////////////////////////// ResourceSampler ///////////////////////////////////
+
+ResourceSampler::ResourceSampler(const QSharedPointer<ProcInfo> &procInfo, QObject *parent)
+    : QObject(parent)
+    , m_worker(new Worker(procInfo))
+{
+    qRegisterMetaType<qtmir::ResourceSampler::Target>();
+    qRegisterMetaType<QVector<qtmir::ResourceSampler::Target>>();
+    qRegisterMetaType<QHash<QString, qtmir::ResourceUsage>>();
+
+    m_thread.setObjectName(QStringLiteral("ResourceSampler"));
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &Worker::sampled, this, &ResourceSampler::onSampled, Qt::QueuedConnection);
+
+    connect(&m_timer, &QTimer::timeout, this, &ResourceSampler::sample);
+    m_timer.setTimerType(Qt::CoarseTimer);
+}
+
+ResourceSampler::~ResourceSampler()
+{
+    if (!m_thread.isRunning() && !m_thread.isFinished()) {
+        // Never sampled, so the thread won't delete it as it finishes
+        delete m_worker;
+        return;
+    }
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void ResourceSampler::setCGroupFs(const QSharedPointer<CGroupFs> &cgroupFs)
+{
+    Q_ASSERT(!m_thread.isRunning());
+    m_worker->m_cgroupFs = cgroupFs;
+}
+
+void ResourceSampler::setInterval(int intervalMs)
+{
+    if (intervalMs <= 0) {
+        m_timer.stop();
+    } else {
+        m_timer.start(intervalMs);
+    }
+}
+
+void ResourceSampler::addApplication(Application *application)
+{
+    if (!m_applications.contains(application)) {
+        m_applications.append(application);
+    }
+}
+
+void ResourceSampler::removeApplication(Application *application)
+{
+    m_applications.removeAll(application);
+    // its usage is dropped once the worker reports it gone
+}
+
+ResourceSampler::Target ResourceSampler::targetFor(Application *application)
+{
+    Target target;
+    target.appId = application->appId();
+
+    target.pids = application->processIds();
+
+    auto surfaceList = application->surfaceList();
+    for (int i = 0; i < surfaceList->count(); ++i) {
+        const QSize size = surfaceList->get(i)->size();
+        target.bufferBytes += qint64(size.width()) * size.height() * 4 * buffersPerSurface;
+    }
+
+    return target;
+}
+
+void ResourceSampler::sample()
+{
+    // Don't queue up work if the worker can't keep up
+    if (m_sampling) {
+        return;
+    }
+
+    if (!m_thread.isRunning()) {
+        m_thread.start(QThread::LowPriority);
+    }
+
+    QVector<Target> targets;
+    targets.reserve(m_applications.count());
+    for (Application *application : m_applications) {
+        targets.append(targetFor(application));
+    }
+
+    m_sampling = true;
+    QMetaObject::invokeMethod(m_worker, "sample", Qt::QueuedConnection,
+                              Q_ARG(QVector<qtmir::ResourceSampler::Target>, targets));
+}
+
+void ResourceSampler::onSampled(const QHash<QString, ResourceUsage> &changed, const QStringList &removed)
+{
+    m_sampling = false;
+
+    for (const QString &appId : removed) {
+        m_usage.remove(appId);
+    }
+    for (auto it = changed.constBegin(); it != changed.constEnd(); ++it) {
+        m_usage.insert(it.key(), it.value());
+    }
+
+    if (!changed.isEmpty()) {
+        qCDebug(QTMIR_APPLICATIONS) << "ResourceSampler - usage changed for" << changed.keys();
+        Q_EMIT usageChanged(changed.keys());
+    }
+}
+
+#include "resourcesampler.moc"
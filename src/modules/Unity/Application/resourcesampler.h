@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_RESOURCESAMPLER_H
+#define QTMIR_RESOURCESAMPLER_H
+
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QObject>
+#include <QSharedPointer>
+#include <QThread>
+#include <QTimer>
+#include <QVariantMap>
+#include <QVector>
+
+#include <sys/types.h>
+
+namespace qtmir {
+
+class Application;
+class CGroupFs;
+class ProcInfo;
+
+// Compact summary of what an application uses, summed over all its processes
+struct ResourceUsage
+{
+    int cpuPercent{0}; // of a single core, since the previous sample
+    qint64 rssBytes{0};
+    qint64 pssBytes{0};
+    qint64 cgroupMemoryBytes{-1}; // page cache included. -1 unless the app has a cgroup to itself
+    qint64 bufferBytes{0}; // estimated, from the size of its surfaces
+
+    // Whether the difference is worth telling the GUI about
+    bool differsSignificantlyFrom(const ResourceUsage &other) const;
+    QVariantMap toVariantMap() const;
+};
+
+/*
+  Periodically samples the CPU, memory and graphics buffer usage of applications.
+
+  The GUI thread only gathers what it alone knows (process ids and surface sizes), everything
+  read from /proc and cgroupfs is read by a worker thread. Back on the GUI thread only the
+  applications whose usage changed significantly since last time get updated.
+ */
+class ResourceSampler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ResourceSampler(const QSharedPointer<ProcInfo> &procInfo, QObject *parent = nullptr);
+    virtual ~ResourceSampler();
+
+    // Also report the memory charged to the cgroup of each application, page cache included.
+    // Must be called before sampling starts.
+    void setCGroupFs(const QSharedPointer<CGroupFs> &cgroupFs);
+
+    // 0 stops sampling
+    void setInterval(int intervalMs);
+    int interval() const { return m_timer.isActive() ? m_timer.interval() : 0; }
+
+    void addApplication(Application *application);
+    void removeApplication(Application *application);
+
+    // Latest known usage. Default constructed if not sampled yet.
+    ResourceUsage usage(const QString &appId) const { return m_usage.value(appId); }
+
+    // What gets handed to the worker for each application
+    struct Target {
+        QString appId;
+        QVector<pid_t> pids;
+        qint64 bufferBytes{0};
+    };
+    static Target targetFor(Application *application);
+
+    // Mir streams are triple buffered by default, 4 bytes per pixel
+    static const int buffersPerSurface = 3;
+
+public Q_SLOTS:
+    void sample();
+
+Q_SIGNALS:
+    void usageChanged(const QStringList &appIds);
+
+private Q_SLOTS:
+    void onSampled(const QHash<QString, qtmir::ResourceUsage> &changed, const QStringList &removed);
+
+private:
+    class Worker;
+
+    QList<Application*> m_applications;
+    QHash<QString, ResourceUsage> m_usage;
+    QTimer m_timer;
+    QThread m_thread;
+    Worker *m_worker;
+    bool m_sampling{false};
+};
+
+} // namespace qtmir
+
+Q_DECLARE_METATYPE(qtmir::ResourceUsage)
+Q_DECLARE_METATYPE(qtmir::ResourceSampler::Target)
+
+#endif // QTMIR_RESOURCESAMPLER_H
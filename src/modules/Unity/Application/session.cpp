@@ -17,6 +17,7 @@
 // local
 #include "application.h"
 #include "debughelpers.h"
+#include "lifecyclescheduler.h"
 #include "session.h"
 #include "mirsurfaceinterface.h"
 #include "mirsurfaceitem.h"
@@ -77,7 +78,7 @@ Session::Session(const std::shared_ptr<ms::Session>& session,
 {
     DEBUG_MSG << "()";
 
-    setSuspendTimer(new Timer);
+    setSuspendTimer(new BatchedTimer);
 
     connect(&m_surfaceList, &MirSurfaceListModel::emptyChanged, this, &Session::deleteIfZombieAndEmpty);
 }
@@ -114,6 +115,13 @@ void Session::doSuspend()
             surface->stopFrameDropper();
         }
     }
+
+    if (m_suspendRequested.isValid()) {
+        LifecycleScheduler::instance()->recordTransition(LifecycleScheduler::SessionSuspend,
+                                                         m_suspendRequested.elapsed());
+        m_suspendRequested.invalidate();
+    }
+
     setState(Suspended);
 }
 
@@ -299,6 +307,7 @@ void Session::suspend()
     DEBUG_MSG << " state=" << sessionStateToString(m_state);
     if (m_state == Running) {
         miral::apply_lifecycle_state_to(session(), mir_lifecycle_state_will_suspend);
+        m_suspendRequested.start();
         m_suspendTimer->start();
 
         foreachPromptSession([this](const qtmir::PromptSession &promptSession) {
@@ -27,6 +27,7 @@
 #include "timer.h"
 
 // Qt
+#include <QElapsedTimer>
 #include <QObject>
 
 
@@ -118,6 +119,7 @@ protected:
     State m_state;
     bool m_live;
     AbstractTimer* m_suspendTimer{nullptr};
+    QElapsedTimer m_suspendRequested;
     QVector<PromptSession> m_promptSessions;
     std::shared_ptr<PromptSessionManager> const m_promptSessionManager;
     QList<MirSurfaceInterface*> m_closingSurfaces;
@@ -22,12 +22,71 @@
 #include <QDBusPendingCallWatcher>
 #include <QDBusPendingReply>
 #include <QFile>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThreadPool>
 
 namespace qtmir {
 
 const int POWERD_SYS_STATE_ACTIVE = 1; // copied from private header file powerd.h
 const char cookieFile[] = "/tmp/qtmir_powerd_cookie";
 
+/**
+ * @brief The CookieCache class - saves or removes the wakelock cookie file off the GUI thread
+ * Operations are carried out in the order they were requested. Files are replaced atomically, so
+ * a crash never leaves a truncated cookie behind.
+ */
+class CookieCache
+{
+public:
+    CookieCache()
+    {
+        m_pool.setMaxThreadCount(1); // keeps operations in order
+    }
+
+    ~CookieCache()
+    {
+        m_pool.waitForDone();
+    }
+
+    void save(const QByteArray &cookie)
+    {
+        ++m_writes;
+        run([cookie]() {
+            QSaveFile file(cookieFile);
+            if (!file.open(QFile::WriteOnly | QFile::Text) || file.write(cookie) != cookie.size() || !file.commit()) {
+                qCWarning(QTMIR_SESSIONS) << "Wakelock - unable to save cookie to" << cookieFile;
+            }
+        });
+    }
+
+    void remove()
+    {
+        ++m_writes;
+        run([]() { QFile::remove(cookieFile); });
+    }
+
+    quint64 writes() const { return m_writes; }
+
+private:
+    template<typename F>
+    void run(F function)
+    {
+        class Job : public QRunnable
+        {
+        public:
+            Job(F function) : m_function(function) {}
+            void run() override { m_function(); }
+        private:
+            F m_function;
+        };
+        m_pool.start(new Job(function));
+    }
+
+    QThreadPool m_pool;
+    quint64 m_writes{0};
+};
+
 /**
  * @brief The Wakelock class - wraps a single system wakelock
  * Should the PowerD service vanish from the bus, the wakelock will be re-acquired when it re-joins the bus.
@@ -58,6 +117,9 @@ public:
         release();
     }
 
+    quint64 dbusCalls() const { return m_dbusCalls; }
+    quint64 cookieWrites() const { return m_cookieCache.writes(); }
+
     Q_SIGNAL void enabledChanged(bool);
     bool enabled() const
     {
@@ -76,12 +138,11 @@ public:
 
     void release()
     {
-        QFile::remove(cookieFile);
-
         if (!m_wakelockEnabled) { // no wakelock already requested/set
             return;
         }
         m_wakelockEnabled = false;
+        m_cookieCache.remove();
         Q_EMIT enabledChanged(false);
 
         if (!serviceAvailable()) {
@@ -90,6 +151,7 @@ public:
         }
 
         if (!m_cookie.isEmpty()) {
+            ++m_dbusCalls;
             dbusInterface()->asyncCall(QStringLiteral("clearSysState"), QString(m_cookie));
             qCDebug(QTMIR_SESSIONS) << "Wakelock released" << m_cookie;
             m_cookie.clear();
@@ -109,7 +171,7 @@ private Q_SLOTS:
             acquireWakelock();
         } else {
             m_cookie.clear();
-            QFile::remove(cookieFile);
+            m_cookieCache.remove();
         }
     }
 
@@ -132,6 +194,7 @@ private Q_SLOTS:
 
         if (!m_wakelockEnabled || !m_cookie.isEmpty()) {
             // notified wakelock was created, but we either don't want it, or already have one - release it immediately
+            ++m_dbusCalls;
             dbusInterface()->asyncCall(QStringLiteral("clearSysState"), QString(cookie));
             return;
         }
@@ -139,9 +202,7 @@ private Q_SLOTS:
         m_cookie = cookie;
 
         // see WORKAROUND above for why we save cookie to disk
-        QFile cookieCache(cookieFile);
-        cookieCache.open(QFile::WriteOnly | QFile::Text);
-        cookieCache.write(m_cookie);
+        m_cookieCache.save(m_cookie);
 
         qCDebug(QTMIR_SESSIONS) << "Wakelock acquired" << m_cookie;
         Q_EMIT enabledChanged(true);
@@ -155,6 +216,7 @@ private:
             return;
         }
 
+        ++m_dbusCalls;
         QDBusPendingCall pcall = dbusInterface()->asyncCall(QStringLiteral("requestSysState"), "active", POWERD_SYS_STATE_ACTIVE);
 
         QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pcall, this);
@@ -164,6 +226,8 @@ private:
 
     QByteArray m_cookie;
     bool m_wakelockEnabled;
+    CookieCache m_cookieCache;
+    quint64 m_dbusCalls{0};
 
     Q_DISABLE_COPY(Wakelock)
 };
@@ -181,13 +245,25 @@ private:
  * wakelock. The wakelock is only destroyed when all callers have called release.
  *
  * Note a caller cannot have multiple shares of the wakelock. Multiple calls to acquire are ignored.
+ *
+ * Applications rapidly suspending and resuming would make the wakelock come and go just as fast,
+ * each time costing a couple of DBus calls. With a release delay, the wakelock is kept for a while
+ * after the last owner let go of it, in case a new one comes along.
  */
 
-SharedWakelock::SharedWakelock(const QDBusConnection &connection)
+SharedWakelock::SharedWakelock(const QDBusConnection &connection, int releaseDelayMs)
     : m_wakelock(new Wakelock(connection))
 {
     connect(m_wakelock.data(), &Wakelock::enabledChanged,
             this, &SharedWakelock::enabledChanged);
+
+    m_releaseTimer.setSingleShot(true);
+    m_releaseTimer.setInterval(releaseDelayMs);
+    connect(&m_releaseTimer, &QTimer::timeout, this, [this]() {
+        if (m_owners.empty()) {
+            m_wakelock->release();
+        }
+    });
 }
 
 // Define empty deconstructor here, as QScopedPointer<Wakelock> requires the destructor of the Wakelock class
@@ -210,6 +286,11 @@ void SharedWakelock::acquire(const QObject *caller)
     // register a slot to remove itself from owners list if destroyed
     QObject::connect(caller, &QObject::destroyed, this, &SharedWakelock::release);
 
+    if (m_releaseTimer.isActive()) {
+        m_releaseTimer.stop();
+        m_dbusCallsAvoided += 2; // clearSysState and requestSysState
+    }
+
     m_wakelock->acquire();
 
     m_owners.insert(caller);
@@ -224,8 +305,21 @@ void SharedWakelock::release(const QObject *caller)
     QObject::disconnect(caller, &QObject::destroyed, this, 0);
 
     if (m_owners.empty()) {
-        m_wakelock->release();
+        if (m_releaseTimer.interval() > 0 && m_wakelock->enabled()) {
+            m_releaseTimer.start();
+        } else {
+            m_wakelock->release();
+        }
     }
 }
 
+SharedWakelock::Stats SharedWakelock::stats() const
+{
+    Stats stats;
+    stats.dbusCalls = m_wakelock->dbusCalls();
+    stats.dbusCallsAvoided = m_dbusCallsAvoided;
+    stats.cookieWrites = m_wakelock->cookieWrites();
+    return stats;
+}
+
 } // namespace qtmir
@@ -22,6 +22,7 @@
 #include <QDBusConnection>
 #include <QSet>
 #include <QScopedPointer>
+#include <QTimer>
 
 namespace qtmir {
 
@@ -31,7 +32,8 @@ class SharedWakelock : public QObject
     Q_OBJECT
     Q_PROPERTY(bool enabled READ enabled NOTIFY enabledChanged)
 public:
-    SharedWakelock(const QDBusConnection& connection = QDBusConnection::systemBus());
+    // The system wakelock is only released once there has been no owner for releaseDelayMs
+    SharedWakelock(const QDBusConnection& connection = QDBusConnection::systemBus(), int releaseDelayMs = 0);
     virtual ~SharedWakelock();
 
     virtual bool enabled() const;
@@ -39,12 +41,21 @@ public:
     virtual void acquire(const QObject *caller);
     Q_SLOT virtual void release(const QObject *caller);
 
+    struct Stats {
+        quint64 dbusCalls{0};
+        quint64 dbusCallsAvoided{0}; // release and re-acquire pairs saved by the release delay
+        quint64 cookieWrites{0};
+    };
+    Stats stats() const;
+
 Q_SIGNALS:
     void enabledChanged(bool enabled);
 
 protected:
     QScopedPointer<Wakelock> m_wakelock;
     QSet<const QObject *> m_owners;
+    QTimer m_releaseTimer;
+    quint64 m_dbusCallsAvoided{0};
 
 private:
     Q_DISABLE_COPY(SharedWakelock)
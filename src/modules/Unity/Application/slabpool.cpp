@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "slabpool.h"
+
+// Qt
+#include <QMutexLocker>
+
+using namespace qtmir;
+
+namespace {
+
+std::size_t alignedBlockSize(std::size_t size)
+{
+    const std::size_t alignment = alignof(std::max_align_t);
+    if (size < sizeof(void*)) {
+        size = sizeof(void*);
+    }
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+} // namespace {
+
+SlabPool::SlabPool(std::size_t blockSize, int blocksPerSlab)
+    : m_blockSize(alignedBlockSize(blockSize))
+    , m_blocksPerSlab(blocksPerSlab)
+{
+}
+
+SlabPool::~SlabPool()
+{
+    Q_FOREACH (void *slab, m_slabs) {
+        ::operator delete(slab);
+    }
+}
+
+void *SlabPool::allocate()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_freeList) {
+        addSlab();
+    }
+
+    // released blocks sit on top of the never used ones
+    if (m_releasedBlocks > 0) {
+        --m_releasedBlocks;
+        ++m_stats.reuses;
+    }
+
+    FreeBlock *block = m_freeList;
+    m_freeList = block->next;
+
+    ++m_stats.allocations;
+    ++m_stats.inUse;
+    return block;
+}
+
+void SlabPool::deallocate(void *block)
+{
+    if (!block) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    auto freeBlock = static_cast<FreeBlock*>(block);
+    freeBlock->next = m_freeList;
+    m_freeList = freeBlock;
+
+    ++m_releasedBlocks;
+    --m_stats.inUse;
+}
+
+SlabPool::Stats SlabPool::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+// Must be called with m_mutex held
+void SlabPool::addSlab()
+{
+    char *slab = static_cast<char*>(::operator new(m_blockSize * m_blocksPerSlab));
+    m_slabs.append(slab);
+    ++m_stats.slabs;
+
+    // thread the new blocks onto the free list, lowest address first
+    for (int i = m_blocksPerSlab - 1; i >= 0; --i) {
+        auto block = reinterpret_cast<FreeBlock*>(slab + i * m_blockSize);
+        block->next = m_freeList;
+        m_freeList = block;
+    }
+}
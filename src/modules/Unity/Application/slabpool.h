@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_SLABPOOL_H
+#define QTMIR_SLABPOOL_H
+
+// Qt
+#include <QMutex>
+#include <QVector>
+
+// std
+#include <cstddef>
+
+namespace qtmir {
+
+/*
+  Hands out fixed-size blocks carved from slabs holding several of them. Released blocks go to a
+  free list and are reused by the next allocation, so that creating and destroying windows over and
+  over doesn't churn the heap. Slabs are only given back when the pool itself goes away.
+
+  Thread safety: blocks may be allocated and released from any thread.
+ */
+class SlabPool
+{
+public:
+    struct Stats {
+        quint64 allocations{0}; // total blocks handed out
+        quint64 reuses{0};      // of which came from the free list
+        int inUse{0};
+        int slabs{0};
+    };
+
+    explicit SlabPool(std::size_t blockSize, int blocksPerSlab = 16);
+    ~SlabPool();
+
+    void *allocate();
+    void deallocate(void *block);
+
+    Stats stats() const;
+
+private:
+    Q_DISABLE_COPY(SlabPool)
+
+    struct FreeBlock { FreeBlock *next; };
+
+    void addSlab();
+
+    const std::size_t m_blockSize;
+    const int m_blocksPerSlab;
+
+    mutable QMutex m_mutex;
+    FreeBlock *m_freeList{nullptr};
+    int m_releasedBlocks{0};
+    QVector<void*> m_slabs;
+    Stats m_stats;
+};
+
+// One pool per block size, shared by all the types of that size.
+// Deliberately leaked: Mir threads may still release blocks after static destruction has begun.
+template<std::size_t BlockSize>
+SlabPool &slabPoolFor()
+{
+    static SlabPool *const pool = new SlabPool(BlockSize);
+    return *pool;
+}
+
+} // namespace qtmir
+
+#endif // QTMIR_SLABPOOL_H
@@ -28,6 +28,7 @@
 #include <mirqtconversion.h>
 
 // Qt
+#include <QElapsedTimer>
 #include <QGuiApplication>
 
 Q_LOGGING_CATEGORY(QTMIR_SURFACEMANAGER, "qtmir.surfacemanager", QtInfoMsg)
@@ -66,6 +67,11 @@ SurfaceManager::SurfaceManager(WindowControllerInterface *windowController,
     connectToWindowModelNotifier(windowModel);
 }
 
+SurfaceManager::~SurfaceManager()
+{
+    sweepDeadSurfaces();
+}
+
 void SurfaceManager::connectToWindowModelNotifier(WindowModelNotifier *notifier)
 {
     connect(notifier, &WindowModelNotifier::windowAdded,          this, &SurfaceManager::onWindowAdded,           Qt::QueuedConnection);
@@ -78,23 +84,145 @@ void SurfaceManager::connectToWindowModelNotifier(WindowModelNotifier *notifier)
     connect(notifier, &WindowModelNotifier::windowRequestedRaise, this, &SurfaceManager::onWindowsRequestedRaise, Qt::QueuedConnection);
     connect(notifier, &WindowModelNotifier::modificationsStarted, this, &SurfaceManager::modificationsStarted,    Qt::QueuedConnection);
     connect(notifier, &WindowModelNotifier::modificationsEnded,   this, &SurfaceManager::modificationsEnded,      Qt::QueuedConnection);
+    connect(notifier, &WindowModelNotifier::modificationsStarted, this, &SurfaceManager::onModificationsStarted,  Qt::QueuedConnection);
+    connect(notifier, &WindowModelNotifier::modificationsEnded,   this, &SurfaceManager::onModificationsEnded,    Qt::QueuedConnection);
 }
 
 void SurfaceManager::rememberMirSurface(MirSurface *surface)
 {
-    m_allSurfaces.append(surface);
+    m_allSurfaces.append(surface); // new windows go on top
+    invalidateStackSnapshot(surface);
+
+    connect(surface, &unityapi::MirSurfaceInterface::sizeChanged, this, [this, surface]() {
+        invalidateStackSnapshot(surface);
+    });
+    connect(surface, &MirSurfaceInterface::activeFocusChanged, this, [this, surface]() {
+        invalidateStackSnapshot(surface);
+    });
 }
 
 void SurfaceManager::forgetMirSurface(const miral::Window &window)
 {
     for (int i = 0; i < m_allSurfaces.count(); ++i) {
         if (m_allSurfaces[i]->window() == window) {
-            m_allSurfaces.removeAt(i);
+            MirSurface *surface = m_allSurfaces.takeAt(i);
+            m_stackEntries.remove(surface);
+            m_changedStackEntries.remove(surface);
+            invalidateStackSnapshot();
             return;
         }
     }
 }
 
+void SurfaceManager::buryMirSurface(MirSurface *surface)
+{
+    if (m_deadSurfaces.contains(surface)) {
+        return;
+    }
+    surface->disconnect(this);
+    m_deadSurfaces.append(surface);
+}
+
+void SurfaceManager::scheduleSweep()
+{
+    if (m_sweepScheduled || m_deadSurfaces.isEmpty()) {
+        return;
+    }
+    // A posted call rather than a timer, so it runs right after the events already queued
+    m_sweepScheduled = true;
+    QMetaObject::invokeMethod(this, "sweepDeadSurfaces", Qt::QueuedConnection);
+}
+
+void SurfaceManager::sweepDeadSurfaces()
+{
+    m_sweepScheduled = false;
+    if (m_deadSurfaces.isEmpty()) {
+        return;
+    }
+
+    QElapsedTimer sweepTimer;
+    sweepTimer.start();
+
+    // take the list first, destructors may cause further surfaces to be buried
+    const QVector<MirSurface*> deadSurfaces = std::move(m_deadSurfaces);
+    m_deadSurfaces.clear();
+    Q_FOREACH (MirSurface *surface, deadSurfaces) {
+        delete surface;
+        tracepoint(qtmir, surfaceDestroyed);
+    }
+
+    const qint64 elapsed = sweepTimer.nsecsElapsed();
+    ++m_sweepStats.sweeps;
+    m_sweepStats.surfacesDestroyed += deadSurfaces.count();
+    m_sweepStats.lastSweepNs = elapsed;
+    m_sweepStats.longestSweepNs = qMax(m_sweepStats.longestSweepNs, elapsed);
+    tracepoint(qtmir, surfacesSwept, deadSurfaces.count(), elapsed);
+
+    DEBUG_MSG << "() destroyed " << deadSurfaces.count() << " surfaces in " << elapsed << "ns";
+}
+
+void SurfaceManager::invalidateStackSnapshot(MirSurface *changedSurface)
+{
+    if (changedSurface) {
+        m_changedStackEntries.insert(changedSurface);
+    }
+    m_stackSnapshotStale = true;
+
+    // Changes coming from Mir get published once the whole transaction has been processed.
+    // Others, like active focus changes, are published right away.
+    if (m_modificationsDepth == 0) {
+        publishStackSnapshot();
+    }
+}
+
+void SurfaceManager::publishStackSnapshot()
+{
+    if (!m_stackSnapshotStale) {
+        return;
+    }
+
+    Q_FOREACH (MirSurface *surface, m_changedStackEntries) {
+        WindowStackEntry entry;
+        entry.persistentId = surface->persistentId();
+        if (SessionInterface *session = surface->session()) {
+            entry.pid = session->pid();
+            if (session->application()) {
+                entry.appId = session->application()->appId();
+            }
+        }
+        entry.focused = surface->focused();
+        entry.activeFocus = surface->activeFocus();
+        entry.geometry = QRect(surface->position(), surface->size());
+        m_stackEntries.insert(surface, entry);
+    }
+    m_changedStackEntries.clear();
+
+    QVector<WindowStackEntry> entries;
+    entries.reserve(m_allSurfaces.count());
+    Q_FOREACH (MirSurface *surface, m_allSurfaces) {
+        entries.append(m_stackEntries.value(surface));
+    }
+
+    WindowStackSnapshot::publish(std::make_shared<const WindowStackSnapshot>(entries));
+    m_stackSnapshotStale = false;
+}
+
+void SurfaceManager::onModificationsStarted()
+{
+    ++m_modificationsDepth;
+}
+
+void SurfaceManager::onModificationsEnded()
+{
+    if (m_modificationsDepth > 0) {
+        --m_modificationsDepth;
+    }
+    if (m_modificationsDepth == 0) {
+        publishStackSnapshot();
+        scheduleSweep();
+    }
+}
+
 void SurfaceManager::onWindowAdded(const NewWindow &window)
 {
     const auto &windowInfo = window.windowInfo;
@@ -117,8 +245,8 @@ void SurfaceManager::onWindowAdded(const NewWindow &window)
         if ((!surface->live() || !surface->session())
                 && !surface->isBeingDisplayed()) {
             forgetMirSurface(static_cast<MirSurface*>(surface)->window());
-            surface->deleteLater(); // don't delete immediately, slot may be directly connected
-            tracepoint(qtmir, surfaceDestroyed);
+            buryMirSurface(surface); // don't delete immediately, slot may be directly connected
+            scheduleSweep();
         }
     });
 
@@ -138,11 +266,19 @@ void SurfaceManager::onWindowRemoved(const miral::WindowInfo &windowInfo)
     DEBUG_MSG << "()";
     MirSurface *surface = find(windowInfo);
     forgetMirSurface(windowInfo.window());
-    if (surface && surface->isBeingDisplayed()) {
+    if (!surface) {
+        return;
+    }
+
+    if (surface->isBeingDisplayed()) {
         surface->setLive(false);
-    } else {
-        delete surface;
-        tracepoint(qtmir, surfaceDestroyed);
+        return;
+    }
+
+    buryMirSurface(surface);
+    // Windows going away as part of a Mir transaction get destroyed together once it ends
+    if (m_modificationsDepth == 0) {
+        sweepDeadSurfaces();
     }
 }
 
@@ -173,6 +309,7 @@ void SurfaceManager::onWindowMoved(const miral::WindowInfo &windowInfo, const QP
 {
     if (auto mirSurface = find(windowInfo)) {
         mirSurface->setPosition(topLeft);
+        invalidateStackSnapshot(mirSurface);
     }
 }
 
@@ -180,6 +317,7 @@ void SurfaceManager::onWindowFocusChanged(const miral::WindowInfo &windowInfo, b
 {
     if (auto mirSurface = find(windowInfo)) {
         mirSurface->setFocused(focused);
+        invalidateStackSnapshot(mirSurface);
     }
 }
 
@@ -203,10 +341,15 @@ void SurfaceManager::onWindowsRaised(const std::vector<miral::Window> &windows)
         auto mirSurface = find(windows[i]);
         if (mirSurface) {
             surfaces[i] = mirSurface;
+            // keep m_allSurfaces in stacking order
+            m_allSurfaces.removeOne(mirSurface);
+            m_allSurfaces.append(mirSurface);
         } else {
             WARNING_MSG << " Could not find qml surface for " << windows[i];
         }
     }
+    invalidateStackSnapshot();
+
     Q_EMIT surfacesRaised(surfaces);
 }
 
@@ -20,9 +20,13 @@
 // common
 #include "windowmodelnotifier.h"
 
+#include "windowstacksnapshot.h"
+
 // Unity API
 #include <unity/shell/application/SurfaceManagerInterface.h>
 
+#include <QHash>
+#include <QSet>
 #include <QVector>
 #include <QLoggingCategory>
 
@@ -43,7 +47,7 @@ public:
     SurfaceManager(WindowControllerInterface *windowController,
                    WindowModelNotifier *windowModel,
                    SessionMapInterface *sessionMap);
-    virtual ~SurfaceManager() {}
+    virtual ~SurfaceManager();
 
     void raise(unity::shell::application::MirSurfaceInterface *surface) override;
     void activate(unity::shell::application::MirSurfaceInterface *surface) override;
@@ -51,6 +55,15 @@ public:
     // mainly for test usage
     MirSurface* find(const miral::WindowInfo &needle) const;
 
+    // Dead surfaces are not destroyed one by one but in a single sweep, once the event loop gets to it
+    struct SweepStats {
+        quint64 sweeps{0};
+        quint64 surfacesDestroyed{0};
+        qint64 lastSweepNs{0};
+        qint64 longestSweepNs{0};
+    };
+    SweepStats sweepStats() const { return m_sweepStats; }
+
 private Q_SLOTS:
     void onWindowAdded(const qtmir::NewWindow &windowInfo);
     void onWindowRemoved(const miral::WindowInfo &windowInfo);
@@ -60,14 +73,31 @@ private Q_SLOTS:
     void onWindowFocusChanged(const miral::WindowInfo &windowInfo, bool focused);
     void onWindowsRaised(const std::vector<miral::Window> &windows);
     void onWindowsRequestedRaise(const miral::WindowInfo &windowInfo);
+    void onModificationsStarted();
+    void onModificationsEnded();
+    void sweepDeadSurfaces();
 
 private:
     void connectToWindowModelNotifier(WindowModelNotifier *notifier);
     void rememberMirSurface(MirSurface *surface);
     void forgetMirSurface(const miral::Window &window);
     MirSurface* find(const miral::Window &needle) const;
-
-    QVector<MirSurface*> m_allSurfaces;
+    void buryMirSurface(MirSurface *surface);
+    void scheduleSweep();
+    void invalidateStackSnapshot(MirSurface *changedSurface = nullptr);
+    void publishStackSnapshot();
+
+    QVector<MirSurface*> m_allSurfaces; // in stacking order, bottom to top
+
+    // Window stack snapshot bookkeeping. Entries are only recomputed for surfaces which changed.
+    QHash<MirSurface*, WindowStackEntry> m_stackEntries;
+    QSet<MirSurface*> m_changedStackEntries;
+    bool m_stackSnapshotStale{false};
+    int m_modificationsDepth{0};
+
+    QVector<MirSurface*> m_deadSurfaces;
+    bool m_sweepScheduled{false};
+    SweepStats m_sweepStats;
 
     WindowControllerInterface *m_windowController;
     SessionMapInterface *m_sessionMap;
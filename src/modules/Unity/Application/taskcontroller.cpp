@@ -62,6 +62,12 @@ TaskController::TaskController(std::shared_ptr<PromptSessionManager> &promptSess
 {
 }
 
+QVector<pid_t> TaskController::processIds(const QString &appId)
+{
+    Q_UNUSED(appId);
+    return {};
+}
+
 void TaskController::onSessionStarting(const miral::ApplicationInfo &appInfo)
 {
     DEBUG_MSG << " - sessionName=" <<  appInfo.name().c_str();
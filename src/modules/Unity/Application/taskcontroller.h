@@ -22,6 +22,7 @@
 #include <QSharedPointer>
 #include <QString>
 #include <QStringList>
+#include <QVector>
 
 // miral
 #include <miral/application.h>
@@ -71,6 +72,10 @@ public:
 
     virtual bool appIdHasProcessId(const QString &appId, pid_t pid) = 0;
 
+    // Processes currently running for the given application, if the implementation can tell.
+    // Called from a worker thread.
+    virtual QVector<pid_t> processIds(const QString &appId);
+
     virtual bool stop(const QString &appId) = 0;
     virtual bool start(const QString &appId, const QStringList &arguments) = 0;
 
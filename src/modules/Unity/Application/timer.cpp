@@ -15,6 +15,7 @@
  */
 
 #include "timer.h"
+#include "lifecyclescheduler.h"
 
 using namespace qtmir;
 
@@ -56,6 +57,54 @@ void Timer::setSingleShot(bool value)
     m_timer.setSingleShot(value);
 }
 
+///////////////////////////////// BatchedTimer /////////////////////////////////
+
+BatchedTimer::BatchedTimer(LifecycleScheduler *scheduler, QObject *parent)
+    : AbstractTimer(parent)
+    , m_scheduler(scheduler ? scheduler : LifecycleScheduler::instance())
+    , m_interval(0)
+{
+}
+
+BatchedTimer::~BatchedTimer()
+{
+    m_scheduler->cancel(this);
+}
+
+int BatchedTimer::interval() const
+{
+    return m_interval;
+}
+
+void BatchedTimer::setInterval(int msecs)
+{
+    m_interval = msecs;
+}
+
+void BatchedTimer::start()
+{
+    m_scheduler->schedule(this, m_interval);
+    AbstractTimer::start();
+}
+
+void BatchedTimer::stop()
+{
+    m_scheduler->cancel(this);
+    AbstractTimer::stop();
+}
+
+void BatchedTimer::setSingleShot(bool value)
+{
+    Q_ASSERT(value);
+    Q_UNUSED(value);
+}
+
+void BatchedTimer::fire()
+{
+    AbstractTimer::stop();
+    Q_EMIT timeout();
+}
+
 /////////////////////////////////// FakeTimer //////////////////////////////////
 
 FakeTimer::FakeTimer(const SharedTimeSource &timeSource, QObject *parent)
@@ -61,6 +61,34 @@ private:
     QTimer m_timer;
 };
 
+class LifecycleScheduler;
+
+/*
+  Single-shot timer whose timeouts are batched together with those of other BatchedTimers
+  by the LifecycleScheduler, at the cost of firing up to LifecycleScheduler::slackMs late.
+ */
+class BatchedTimer : public AbstractTimer
+{
+    Q_OBJECT
+public:
+    // Uses LifecycleScheduler::instance() if no scheduler is given
+    BatchedTimer(LifecycleScheduler *scheduler = nullptr, QObject *parent = nullptr);
+    virtual ~BatchedTimer();
+
+    int interval() const override;
+    void setInterval(int msecs) override;
+    void start() override;
+    void stop() override;
+    bool isSingleShot() const override { return true; }
+    void setSingleShot(bool value) override;
+
+    // Called by the LifecycleScheduler
+    void fire();
+private:
+    LifecycleScheduler *const m_scheduler;
+    int m_interval;
+};
+
 /* For tests */
 class FakeTimer : public AbstractTimer
 {
@@ -22,6 +22,8 @@
 #include <logging.h>
 
 // Qt
+#include <QHash>
+#include <QMutex>
 #include <QStandardPaths>
 
 // upstart
@@ -37,6 +39,12 @@ namespace qtmir
 namespace upstart
 {
 
+namespace {
+// Plenty for the applications a user runs in a session, while still bounding the memory used
+const int maxCachedApps = 64;
+const int maxCachedShortAppIds = 256;
+}
+
 struct TaskController::Private
 {
     std::shared_ptr<ual::Registry> registry;
@@ -47,6 +55,22 @@ struct TaskController::Private
     UbuntuAppLaunchAppObserver resumeCallback = nullptr;
     UbuntuAppLaunchAppPausedResumedObserver pausedCallback = nullptr;
     UbuntuAppLaunchAppFailedObserver failureCallback = nullptr;
+
+    std::shared_ptr<ual::Application> app(const QString &appId);
+    QString shortAppId(const gchar *appId);
+    void forgetApp(const QString &shortAppId);
+
+    // Looking up an application in UAL hits the disk and DBus, so what it returns is kept until the
+    // application stops or fails. Can be called from any thread.
+    struct CachedApp {
+        std::shared_ptr<ual::Application> app;
+        QString shortAppId;
+    };
+    mutable QMutex cacheMutex;
+    QHash<QString, CachedApp> appCache; // by appId, as callers gave it
+    QHash<QByteArray, QString> shortAppIdCache; // by appId, as UAL gave it
+    bool cacheEnabled{true};
+    CacheStats cacheStats;
 };
 
 namespace {
@@ -87,6 +111,69 @@ std::shared_ptr<ual::Application> createApp(const QString &inputAppId, std::shar
 
 } // namespace
 
+std::shared_ptr<ual::Application> TaskController::Private::app(const QString &appId)
+{
+    {
+        QMutexLocker locker(&cacheMutex);
+        auto it = appCache.constFind(appId);
+        if (it != appCache.constEnd()) {
+            ++cacheStats.hits;
+            return it.value().app;
+        }
+        ++cacheStats.misses;
+    }
+
+    // Not holding the lock while UAL does its thing. Worst case two threads look up the same app.
+    auto app = createApp(appId, registry);
+    if (!app) {
+        return app; // not cached, it might get installed later
+    }
+
+    CachedApp cached{app, toShortAppIdIfPossible(QString::fromStdString(std::string(app->appId())))};
+
+    QMutexLocker locker(&cacheMutex);
+    if (cacheEnabled) {
+        if (appCache.count() >= maxCachedApps) {
+            appCache.clear();
+        }
+        appCache.insert(appId, cached);
+    }
+    return app;
+}
+
+QString TaskController::Private::shortAppId(const gchar *appId)
+{
+    const QByteArray key(appId);
+
+    QMutexLocker locker(&cacheMutex);
+    auto it = shortAppIdCache.constFind(key);
+    if (it != shortAppIdCache.constEnd()) {
+        return it.value();
+    }
+
+    const QString result = toShortAppIdIfPossible(QString::fromLatin1(key));
+    if (cacheEnabled) {
+        if (shortAppIdCache.count() >= maxCachedShortAppIds) {
+            shortAppIdCache.clear();
+        }
+        shortAppIdCache.insert(key, result);
+    }
+    return result;
+}
+
+void TaskController::Private::forgetApp(const QString &shortAppId)
+{
+    QMutexLocker locker(&cacheMutex);
+    for (auto it = appCache.begin(); it != appCache.end();) {
+        if (it.value().shortAppId == shortAppId) {
+            it = appCache.erase(it);
+            ++cacheStats.invalidations;
+        } else {
+            ++it;
+        }
+    }
+}
+
 TaskController::TaskController()
     : qtmir::TaskController(),
       impl(new Private())
@@ -95,32 +182,34 @@ TaskController::TaskController()
 
     impl->preStartCallback = [](const gchar * appId, gpointer userData) {
         auto thiz = static_cast<TaskController*>(userData);
-        Q_EMIT(thiz->processStarting(toShortAppIdIfPossible(appId)));
+        Q_EMIT(thiz->processStarting(thiz->impl->shortAppId(appId)));
     };
 
     impl->startedCallback = [](const gchar * appId, gpointer userData) {
         auto thiz = static_cast<TaskController*>(userData);
-        Q_EMIT(thiz->applicationStarted(toShortAppIdIfPossible(appId)));
+        Q_EMIT(thiz->applicationStarted(thiz->impl->shortAppId(appId)));
     };
 
     impl->stopCallback = [](const gchar * appId, gpointer userData) {
         auto thiz = static_cast<TaskController*>(userData);
-        Q_EMIT(thiz->processStopped(toShortAppIdIfPossible(appId)));
+        const QString shortAppId = thiz->impl->shortAppId(appId);
+        thiz->impl->forgetApp(shortAppId); // it might have been removed or upgraded meanwhile
+        Q_EMIT(thiz->processStopped(shortAppId));
     };
 
     impl->focusCallback = [](const gchar * appId, gpointer userData) {
         auto thiz = static_cast<TaskController*>(userData);
-        Q_EMIT(thiz->focusRequested(toShortAppIdIfPossible(appId)));
+        Q_EMIT(thiz->focusRequested(thiz->impl->shortAppId(appId)));
     };
 
     impl->resumeCallback = [](const gchar * appId, gpointer userData) {
         auto thiz = static_cast<TaskController*>(userData);
-        Q_EMIT(thiz->resumeRequested(toShortAppIdIfPossible(appId)));
+        Q_EMIT(thiz->resumeRequested(thiz->impl->shortAppId(appId)));
     };
 
     impl->pausedCallback = [](const gchar * appId, GPid *, gpointer userData) {
         auto thiz = static_cast<TaskController*>(userData);
-        Q_EMIT(thiz->processSuspended(toShortAppIdIfPossible(appId)));
+        Q_EMIT(thiz->processSuspended(thiz->impl->shortAppId(appId)));
     };
 
     impl->failureCallback = [](const gchar * appId, UbuntuAppLaunchAppFailed failureType, gpointer userData) {
@@ -132,7 +221,9 @@ TaskController::TaskController()
         }
 
         auto thiz = static_cast<TaskController*>(userData);
-        Q_EMIT(thiz->processFailed(toShortAppIdIfPossible(appId), error));
+        const QString shortAppId = thiz->impl->shortAppId(appId);
+        thiz->impl->forgetApp(shortAppId);
+        Q_EMIT(thiz->processFailed(shortAppId, error));
     };
 
     ubuntu_app_launch_observer_add_app_starting(impl->preStartCallback, this);
@@ -157,7 +248,7 @@ TaskController::~TaskController()
 
 bool TaskController::appIdHasProcessId(const QString& appId, pid_t pid)
 {
-    auto app = createApp(appId, impl->registry);
+    auto app = impl->app(appId);
     if (!app) {
         return false;
     }
@@ -171,9 +262,27 @@ bool TaskController::appIdHasProcessId(const QString& appId, pid_t pid)
     return false;
 }
 
+QVector<pid_t> TaskController::processIds(const QString& appId)
+{
+    QVector<pid_t> result;
+
+    auto app = impl->app(appId);
+    if (!app) {
+        return result;
+    }
+
+    for (auto &instance: app->instances()) {
+        for (pid_t pid: instance->pids()) {
+            result.append(pid);
+        }
+    }
+
+    return result;
+}
+
 bool TaskController::stop(const QString& appId)
 {
-    auto app = createApp(appId, impl->registry);
+    auto app = impl->app(appId);
     if (!app) {
         return false;
     }
@@ -187,7 +296,7 @@ bool TaskController::stop(const QString& appId)
 
 bool TaskController::start(const QString& appId, const QStringList& arguments)
 {
-    auto app = createApp(appId, impl->registry);
+    auto app = impl->app(appId);
     if (!app) {
         return false;
     }
@@ -205,7 +314,7 @@ bool TaskController::start(const QString& appId, const QStringList& arguments)
 
 bool TaskController::suspend(const QString& appId)
 {
-    auto app = createApp(appId, impl->registry);
+    auto app = impl->app(appId);
     if (!app) {
         return false;
     }
@@ -219,7 +328,7 @@ bool TaskController::suspend(const QString& appId)
 
 bool TaskController::resume(const QString& appId)
 {
-    auto app = createApp(appId, impl->registry);
+    auto app = impl->app(appId);
     if (!app) {
         return false;
     }
@@ -233,15 +342,31 @@ bool TaskController::resume(const QString& appId)
 
 QSharedPointer<qtmir::ApplicationInfo> TaskController::getInfoForApp(const QString &appId) const
 {
-    auto app = createApp(appId, impl->registry);
+    auto app = impl->app(appId);
     if (!app || !app->info()) {
         return QSharedPointer<qtmir::ApplicationInfo>();
     }
 
-    QString shortAppId = toShortAppIdIfPossible(QString::fromStdString(std::string(app->appId())));
+    QString shortAppId = impl->shortAppId(std::string(app->appId()).c_str());
     auto appInfo = new qtmir::upstart::ApplicationInfo(shortAppId, app->info());
     return QSharedPointer<qtmir::ApplicationInfo>(appInfo);
 }
 
+TaskController::CacheStats TaskController::cacheStats() const
+{
+    QMutexLocker locker(&impl->cacheMutex);
+    return impl->cacheStats;
+}
+
+void TaskController::setCacheEnabled(bool enabled)
+{
+    QMutexLocker locker(&impl->cacheMutex);
+    impl->cacheEnabled = enabled;
+    if (!enabled) {
+        impl->appCache.clear();
+        impl->shortAppIdCache.clear();
+    }
+}
+
 } // namespace upstart
 } // namespace qtmir
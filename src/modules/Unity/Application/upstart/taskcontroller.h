@@ -32,6 +32,7 @@ public:
     ~TaskController();
 
     bool appIdHasProcessId(const QString& appId, pid_t pid) override;
+    QVector<pid_t> processIds(const QString& appId) override;
 
     bool stop(const QString& appId) override;
     bool start(const QString& appId, const QStringList& arguments) override;
@@ -41,6 +42,16 @@ public:
 
     QSharedPointer<qtmir::ApplicationInfo> getInfoForApp(const QString &appId) const override;
 
+    struct CacheStats {
+        quint64 hits{0};
+        quint64 misses{0};
+        quint64 invalidations{0};
+    };
+    CacheStats cacheStats() const;
+
+    // For benchmarks. When disabled, every call looks the application up in UAL again.
+    void setCacheEnabled(bool enabled);
+
 private:
     struct Private;
     QScopedPointer<Private> impl;
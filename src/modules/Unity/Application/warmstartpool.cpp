@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "warmstartpool.h"
+
+#include <QPair>
+#include <QVector>
+
+// std
+#include <algorithm>
+#include <cmath>
+
+using namespace qtmir;
+
+const qint64 WarmStartPool::halfLifeMs = 3 * 24 * 60 * 60 * 1000LL; // 3 days
+const qint64 WarmStartPool::defaultMemoryEstimate = 64 * 1024 * 1024;
+const double WarmStartPool::minimumFrequency = 2.0; // launched once isn't a habit
+
+WarmStartPool::WarmStartPool(const SharedTimeSource &timeSource)
+    : m_timeSource(timeSource)
+{
+}
+
+void WarmStartPool::recordLaunch(const QString &appId)
+{
+    const qint64 now = m_timeSource->msecsSinceReference();
+    Entry &entry = m_entries[appId];
+    entry.frequency = decayedFrequency(entry, now) + 1.0;
+    entry.lastLaunch = now;
+    ++m_stats.launches;
+}
+
+double WarmStartPool::launchFrequency(const QString &appId) const
+{
+    auto it = m_entries.constFind(appId);
+    if (it == m_entries.constEnd()) {
+        return 0;
+    }
+    return decayedFrequency(it.value(), m_timeSource->msecsSinceReference());
+}
+
+void WarmStartPool::setMemoryEstimate(const QString &appId, qint64 bytes)
+{
+    if (bytes > 0) {
+        m_entries[appId].memoryEstimate = bytes;
+    }
+}
+
+qint64 WarmStartPool::memoryEstimate(const QString &appId) const
+{
+    const qint64 estimate = m_entries.value(appId).memoryEstimate;
+    return estimate > 0 ? estimate : defaultMemoryEstimate;
+}
+
+QStringList WarmStartPool::candidates(const QSet<QString> &inUse) const
+{
+    if (!isEnabled()) {
+        return QStringList();
+    }
+
+    const qint64 now = m_timeSource->msecsSinceReference();
+
+    QVector<QPair<double, QString>> ranked;
+    ranked.reserve(m_entries.count());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        const double frequency = decayedFrequency(it.value(), now);
+        if (frequency >= minimumFrequency) {
+            ranked.append(qMakePair(frequency, it.key()));
+        }
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const QPair<double, QString> &a, const QPair<double, QString> &b) {
+        return a.first > b.first;
+    });
+
+    QStringList result;
+    qint64 budget = m_memoryBudget;
+    for (const auto &candidate : ranked) {
+        if (result.count() >= m_capacity) {
+            break;
+        }
+        const QString &appId = candidate.second;
+        if (inUse.contains(appId)) {
+            continue;
+        }
+        const qint64 memory = memoryEstimate(appId);
+        if (memory > budget) {
+            continue; // a smaller one further down might still fit
+        }
+        budget -= memory;
+        result.append(appId);
+    }
+    return result;
+}
+
+void WarmStartPool::recordColdStart(const QString &appId, qint64 ms)
+{
+    Entry &entry = m_entries[appId];
+    // moving average, weighing recent starts more as caches warm up or go cold
+    entry.averageColdStartMs = entry.averageColdStartMs > 0 ? (entry.averageColdStartMs * 3 + ms) / 4 : ms;
+    ++m_stats.misses;
+}
+
+void WarmStartPool::recordWarmStart(const QString &appId, qint64 ms)
+{
+    const qint64 coldStartMs = m_entries.value(appId).averageColdStartMs;
+    if (coldStartMs > ms) {
+        m_stats.msSaved += coldStartMs - ms;
+    }
+    ++m_stats.hits;
+}
+
+double WarmStartPool::hitRate() const
+{
+    const quint64 starts = m_stats.hits + m_stats.misses;
+    return starts > 0 ? double(m_stats.hits) / starts : 0;
+}
+
+double WarmStartPool::decayedFrequency(const Entry &entry, qint64 now) const
+{
+    if (entry.frequency == 0) {
+        return 0;
+    }
+    return entry.frequency * std::exp2(-double(now - entry.lastLaunch) / halfLifeMs);
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_WARMSTARTPOOL_H
+#define QTMIR_WARMSTARTPOOL_H
+
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+#include "timesource.h"
+
+namespace qtmir {
+
+/*
+  Decides which applications are worth keeping pre-started and suspended, so that launching
+  them is a resume instead of a cold start.
+
+  Launches are counted per application with an exponential decay, so that what was used a lot
+  some days ago eventually gives way to what is used now. The most frequently launched
+  applications are picked, as many as fit both the pool capacity and the memory budget. The memory
+  an application needs is whatever it was last measured to use while suspended, or a default guess
+  until then.
+
+  Only bookkeeping happens here, ApplicationManager does the starting and resuming.
+ */
+class WarmStartPool
+{
+public:
+    explicit WarmStartPool(const SharedTimeSource &timeSource = SharedTimeSource(new RealTimeSource));
+
+    void setCapacity(int capacity) { m_capacity = capacity; }
+    int capacity() const { return m_capacity; }
+    void setMemoryBudget(qint64 bytes) { m_memoryBudget = bytes; }
+    qint64 memoryBudget() const { return m_memoryBudget; }
+
+    bool isEnabled() const { return m_capacity > 0 && m_memoryBudget > 0; }
+
+    void recordLaunch(const QString &appId);
+    double launchFrequency(const QString &appId) const;
+
+    void setMemoryEstimate(const QString &appId, qint64 bytes);
+    qint64 memoryEstimate(const QString &appId) const;
+
+    // Applications to keep warm, most frequently launched first. Those in use already are left out.
+    QStringList candidates(const QSet<QString> &inUse = QSet<QString>()) const;
+
+    // Time from launch request to the application running
+    void recordColdStart(const QString &appId, qint64 ms);
+    void recordWarmStart(const QString &appId, qint64 ms);
+
+    struct Stats {
+        quint64 launches{0};
+        quint64 hits{0}; // launches served by resuming a warm application
+        quint64 misses{0};
+        qint64 msSaved{0}; // by hits, compared with the average cold start of the same application
+    };
+    Stats stats() const { return m_stats; }
+    double hitRate() const;
+
+    static const qint64 halfLifeMs;
+    static const qint64 defaultMemoryEstimate;
+    static const double minimumFrequency;
+
+private:
+    struct Entry {
+        double frequency{0};
+        qint64 lastLaunch{0};
+        qint64 memoryEstimate{0};
+        qint64 averageColdStartMs{0};
+    };
+
+    double decayedFrequency(const Entry &entry, qint64 now) const;
+
+    SharedTimeSource m_timeSource;
+    int m_capacity{0};
+    qint64 m_memoryBudget{0};
+    QHash<QString, Entry> m_entries;
+    Stats m_stats;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_WARMSTARTPOOL_H
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "windowstacksnapshot.h"
+
+// std
+#include <atomic>
+
+using namespace qtmir;
+
+namespace {
+std::shared_ptr<const WindowStackSnapshot> currentSnapshot = std::make_shared<const WindowStackSnapshot>();
+std::atomic<quint64> lastSerial{0};
+}
+
+WindowStackSnapshot::WindowStackSnapshot(const QVector<WindowStackEntry> &entries)
+    : m_entries(entries)
+    , m_serial(++lastSerial)
+{
+    m_indexForPersistentId.reserve(m_entries.count());
+    for (int i = 0; i < m_entries.count(); ++i) {
+        m_indexForPersistentId.insert(m_entries[i].persistentId, i);
+    }
+}
+
+const WindowStackEntry *WindowStackSnapshot::findByPersistentId(const QString &persistentId) const
+{
+    auto it = m_indexForPersistentId.constFind(persistentId);
+    return it != m_indexForPersistentId.constEnd() ? &m_entries[it.value()] : nullptr;
+}
+
+int WindowStackSnapshot::zOrderOf(const QString &persistentId) const
+{
+    return m_indexForPersistentId.value(persistentId, -1);
+}
+
+std::shared_ptr<const WindowStackSnapshot> WindowStackSnapshot::current()
+{
+    return std::atomic_load(&currentSnapshot);
+}
+
+void WindowStackSnapshot::publish(const std::shared_ptr<const WindowStackSnapshot> &snapshot)
+{
+    std::atomic_store(&currentSnapshot, snapshot);
+}
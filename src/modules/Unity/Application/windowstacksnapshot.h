@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_WINDOWSTACKSNAPSHOT_H
+#define QTMIR_WINDOWSTACKSNAPSHOT_H
+
+// std
+#include <memory>
+#include <sys/types.h>
+
+// Qt
+#include <QHash>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+namespace qtmir {
+
+struct WindowStackEntry
+{
+    QString persistentId;
+    pid_t pid{0};
+    QString appId; // empty if the session has no Application (yet)
+    bool focused{false}; // Mir input focus
+    bool activeFocus{false}; // has active focus in the shell scene
+    QRect geometry;
+};
+
+/*
+  Immutable copy of the window stack, ordered bottom to top.
+
+  Built by SurfaceManager on the Qt GUI thread each time a WindowModelNotifier transaction ends and
+  published atomically, so that it can be queried from any thread without touching any QObject.
+ */
+class WindowStackSnapshot
+{
+public:
+    WindowStackSnapshot() = default;
+    explicit WindowStackSnapshot(const QVector<WindowStackEntry> &entries);
+
+    const QVector<WindowStackEntry> &entries() const { return m_entries; }
+
+    // Returns nullptr if not found. Position in entries() is the z-order.
+    const WindowStackEntry *findByPersistentId(const QString &persistentId) const;
+    int zOrderOf(const QString &persistentId) const;
+
+    quint64 serial() const { return m_serial; }
+
+    static std::shared_ptr<const WindowStackSnapshot> current();
+    static void publish(const std::shared_ptr<const WindowStackSnapshot> &snapshot);
+
+private:
+    QVector<WindowStackEntry> m_entries;
+    QHash<QString, int> m_indexForPersistentId;
+    quint64 m_serial{0};
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_WINDOWSTACKSNAPSHOT_H
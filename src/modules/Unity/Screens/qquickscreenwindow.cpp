@@ -111,18 +111,11 @@ bool QQuickScreenWindow::setScaleAndFormFactor(const float scale, const FormFact
 
     auto id = screenHandle->outputId();
 
-    auto configs = controller->configuration();
-
-    auto config = configs.begin();
-    while (config != configs.end()) {
-        if (config->id == id) {
-            config->scale = scale;
-            config->formFactor = static_cast<MirFormFactor>(formFactor);
-        }
-        config++;
-    }
-
-    return controller->setConfiguration(configs);
+    // Both properties in a single display reconfiguration
+    return controller->beginTransaction()
+            .setScale(id, scale)
+            .setFormFactor(id, static_cast<MirFormFactor>(formFactor))
+            .commit();
 }
 
 FormFactor QQuickScreenWindow::formFactor()
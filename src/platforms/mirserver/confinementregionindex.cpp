@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "confinementregionindex.h"
+
+// std
+#include <algorithm>
+
+using namespace qtmir;
+
+ConfinementRegionIndex::ConfinementRegionIndex(const QVector<QRect> &regions)
+{
+    m_nodes.reserve(regions.count());
+    for (int i = 0; i < regions.count(); ++i) {
+        const QRect &region = regions[i];
+        if (region.isEmpty()) {
+            continue; // would never intersect anything anyway
+        }
+        m_nodes.append(Node{region, i, region.right(), region.top(), region.bottom()});
+    }
+
+    // Top edge as secondary key keeps regions stacked over the same columns in vertically
+    // contiguous subtrees, which the vertical bounds can then prune
+    std::sort(m_nodes.begin(), m_nodes.end(), [](const Node &a, const Node &b) {
+        return a.region.left() < b.region.left()
+                || (a.region.left() == b.region.left() && a.region.top() < b.region.top());
+    });
+
+    build(0, m_nodes.count());
+}
+
+const ConfinementRegionIndex::Node *ConfinementRegionIndex::build(int begin, int end)
+{
+    if (begin >= end) {
+        return nullptr;
+    }
+
+    const int middle = begin + (end - begin) / 2;
+    Node &node = m_nodes[middle];
+    for (const Node *child : {build(begin, middle), build(middle + 1, end)}) {
+        if (child) {
+            node.subtreeMaxRight = std::max(node.subtreeMaxRight, child->subtreeMaxRight);
+            node.subtreeMinTop = std::min(node.subtreeMinTop, child->subtreeMinTop);
+            node.subtreeMaxBottom = std::max(node.subtreeMaxBottom, child->subtreeMaxBottom);
+        }
+    }
+    return &node;
+}
+
+QRect ConfinementRegionIndex::regionFor(const QRect &rect) const
+{
+    if (m_nodes.isEmpty() || rect.isEmpty()) {
+        return QRect();
+    }
+
+    Match best;
+    query(0, m_nodes.count(), rect, best);
+
+    return best.node ? best.node->region : QRect();
+}
+
+void ConfinementRegionIndex::query(int begin, int end, const QRect &rect, Match &best) const
+{
+    if (begin >= end) {
+        return;
+    }
+
+    const int middle = begin + (end - begin) / 2;
+    const Node &node = m_nodes[middle];
+
+    // Nothing in this subtree reaches far enough right, or is at the right height, to intersect
+    if (node.subtreeMaxRight < rect.left()
+            || node.subtreeMaxBottom < rect.top() || node.subtreeMinTop > rect.bottom()) {
+        return;
+    }
+
+    query(begin, middle, rect, best);
+
+    // This node and everything to its right start past the rect
+    if (node.region.left() > rect.right()) {
+        return;
+    }
+
+    const QRect intersection = node.region.intersected(rect);
+    if (!intersection.isEmpty()) {
+        const qint64 area = qint64(intersection.width()) * intersection.height();
+        if (area > best.area || (area == best.area && node.order < best.node->order)) {
+            best.node = &node;
+            best.area = area;
+        }
+    }
+
+    query(middle + 1, end, rect, best);
+}
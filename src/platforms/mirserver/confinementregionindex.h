@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_CONFINEMENTREGIONINDEX_H
+#define QTMIR_CONFINEMENTREGIONINDEX_H
+
+#include <QRect>
+#include <QVector>
+
+namespace qtmir {
+
+/*
+  Answers "which confinement region applies to this window geometry" without going through every
+  region.
+
+  Regions are kept in an implicit, balanced interval tree ordered by left then top edge. Each node
+  knows the right-most edge and the vertical extent of its subtree, so that whole subtrees left of,
+  above or below the query are skipped. Side by side regions, regions stacked vertically over the
+  same columns and grids of outputs take O(log n + k) to query, k being the number of regions
+  actually intersecting the geometry. Arbitrarily overlapping layouts can degrade to O(n).
+
+  When several regions intersect the given geometry, the one sharing the largest area with it wins.
+  Ties go to the region listed first, so the shell can express precedence through ordering.
+
+  Immutable once built, so it can be shared between threads.
+ */
+class ConfinementRegionIndex
+{
+public:
+    ConfinementRegionIndex() = default;
+    explicit ConfinementRegionIndex(const QVector<QRect> &regions);
+
+    bool isEmpty() const { return m_nodes.isEmpty(); }
+    int count() const { return m_nodes.count(); }
+
+    // Returns a null QRect if no region intersects rect
+    QRect regionFor(const QRect &rect) const;
+
+private:
+    struct Node {
+        QRect region;
+        int order;
+        int subtreeMaxRight;
+        int subtreeMinTop;
+        int subtreeMaxBottom;
+    };
+
+    struct Match {
+        const Node *node{nullptr};
+        qint64 area{0};
+    };
+
+    const Node *build(int begin, int end);
+    void query(int begin, int end, const QRect &rect, Match &best) const;
+
+    QVector<Node> m_nodes; // sorted by left edge, subtree root of [begin, end) is at the middle
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_CONFINEMENTREGIONINDEX_H
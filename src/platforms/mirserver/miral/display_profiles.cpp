@@ -0,0 +1,296 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "display_profiles.h"
+#include "edid.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <sys/stat.h>
+
+namespace
+{
+uint32_t const magic = 0x51445052; // "QDPR"
+uint32_t const version = 2;
+
+// 64 bit FNV-1a, stable across runs
+struct Hash
+{
+    uint64_t value{14695981039346656037ULL};
+
+    Hash& add(void const* data, size_t size)
+    {
+        auto const bytes = static_cast<uint8_t const*>(data);
+        for (size_t i = 0; i != size; ++i)
+        {
+            value ^= bytes[i];
+            value *= 1099511628211ULL;
+        }
+        return *this;
+    }
+
+    template<typename T>
+    Hash& add(T const& pod) { return add(&pod, sizeof pod); }
+};
+
+template<typename T>
+void write_pod(std::ostream& out, T const& pod)
+{
+    out.write(reinterpret_cast<char const*>(&pod), sizeof pod);
+}
+
+template<typename T>
+bool read_pod(std::istream& in, T& pod)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&pod), sizeof pod));
+}
+
+// Field by field, the padding of Output is not worth storing
+void write_output(std::ostream& out, miral::DisplayProfiles::Output const& output)
+{
+    write_pod(out, output.identity);
+    write_pod(out, static_cast<uint8_t>(output.used));
+    write_pod(out, output.top_left_x);
+    write_pod(out, output.top_left_y);
+    write_pod(out, output.mode_width);
+    write_pod(out, output.mode_height);
+    write_pod(out, output.mode_refresh_hz);
+    write_pod(out, output.orientation);
+    write_pod(out, output.scale);
+    write_pod(out, output.form_factor);
+}
+
+bool read_output(std::istream& in, miral::DisplayProfiles::Output& output)
+{
+    uint8_t used = 0;
+    bool const ok = read_pod(in, output.identity)
+        && read_pod(in, used)
+        && read_pod(in, output.top_left_x)
+        && read_pod(in, output.top_left_y)
+        && read_pod(in, output.mode_width)
+        && read_pod(in, output.mode_height)
+        && read_pod(in, output.mode_refresh_hz)
+        && read_pod(in, output.orientation)
+        && read_pod(in, output.scale)
+        && read_pod(in, output.form_factor);
+    output.used = used != 0;
+    return ok;
+}
+
+void make_parent_directories(std::string const& path)
+{
+    for (auto slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1))
+    {
+        mkdir(path.substr(0, slash).c_str(), 0700);
+    }
+}
+}
+
+size_t const miral::DisplayProfiles::capacity;
+
+bool miral::DisplayProfiles::Output::operator==(Output const& other) const
+{
+    return identity == other.identity
+        && used == other.used
+        && top_left_x == other.top_left_x
+        && top_left_y == other.top_left_y
+        && mode_width == other.mode_width
+        && mode_height == other.mode_height
+        && mode_refresh_hz == other.mode_refresh_hz
+        && orientation == other.orientation
+        && scale == other.scale
+        && form_factor == other.form_factor;
+}
+
+miral::DisplayProfiles::DisplayProfiles(std::string const& path) :
+    path{path}
+{
+    load();
+}
+
+auto miral::DisplayProfiles::default_path() -> std::string
+{
+    if (auto const config_home = getenv("XDG_CONFIG_HOME"))
+        return std::string{config_home} + "/qtmir/display-profiles";
+
+    if (auto const home = getenv("HOME"))
+        return std::string{home} + "/.config/qtmir/display-profiles";
+
+    return {};
+}
+
+auto miral::DisplayProfiles::identity_of(std::vector<uint8_t> const& edid, int output_type, int output_id) -> uint64_t
+{
+    if (!edid.empty())
+    {
+        try
+        {
+            return identity_of(Edid{}.parse_data(edid));
+        }
+        catch (std::runtime_error const&)
+        {
+        }
+    }
+
+    return Hash{}.add(output_type).add(output_id).value;
+}
+
+auto miral::DisplayProfiles::identity_of(Edid const& edid) -> uint64_t
+{
+    Hash hash;
+    hash.add(edid.vendor.data(), edid.vendor.size());
+    hash.add(edid.product_code);
+    hash.add(edid.serial_number);
+
+    // Many monitors leave the serial number field empty and have a serial number descriptor instead
+    for (auto const& descriptor : edid.descriptors)
+    {
+        if (descriptor.type == Edid::Descriptor::Type::serial_number)
+        {
+            auto const& serial = descriptor.value.serial_number;
+            hash.add(serial, strnlen(serial, sizeof serial));
+        }
+    }
+
+    return hash.value;
+}
+
+auto miral::DisplayProfiles::key_of(std::vector<uint64_t> identities) -> uint64_t
+{
+    std::sort(identities.begin(), identities.end());
+
+    Hash hash;
+    for (auto const identity : identities)
+        hash.add(identity);
+    return hash.value;
+}
+
+bool miral::DisplayProfiles::lookup(uint64_t key, Profile& profile) const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const entry = profiles.find(key);
+    if (entry == profiles.end())
+        return false;
+
+    profile = entry->second.profile;
+    return true;
+}
+
+void miral::DisplayProfiles::save(uint64_t key, Profile const& profile)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+
+    auto const existing = profiles.find(key);
+    if (existing != profiles.end() && existing->second.profile == profile)
+        return;
+
+    profiles[key] = Entry{++serial, profile};
+
+    if (profiles.size() > capacity)
+    {
+        auto const oldest = std::min_element(profiles.begin(), profiles.end(),
+            [](std::pair<uint64_t const, Entry> const& lhs, std::pair<uint64_t const, Entry> const& rhs)
+            { return lhs.second.serial < rhs.second.serial; });
+        profiles.erase(oldest);
+    }
+
+    store();
+}
+
+auto miral::DisplayProfiles::size() const -> size_t
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return profiles.size();
+}
+
+auto miral::DisplayProfiles::file_writes() const -> uint64_t
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return writes;
+}
+
+// Layout: magic, version, profile count, then per profile its key, serial, output count and outputs
+void miral::DisplayProfiles::load()
+{
+    if (path.empty())
+        return;
+
+    std::ifstream in{path, std::ios::binary};
+
+    uint32_t file_magic = 0, file_version = 0, count = 0;
+    if (!read_pod(in, file_magic) || file_magic != magic ||
+        !read_pod(in, file_version) || file_version != version ||
+        !read_pod(in, count))
+        return; // missing, older or corrupt: start afresh
+
+    for (uint32_t i = 0; i != count && i != capacity; ++i)
+    {
+        uint64_t key;
+        Entry entry;
+        uint32_t outputs;
+        if (!read_pod(in, key) || !read_pod(in, entry.serial) || !read_pod(in, outputs) || outputs > 64)
+            break;
+
+        entry.profile.resize(outputs);
+        for (auto& output : entry.profile)
+        {
+            if (!read_output(in, output))
+                return;
+        }
+
+        serial = std::max(serial, entry.serial);
+        profiles[key] = std::move(entry);
+    }
+}
+
+bool miral::DisplayProfiles::store() const
+{
+    if (path.empty())
+        return false;
+
+    // Written aside and renamed over, so that a crash never leaves a truncated file behind
+    auto const temporary_path = path + ".new";
+    make_parent_directories(path);
+
+    {
+        std::ofstream out{temporary_path, std::ios::binary | std::ios::trunc};
+
+        write_pod(out, magic);
+        write_pod(out, version);
+        write_pod(out, static_cast<uint32_t>(profiles.size()));
+
+        for (auto const& profile : profiles)
+        {
+            write_pod(out, profile.first);
+            write_pod(out, profile.second.serial);
+            write_pod(out, static_cast<uint32_t>(profile.second.profile.size()));
+            for (auto const& output : profile.second.profile)
+                write_output(out, output);
+        }
+
+        if (!out.flush())
+            return false;
+    }
+
+    ++writes;
+    return std::rename(temporary_path.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright © 2017 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIRAL_DISPLAY_PROFILES_H
+#define MIRAL_DISPLAY_PROFILES_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Prototyping namespace for later incorporation in MirAL
+namespace miral
+{
+struct Edid;
+
+/// Display configurations saved per hardware profile, ie. per set of connected monitors.
+///
+/// Monitors are identified by the vendor, product code and serial number in their EDID, so that a
+/// profile is found again whichever connector they are plugged into. Profiles are kept in a small
+/// binary file, the least recently saved one is dropped when there are more than capacity of them.
+///
+/// Thread safety: all methods may be called from any thread.
+class DisplayProfiles
+{
+public:
+    /// The saved state of one output, mirroring the parts of mg::DisplayConfigurationOutput that
+    /// the shell can change. The power mode is left out on purpose: a profile saved while the
+    /// screen was blanked must not bring the output back switched off.
+    struct Output
+    {
+        uint64_t identity{0};
+        bool used{false};
+        int32_t top_left_x{0};
+        int32_t top_left_y{0};
+        int32_t mode_width{0};
+        int32_t mode_height{0};
+        double mode_refresh_hz{0};
+        int32_t orientation{0};
+        float scale{1};
+        int32_t form_factor{0};
+
+        bool operator==(Output const& other) const;
+    };
+    using Profile = std::vector<Output>;
+
+    explicit DisplayProfiles(std::string const& path = default_path());
+
+    /// Identity of a monitor, from its EDID. Monitors without a (valid) EDID fall back on the
+    /// identity of the connector, given as output type and id.
+    static auto identity_of(std::vector<uint8_t> const& edid, int output_type, int output_id) -> uint64_t;
+    static auto identity_of(Edid const& edid) -> uint64_t;
+
+    /// Key of the profile made of the given monitors, whatever their order
+    static auto key_of(std::vector<uint64_t> identities) -> uint64_t;
+
+    /// Returns false if there is no profile with that key
+    bool lookup(uint64_t key, Profile& profile) const;
+
+    /// Writes the file unless the profile was saved as is already
+    void save(uint64_t key, Profile const& profile);
+
+    auto size() const -> size_t;
+    auto file_writes() const -> uint64_t;
+
+    static auto default_path() -> std::string;
+    static size_t const capacity = 16;
+
+private:
+    struct Entry
+    {
+        uint64_t serial;
+        Profile profile;
+    };
+
+    void load();
+    bool store() const;
+
+    std::string const path;
+    mutable std::mutex mutex;
+    std::unordered_map<uint64_t, Entry> profiles;
+    uint64_t serial{0};
+    mutable uint64_t writes{0};
+};
+}
+
+#endif // MIRAL_DISPLAY_PROFILES_H
@@ -17,6 +17,9 @@
  */
 
 #include "persist_display_config.h"
+#include "display_profiles.h"
+
+#include <mir/graphics/display_configuration.h>
 
 #include <mir/graphics/display_configuration_policy.h>
 #include <mir/server.h>
@@ -27,6 +30,10 @@
 #include <mir/observer_registrar.h>
 #endif
 
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
 namespace mg = mir::graphics;
 
 namespace
@@ -40,8 +47,15 @@ struct PersistDisplayConfigPolicy
 
     void apply_to(mg::DisplayConfiguration& conf, mg::DisplayConfigurationPolicy& default_policy);
     void save_config(mg::DisplayConfiguration const& base_conf);
+
+    miral::DisplayProfiles profiles;
 };
 
+auto identity_of(mg::DisplayConfigurationOutput const& output) -> uint64_t
+{
+    return miral::DisplayProfiles::identity_of(output.edid, static_cast<int>(output.type), output.id.as_value());
+}
+
 struct DisplayConfigurationPolicyAdapter : mg::DisplayConfigurationPolicy
 {
     DisplayConfigurationPolicyAdapter(
@@ -140,12 +154,134 @@ void PersistDisplayConfigPolicy::apply_to(
     mg::DisplayConfiguration& conf,
     mg::DisplayConfigurationPolicy& default_policy)
 {
-    // TODO if the h/w profile (by some definition) has changed, then apply corresponding saved config (if any).
-    // TODO Otherwise...
+    // The saved configuration, if any, is laid over the default one. Outputs it doesn't cover (or whose
+    // saved mode is gone) keep the default settings. As it all happens before the configuration is
+    // applied, a known set of monitors gets to its final configuration with a single modeset.
     default_policy.apply_to(conf);
+    miral::apply_display_profile(profiles, conf);
 }
 
-void PersistDisplayConfigPolicy::save_config(mg::DisplayConfiguration const& /*base_conf*/)
+void PersistDisplayConfigPolicy::save_config(mg::DisplayConfiguration const& base_conf)
 {
-    // TODO save display config options against the h/w profile
+    std::vector<uint64_t> identities;
+    miral::DisplayProfiles::Profile profile;
+
+    base_conf.for_each_output([&](mg::DisplayConfigurationOutput const& output)
+        {
+            if (!output.connected)
+                return;
+
+            miral::DisplayProfiles::Output saved;
+            saved.identity = identity_of(output);
+            saved.used = output.used;
+            saved.top_left_x = output.top_left.x.as_int();
+            saved.top_left_y = output.top_left.y.as_int();
+            if (output.current_mode_index < output.modes.size())
+            {
+                auto const& mode = output.modes[output.current_mode_index];
+                saved.mode_width = mode.size.width.as_int();
+                saved.mode_height = mode.size.height.as_int();
+                saved.mode_refresh_hz = mode.vrefresh_hz;
+            }
+            saved.orientation = output.orientation;
+            saved.scale = output.scale;
+            saved.form_factor = output.form_factor;
+
+            identities.push_back(saved.identity);
+            profile.push_back(saved);
+        });
+
+    if (!profile.empty())
+        profiles.save(miral::DisplayProfiles::key_of(identities), profile);
+}
+
+auto miral::apply_display_profile(DisplayProfiles const& profiles, mg::DisplayConfiguration& conf) -> bool
+{
+    std::vector<uint64_t> identities;
+    std::unordered_map<int, uint64_t> identity_of_output;
+    conf.for_each_output([&](mg::DisplayConfigurationOutput const& output)
+        {
+            if (output.connected)
+            {
+                auto const identity = identity_of(output);
+                identities.push_back(identity);
+                identity_of_output[output.id.as_value()] = identity;
+            }
+        });
+
+    DisplayProfiles::Profile profile;
+    if (identities.empty() || !profiles.lookup(DisplayProfiles::key_of(identities), profile))
+        return false;
+
+    // What the profile overwrites, to put back should the result be invalid
+    struct OutputSettings
+    {
+        bool used;
+        size_t current_mode_index;
+        mir::geometry::Point top_left;
+        MirOrientation orientation;
+        float scale;
+        MirFormFactor form_factor;
+    };
+    std::unordered_map<int, OutputSettings> original_settings;
+
+    conf.for_each_output([&](mg::UserDisplayConfigurationOutput& output)
+        {
+            auto const identity = identity_of_output.find(output.id.as_value());
+            if (identity == identity_of_output.end())
+                return;
+
+            // Identical monitors lacking serial numbers share an identity, they get saved outputs in turn
+            auto const saved = std::find_if(profile.begin(), profile.end(),
+                [&](DisplayProfiles::Output const& candidate) { return candidate.identity == identity->second; });
+            if (saved == profile.end())
+                return;
+
+            auto const mode = std::find_if(output.modes.begin(), output.modes.end(),
+                [&](mg::DisplayConfigurationMode const& candidate)
+                {
+                    return candidate.size.width.as_int() == saved->mode_width
+                        && candidate.size.height.as_int() == saved->mode_height
+                        && std::abs(candidate.vrefresh_hz - saved->mode_refresh_hz) < 0.5;
+                });
+
+            if (mode != output.modes.end())
+            {
+                original_settings[output.id.as_value()] = OutputSettings{output.used, output.current_mode_index,
+                    output.top_left, output.orientation, output.scale, output.form_factor};
+
+                output.used = saved->used;
+                output.current_mode_index = mode - output.modes.begin();
+                output.top_left = mir::geometry::Point{saved->top_left_x, saved->top_left_y};
+                output.orientation = static_cast<MirOrientation>(saved->orientation);
+                output.scale = saved->scale;
+                output.form_factor = static_cast<MirFormFactor>(saved->form_factor);
+            }
+
+            profile.erase(saved);
+        });
+
+    if (original_settings.empty())
+        return false;
+
+    if (!conf.valid())
+    {
+        // Better the default configuration than none at all
+        conf.for_each_output([&](mg::UserDisplayConfigurationOutput& output)
+            {
+                auto const original = original_settings.find(output.id.as_value());
+                if (original == original_settings.end())
+                    return;
+
+                output.used = original->second.used;
+                output.current_mode_index = original->second.current_mode_index;
+                output.top_left = original->second.top_left;
+                output.orientation = original->second.orientation;
+                output.scale = original->second.scale;
+                output.form_factor = original->second.form_factor;
+            });
+        return false;
+    }
+
+    return true;
 }
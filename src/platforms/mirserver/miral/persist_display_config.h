@@ -22,7 +22,7 @@
 #include <functional>
 #include <memory>
 
-namespace mir { class Server; namespace graphics { class DisplayConfigurationPolicy; }}
+namespace mir { class Server; namespace graphics { class DisplayConfiguration; class DisplayConfigurationPolicy; }}
 
 // Prototyping namespace for later incorporation in MirAL
 namespace miral
@@ -47,6 +47,12 @@ private:
     struct Self;
     std::shared_ptr<Self> self;
 };
+
+class DisplayProfiles;
+
+/// Lays the profile saved for the connected outputs over conf. Should that make it invalid, conf is
+/// left as it was. Returns whether the profile was applied.
+auto apply_display_profile(DisplayProfiles const& profiles, mir::graphics::DisplayConfiguration& conf) -> bool;
 }
 
 #endif //MIRAL_PERSIST_DISPLAY_CONFIG_H
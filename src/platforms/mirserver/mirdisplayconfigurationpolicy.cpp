@@ -67,8 +67,6 @@ void MirDisplayConfigurationPolicy::apply_to(mg::DisplayConfiguration &conf)
 
     m_wrapped->apply_to(conf);
 
-    //TODO: scan through saved configurations and select matching one to apply
-
     // We want to apply a particular display config policy when connecting an external display
     // to a phone/tablet. We don't have a reliable way to distinguish a phone/tablet display
     // from a laptop display as yet.
@@ -76,12 +76,20 @@ QVariant NativeInterface::windowProperty(QPlatformWindow *window, const QString
     }
 }
 
-void NativeInterface::setWindowProperty(QPlatformWindow */*window*/, const QString &name, const QVariant &value)
+void NativeInterface::setWindowProperty(QPlatformWindow *window, const QString &name, const QVariant &value)
 {
     if (name.isNull()) {
         return;
     }
 
+    if (name == QStringLiteral("orientationLocked")) {
+        auto screen = window ? static_cast<Screen*>(static_cast<ScreenWindow*>(window)->screen()) : nullptr;
+        if (screen) {
+            screen->setOrientationLocked(value.toBool());
+        }
+        return;
+    }
+
     // TODO remove this hack and expose this properly when QtMir can share WindowController in a C++ header
 
     // Get WindowController
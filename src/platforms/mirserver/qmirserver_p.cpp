@@ -134,7 +134,7 @@ void QMirServerPrivate::run(const std::function<void()> &startCallback)
             m_openGLContextFactory,
             m_mirServerHooks,
             miral::set_window_management_policy<WindowManagementPolicy>(m_windowModelNotifier, m_windowController,
-                    m_appNotifier, screensModel),
+                    m_appNotifier, screensModel, qtmir::WindowStateStore::defaultFilePath()),
             addInitCallback,
             qtmir::SetQtCompositor{screensModel},
             setTerminator,
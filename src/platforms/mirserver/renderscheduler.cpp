@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderscheduler.h"
+
+using namespace qtmir;
+
+const int RenderScheduler::historySize;
+const int RenderScheduler::backoffFrames;
+
+void RenderScheduler::setRefreshRate(qreal hz)
+{
+    m_intervalNs = hz > 0 ? static_cast<qint64>(1000000000 / hz) : 0;
+    m_minMarginNs = qMax<qint64>(1000000, m_intervalNs / 10);
+    m_marginNs = m_minMarginNs;
+    m_lastVsyncNs = -1;
+}
+
+qint64 RenderScheduler::predictedRenderNs() const
+{
+    // Worst of the recent frames, a frame taking longer than predicted is a missed deadline
+    qint64 predicted = 0;
+    for (int i = 0; i < m_renderDurationCount; ++i) {
+        predicted = qMax(predicted, m_renderDurations[i]);
+    }
+    return predicted;
+}
+
+qint64 RenderScheduler::nextVsyncAfter(qint64 timeNs) const
+{
+    if (timeNs < m_lastVsyncNs) {
+        return m_lastVsyncNs;
+    }
+    return m_lastVsyncNs + ((timeNs - m_lastVsyncNs) / m_intervalNs + 1) * m_intervalNs;
+}
+
+qint64 RenderScheduler::scheduleStart(qint64 nowNs)
+{
+    m_lateStartScheduled = false;
+
+    if (m_intervalNs == 0 || m_lastVsyncNs < 0 || m_renderDurationCount == 0 || m_backoff > 0) {
+        return 0;
+    }
+
+    const qint64 latestStart = nextVsyncAfter(nowNs) - predictedRenderNs() - m_marginNs;
+    if (latestStart <= nowNs) {
+        return 0;
+    }
+
+    m_lateStartScheduled = true;
+    return latestStart - nowNs;
+}
+
+void RenderScheduler::frameStarted(qint64 nowNs)
+{
+    m_frameStartNs = nowNs;
+    m_targetVsyncNs = (m_intervalNs > 0 && m_lastVsyncNs >= 0)
+            ? nextVsyncAfter(nowNs + predictedRenderNs())
+            : -1;
+
+    if (m_lateStartScheduled) {
+        ++m_stats.lateStarts;
+        m_lateStartScheduled = false;
+    }
+}
+
+void RenderScheduler::renderFinished(qint64 nowNs)
+{
+    if (m_frameStartNs < 0) {
+        return;
+    }
+
+    m_renderDurations[m_nextRenderDuration] = nowNs - m_frameStartNs;
+    m_nextRenderDuration = (m_nextRenderDuration + 1) % historySize;
+    m_renderDurationCount = qMin(m_renderDurationCount + 1, historySize);
+}
+
+void RenderScheduler::frameSwapped(qint64 nowNs)
+{
+    if (m_frameStartNs >= 0) {
+        const qint64 latency = nowNs - m_frameStartNs;
+        ++m_stats.frames;
+        m_stats.totalLatencyNs += latency;
+        m_stats.maxLatencyNs = qMax(m_stats.maxLatencyNs, latency);
+
+        if (m_targetVsyncNs >= 0 && nowNs > m_targetVsyncNs + m_intervalNs / 2) {
+            ++m_stats.missedDeadlines;
+            m_marginNs = qMin(m_marginNs * 2, m_intervalNs / 2);
+            m_backoff = backoffFrames;
+        } else if (m_backoff > 0) {
+            --m_backoff;
+        } else {
+            m_marginNs = qMax(m_minMarginNs, m_marginNs - m_marginNs / 8);
+        }
+    }
+
+    m_lastVsyncNs = nowNs;
+    m_frameStartNs = -1;
+    m_targetVsyncNs = -1;
+}
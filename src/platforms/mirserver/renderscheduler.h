@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_RENDERSCHEDULER_H
+#define QTMIR_RENDERSCHEDULER_H
+
+#include <QtGlobal>
+
+namespace qtmir {
+
+/*
+  Decides when a Screen should start rendering its next frame. Instead of straight after the
+  previous swap, then blocking in the next one until vsync, rendering starts as late as possible:
+  at the vsync deadline minus the longest recent render duration and a safety margin. Input and
+  client buffers are sampled that much later, so what gets shown is that much fresher.
+
+  Missing a deadline doubles the safety margin (up to half a frame) and goes back to rendering
+  straight away for a while. The margin shrinks back as deadlines are met again.
+
+  Times are in nanoseconds, from any fixed reference. Not thread safe.
+ */
+class RenderScheduler
+{
+public:
+    struct Stats {
+        quint64 frames{0};
+        quint64 lateStarts{0}; // frames whose start got delayed
+        quint64 missedDeadlines{0};
+        qint64 totalLatencyNs{0}; // from the start of rendering until the frame got flipped
+        qint64 maxLatencyNs{0};
+
+        qint64 meanLatencyNs() const { return frames ? totalLatencyNs / static_cast<qint64>(frames) : 0; }
+    };
+
+    void setRefreshRate(qreal hz);
+
+    // How long to wait before starting the next frame
+    qint64 scheduleStart(qint64 nowNs);
+
+    void frameStarted(qint64 nowNs);
+    void renderFinished(qint64 nowNs); // about to swap
+    void frameSwapped(qint64 nowNs); // swap returned, ie. the frame got flipped at vsync
+
+    qint64 safetyMarginNs() const { return m_marginNs; }
+    qint64 predictedRenderNs() const;
+    Stats stats() const { return m_stats; }
+
+    static const int historySize = 8;
+    static const int backoffFrames = 30;
+
+private:
+    qint64 nextVsyncAfter(qint64 timeNs) const;
+
+    qint64 m_intervalNs{0};
+    qint64 m_minMarginNs{0};
+    qint64 m_marginNs{0};
+    qint64 m_lastVsyncNs{-1};
+
+    qint64 m_frameStartNs{-1};
+    qint64 m_targetVsyncNs{-1};
+    bool m_lateStartScheduled{false};
+    int m_backoff{0};
+
+    qint64 m_renderDurations[historySize] = {};
+    int m_renderDurationCount{0};
+    int m_nextRenderDuration{0};
+
+    Stats m_stats;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_RENDERSCHEDULER_H
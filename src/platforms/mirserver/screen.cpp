@@ -31,12 +31,15 @@
 #include <QGuiApplication>
 #include <qpa/qwindowsysteminterface.h>
 #include <QThread>
+#include <QWindow>
 #include <QtMath>
 
 // Qt sensors
 #include <QtSensors/QOrientationReading>
 #include <QtSensors/QOrientationSensor>
 
+#include <chrono>
+
 namespace mg = mir::geometry;
 
 namespace {
@@ -139,6 +142,11 @@ const QEvent::Type OrientationReadingEvent::m_type =
         static_cast<QEvent::Type>(QEvent::registerEventType());
 
 bool Screen::skipDBusRegistration = false;
+int Screen::orientationStabilityMs = 300;
+std::function<qint64()> Screen::clockNs = []() -> qint64 {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+};
 
 Screen::Screen(const mir::graphics::DisplayConfigurationOutput &screen)
     : QObject(nullptr)
@@ -147,11 +155,24 @@ Screen::Screen(const mir::graphics::DisplayConfigurationOutput &screen)
     , m_formFactor(mir_form_factor_unknown)
     , m_renderTarget(nullptr)
     , m_displayGroup(nullptr)
+    , m_powerMode(mir_power_mode_on)
+    , m_displayPowerOn(true)
+    , m_unpoweredSinceNs(-1)
+    , m_unpoweredNs(0)
     , m_orientationSensor(new QOrientationSensor(this))
+    , m_orientationLocked(false)
+    , m_pendingOrientation(Qt::PrimaryOrientation)
+    , m_orientationReadings(0)
+    , m_orientationChanges(0)
     , m_screenWindow(nullptr)
     , m_unityScreen(nullptr)
 {
+    m_lateStartRendering = qEnvironmentVariableIntValue("QTMIR_LATE_START_RENDERING") == 1;
+
     setMirDisplayConfiguration(screen, false);
+    if (!isPowered()) {
+        m_unpoweredSinceNs = clockNs();
+    }
 
     // Set the default orientation based on the initial screen dimmensions.
     m_nativeOrientation = (m_geometry.width() >= m_geometry.height())
@@ -163,10 +184,14 @@ Screen::Screen(const mir::graphics::DisplayConfigurationOutput &screen)
             ? Qt::LandscapeOrientation : Qt::PortraitOrientation;
     qCDebug(QTMIR_SENSOR_MESSAGES) << "Screen - initial currentOrientation is:" << m_currentOrientation;
 
+    m_orientationStabilityTimer.setSingleShot(true);
+    m_orientationStabilityTimer.setInterval(orientationStabilityMs);
+    QObject::connect(&m_orientationStabilityTimer, &QTimer::timeout, this, &Screen::applyPendingOrientation);
+
     if (internalDisplay()) { // only enable orientation sensor for device-internal display
         QObject::connect(m_orientationSensor, &QOrientationSensor::readingChanged,
                          this, &Screen::onOrientationReadingChanged);
-        m_orientationSensor->start();
+        updateSensors();
     }
 
     if (!skipDBusRegistration) {
@@ -202,8 +227,57 @@ void Screen::onDisplayPowerStateChanged(int status, int reason)
 {
     Q_UNUSED(reason);
     if (internalDisplay()) {
-        toggleSensors(status);
+        const bool wasPowered = isPowered();
+        m_displayPowerOn = status;
+        updatePowered(wasPowered);
+    }
+}
+
+void Screen::setOrientationLocked(bool locked)
+{
+    if (m_orientationLocked == locked) {
+        return;
+    }
+
+    m_orientationLocked = locked;
+    updateSensors();
+}
+
+// The orientation sensor is only worth running for the internal display, while it is lit and its
+// orientation isn't locked
+void Screen::updateSensors()
+{
+    if (internalDisplay()) {
+        toggleSensors(isPowered() && !m_orientationLocked);
+    }
+}
+
+void Screen::updatePowered(bool wasPowered)
+{
+    const bool powered = isPowered();
+    if (powered == wasPowered) {
+        return;
     }
+
+    if (powered) {
+        m_unpoweredNs += clockNs() - m_unpoweredSinceNs;
+        m_unpoweredSinceNs = -1;
+    } else {
+        m_unpoweredSinceNs = clockNs();
+    }
+
+    qCDebug(QTMIR_SCREENS) << "Screen::updatePowered" << this << powered;
+    updateSensors();
+    Q_EMIT poweredChanged(powered);
+}
+
+qint64 Screen::unpoweredMs() const
+{
+    qint64 ns = m_unpoweredNs;
+    if (m_unpoweredSinceNs >= 0) {
+        ns += clockNs() - m_unpoweredSinceNs;
+    }
+    return ns / 1000000;
 }
 
 void Screen::setMirDisplayConfiguration(const mir::graphics::DisplayConfigurationOutput &screen,
@@ -227,7 +301,11 @@ void Screen::setMirDisplayConfiguration(const mir::graphics::DisplayConfiguratio
     m_depth = 8 * MIR_BYTES_PER_PIXEL(screen.current_format);
 
     // Power mode
+    const bool wasPowered = isPowered();
     m_powerMode = screen.power_mode;
+    if (notify) {
+        updatePowered(wasPowered);
+    }
 
     QRect oldGeometry = m_geometry;
     // Position of screen in virtual desktop coordinate space
@@ -254,6 +332,10 @@ void Screen::setMirDisplayConfiguration(const mir::graphics::DisplayConfiguratio
     // Refresh rate
     if (m_refreshRate != mode.vrefresh_hz) {
         m_refreshRate = mode.vrefresh_hz;
+        {
+            QMutexLocker locker(&m_renderSchedulerMutex);
+            m_renderScheduler.setRefreshRate(m_refreshRate);
+        }
         if (notify) {
             QWindowSystemInterface::handleScreenRefreshRateChange(this->screen(), mode.vrefresh_hz);
         }
@@ -281,51 +363,97 @@ void Screen::setMirDisplayConfiguration(const mir::graphics::DisplayConfiguratio
     }
 }
 
-void Screen::toggleSensors(const bool enable) const
+void Screen::toggleSensors(const bool enable)
 {
     qCDebug(QTMIR_SENSOR_MESSAGES) << "Screen::toggleSensors - enable=" << enable;
     if (enable) {
         m_orientationSensor->start();
     } else {
         m_orientationSensor->stop();
+
+        // whatever was pending is stale by the time the sensor comes back
+        m_orientationStabilityTimer.stop();
+        m_pendingOrientation = Qt::PrimaryOrientation;
     }
 }
 
 void Screen::customEvent(QEvent* event)
 {
     OrientationReadingEvent* oReadingEvent = static_cast<OrientationReadingEvent*>(event);
+    Qt::ScreenOrientation orientation;
     switch (oReadingEvent->m_orientation) {
         case QOrientationReading::LeftUp: {
-            m_currentOrientation = (m_nativeOrientation == Qt::LandscapeOrientation) ?
+            orientation = (m_nativeOrientation == Qt::LandscapeOrientation) ?
                         Qt::InvertedPortraitOrientation : Qt::LandscapeOrientation;
             break;
         }
         case QOrientationReading::TopUp: {
-            m_currentOrientation = (m_nativeOrientation == Qt::LandscapeOrientation) ?
+            orientation = (m_nativeOrientation == Qt::LandscapeOrientation) ?
                         Qt::LandscapeOrientation : Qt::PortraitOrientation;
             break;
         }
         case QOrientationReading::RightUp: {
-            m_currentOrientation = (m_nativeOrientation == Qt::LandscapeOrientation) ?
+            orientation = (m_nativeOrientation == Qt::LandscapeOrientation) ?
                         Qt::PortraitOrientation : Qt::InvertedLandscapeOrientation;
             break;
         }
         case QOrientationReading::TopDown: {
-            m_currentOrientation = (m_nativeOrientation == Qt::LandscapeOrientation) ?
+            orientation = (m_nativeOrientation == Qt::LandscapeOrientation) ?
                         Qt::InvertedLandscapeOrientation : Qt::InvertedPortraitOrientation;
             break;
         }
         default: {
-            qWarning("Unknown orientation.");
-            event->accept();
-            return;
+            // FaceUp, FaceDown or Undefined
+            orientation = Qt::PrimaryOrientation;
+            break;
+        }
+    }
+
+    onOrientationReading(orientation);
+    event->accept();
+}
+
+/*
+ * Readings are debounced: a new orientation is only applied once the sensor reported it for
+ * orientationStabilityMs, as each change means a relayout of the whole shell and its apps.
+ * There's hysteresis too: leaving the current orientation takes that long, whereas a reading
+ * of the current orientation, or of the device lying flat, cancels a pending change right away.
+ */
+void Screen::onOrientationReading(Qt::ScreenOrientation orientation)
+{
+    if (orientation == Qt::PrimaryOrientation || orientation == m_currentOrientation) {
+        if (m_pendingOrientation != Qt::PrimaryOrientation) {
+            qCDebug(QTMIR_SENSOR_MESSAGES) << "Screen::onOrientationReading - cancelled" << m_pendingOrientation;
         }
+        m_orientationStabilityTimer.stop();
+        m_pendingOrientation = Qt::PrimaryOrientation;
+        if (orientation != Qt::PrimaryOrientation) {
+            ++m_orientationReadings;
+        }
+        return;
     }
 
+    ++m_orientationReadings;
+
+    if (orientation != m_pendingOrientation) {
+        m_pendingOrientation = orientation;
+        m_orientationStabilityTimer.start(); // restarts it if needed
+    }
+}
+
+void Screen::applyPendingOrientation()
+{
+    if (m_pendingOrientation == Qt::PrimaryOrientation || m_pendingOrientation == m_currentOrientation) {
+        return;
+    }
+
+    m_currentOrientation = m_pendingOrientation;
+    m_pendingOrientation = Qt::PrimaryOrientation;
+    ++m_orientationChanges;
+
     // Raise the event signal so that client apps know the orientation changed
     QWindowSystemInterface::handleScreenOrientationChange(screen(), m_currentOrientation);
-    event->accept();
-    qCDebug(QTMIR_SENSOR_MESSAGES) << "Screen::customEvent - new orientation" << m_currentOrientation << "handled";
+    qCDebug(QTMIR_SENSOR_MESSAGES) << "Screen::applyPendingOrientation - new orientation" << m_currentOrientation << "handled";
 }
 
 void Screen::onOrientationReadingChanged()
@@ -361,12 +489,22 @@ void Screen::setWindow(ScreenWindow *window)
     if (window && m_screenWindow) {
         qCDebug(QTMIR_SCREENS) << "Screen::setWindow - overwriting existing ScreenWindow";
     }
+    if (m_screenWindow && m_screenWindow->window()) {
+        m_screenWindow->window()->removeEventFilter(this);
+    }
     m_screenWindow = window;
 
     if (m_screenWindow) {
+        // Qt starts a frame upon an update request, see eventFilter()
+        if (m_screenWindow->window()) {
+            m_screenWindow->window()->installEventFilter(this);
+        }
+
         auto nativeInterface = qGuiApp->platformNativeInterface();
-        Q_EMIT nativeInterface->windowPropertyChanged(m_screenWindow, QStringLiteral("formFactor"));
-        Q_EMIT nativeInterface->windowPropertyChanged(m_screenWindow, QStringLiteral("scale"));
+        if (nativeInterface) { // not with other platforms, eg. in tests
+            Q_EMIT nativeInterface->windowPropertyChanged(m_screenWindow, QStringLiteral("formFactor"));
+            Q_EMIT nativeInterface->windowPropertyChanged(m_screenWindow, QStringLiteral("scale"));
+        }
 
         if (m_screenWindow->geometry() != geometry()) {
             qCDebug(QTMIR_SCREENS) << "Screen::setWindow - new geometry for shell surface" << window->window() << geometry();
@@ -385,6 +523,11 @@ void Screen::setMirDisplayBuffer(mir::graphics::DisplayBuffer *buffer, mir::grap
 
 void Screen::swapBuffers()
 {
+    {
+        QMutexLocker locker(&m_renderSchedulerMutex);
+        m_renderScheduler.renderFinished(clockNs());
+    }
+
     m_renderTarget->swap_buffers();
 
     /* FIXME this exposes a QtMir architecture problem, as Screen is supposed to wrap a mg::DisplayBuffer.
@@ -399,6 +542,32 @@ void Screen::swapBuffers()
      * Integrating the Qt Scenegraph renderer as a Mir renderer should solve this issue.
      */
     m_displayGroup->post();
+
+    QMutexLocker locker(&m_renderSchedulerMutex);
+    m_renderScheduler.frameSwapped(clockNs());
+}
+
+qint64 Screen::scheduleRenderStart()
+{
+    QMutexLocker locker(&m_renderSchedulerMutex);
+    return m_renderScheduler.scheduleStart(clockNs());
+}
+
+// The update request is where Qt polishes, syncs and then renders the scene, whatever the path it took,
+// so timing frames from there covers them all whether late start rendering is on or not
+bool Screen::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::UpdateRequest && m_screenWindow && watched == m_screenWindow->window()) {
+        QMutexLocker locker(&m_renderSchedulerMutex);
+        m_renderScheduler.frameStarted(clockNs());
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+qtmir::RenderScheduler::Stats Screen::renderStats() const
+{
+    QMutexLocker locker(&m_renderSchedulerMutex);
+    return m_renderScheduler.stats();
 }
 
 void Screen::makeCurrent()
@@ -18,17 +18,21 @@
 #define SCREEN_H
 
 // Qt
+#include <QMutex>
 #include <QObject>
 #include <QScopedPointer>
 #include <QTimer>
 #include <QtDBus/QDBusInterface>
 #include <qpa/qplatformscreen.h>
 
+#include <functional>
+
 // Mir
 #include <mir_toolkit/common.h>
 
 // local
 #include "cursor.h"
+#include "renderscheduler.h"
 #include "screenwindow.h"
 #include "screentypes.h"
 
@@ -64,14 +68,44 @@ public:
     qtmir::OutputTypes outputType() const { return m_type; }
     uint32_t currentModeIndex() const { return m_currentModeIndex; }
 
+    // Whether the display is lit, either side (Mir power mode or display power state) may turn it off.
+    // Nothing gets rendered for a screen which isn't.
+    bool isPowered() const { return m_powerMode == mir_power_mode_on && m_displayPowerOn; }
+
+    // Total time the display spent off, in milliseconds
+    qint64 unpoweredMs() const;
+
     ScreenWindow* window() const;
 
+    // Opt-in (QTMIR_LATE_START_RENDERING=1): rendering starts as late as it can to still make it
+    // for the next vsync, instead of right after the previous frame got flipped
+    bool lateStartRendering() const { return m_lateStartRendering; }
+    // Timings of every frame started by an update request, whether started late or not
+    qtmir::RenderScheduler::Stats renderStats() const;
+
     // QObject methods.
     void customEvent(QEvent* event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+    // The shell locks the orientation, eg. for a fullscreen app which supports only one. There's no
+    // point in running the orientation sensor meanwhile.
+    void setOrientationLocked(bool locked);
+    bool orientationLocked() const { return m_orientationLocked; }
+
+    // Sensor readings which didn't cause an orientation change, thus a relayout, as they were
+    // either unstable or not a change at all
+    quint64 orientationRelayoutsAvoided() const { return m_orientationReadings - m_orientationChanges; }
 
     // To make it testable
     static bool skipDBusRegistration;
+    static int orientationStabilityMs;
+    static std::function<qint64()> clockNs; // monotonic, in nanoseconds
     bool orientationSensorEnabled();
+    // Qt::PrimaryOrientation for readings which don't map to a screen orientation (eg. lying flat)
+    void onOrientationReading(Qt::ScreenOrientation orientation);
+
+Q_SIGNALS:
+    void poweredChanged(bool powered);
 
 public Q_SLOTS:
    void onDisplayPowerStateChanged(int, int);
@@ -86,9 +120,15 @@ protected:
     void makeCurrent();
     void doneCurrent();
 
+    // With late start rendering, the time to wait before starting the next frame, in nanoseconds
+    qint64 scheduleRenderStart();
+
 private:
-    void toggleSensors(const bool enable) const;
+    void toggleSensors(const bool enable);
+    void updateSensors();
+    void applyPendingOrientation();
     bool internalDisplay() const;
+    void updatePowered(bool wasPowered);
 
     QRect m_geometry;
     int m_depth;
@@ -105,16 +145,28 @@ private:
     qtmir::OutputId m_outputId;
     qtmir::OutputTypes m_type;
     MirPowerMode m_powerMode;
+    bool m_displayPowerOn;
+    qint64 m_unpoweredSinceNs;
+    qint64 m_unpoweredNs;
 
     Qt::ScreenOrientation m_nativeOrientation;
     Qt::ScreenOrientation m_currentOrientation;
     QOrientationSensor *m_orientationSensor;
+    bool m_orientationLocked;
+    Qt::ScreenOrientation m_pendingOrientation;
+    QTimer m_orientationStabilityTimer;
+    quint64 m_orientationReadings;
+    quint64 m_orientationChanges;
 
     ScreenWindow *m_screenWindow;
     QDBusInterface *m_unityScreen;
 
     QScopedPointer<qtmir::Cursor> m_cursor;
 
+    bool m_lateStartRendering{false};
+    mutable QMutex m_renderSchedulerMutex; // used by the GUI and render threads
+    qtmir::RenderScheduler m_renderScheduler;
+
     friend class ScreensModel;
     friend class ScreenWindow;
 };
@@ -57,29 +57,127 @@ CustomScreenConfigurationList ScreensController::configuration()
 
 bool ScreensController::setConfiguration(const CustomScreenConfigurationList &newConfig)
 {
-    using namespace mir::geometry;
-
-    auto displayConfiguration = m_display->configuration();
+    auto transaction = beginTransaction();
 
     Q_FOREACH (const auto &config, newConfig) {
-        displayConfiguration->for_each_output(
-            [&config](mg::UserDisplayConfigurationOutput &outputConfig)
-            {
-                if (config.id == outputConfig.id) {
-                    outputConfig.current_mode_index = config.currentModeIndex;
-                    outputConfig.top_left = Point{ X{config.topLeft.x()}, Y{config.topLeft.y()}};
-                    outputConfig.power_mode = config.powerMode;
-//                    outputConfig.orientation = config.orientation; // disabling for now
-                    outputConfig.scale = config.scale;
-                    outputConfig.form_factor = config.formFactor;
-                }
-            });
+        transaction.setCurrentModeIndex(config.id, config.currentModeIndex)
+                   .setTopLeft(config.id, config.topLeft)
+                   .setPowerMode(config.id, config.powerMode)
+//                   .setOrientation(config.id, config.orientation) // disabling for now
+                   .setScale(config.id, config.scale)
+                   .setFormFactor(config.id, config.formFactor);
     }
 
+    return transaction.commit();
+}
+
+ScreensController::Transaction ScreensController::beginTransaction()
+{
+    return Transaction(this);
+}
+
+bool ScreensController::apply(std::unique_ptr<mg::DisplayConfiguration> displayConfiguration)
+{
     if (!displayConfiguration->valid()) {
         return false;
     }
 
+    // Swapping the base configuration stops the compositor, don't do it for nothing. The Screens only
+    // reflect what Mir has applied though: while an earlier request is still in flight a configuration
+    // matching them may be undoing it, so it has to go through.
+    if (!m_screensModel->expectingConfiguration()
+            && m_screensModel->classify(*displayConfiguration) == ScreensModel::ConfigurationChange::None) {
+        return true;
+    }
+
+    m_screensModel->expectConfiguration(*displayConfiguration);
     m_displayConfigurationController->set_base_configuration(std::move(displayConfiguration));
     return true;
 }
+
+ScreensController::Transaction::Transaction(ScreensController *controller)
+    : m_controller(controller)
+{
+}
+
+ScreensController::Transaction &ScreensController::Transaction::setTopLeft(qtmir::OutputId id, const QPoint &topLeft)
+{
+    Change &change = m_changes[id.as_value()];
+    change.fields |= Change::TopLeft;
+    change.topLeft = topLeft;
+    return *this;
+}
+
+ScreensController::Transaction &ScreensController::Transaction::setCurrentModeIndex(qtmir::OutputId id, uint32_t modeIndex)
+{
+    Change &change = m_changes[id.as_value()];
+    change.fields |= Change::CurrentModeIndex;
+    change.currentModeIndex = modeIndex;
+    return *this;
+}
+
+ScreensController::Transaction &ScreensController::Transaction::setPowerMode(qtmir::OutputId id, MirPowerMode powerMode)
+{
+    Change &change = m_changes[id.as_value()];
+    change.fields |= Change::PowerMode;
+    change.powerMode = powerMode;
+    return *this;
+}
+
+ScreensController::Transaction &ScreensController::Transaction::setScale(qtmir::OutputId id, float scale)
+{
+    Change &change = m_changes[id.as_value()];
+    change.fields |= Change::Scale;
+    change.scale = scale;
+    return *this;
+}
+
+ScreensController::Transaction &ScreensController::Transaction::setFormFactor(qtmir::OutputId id, MirFormFactor formFactor)
+{
+    Change &change = m_changes[id.as_value()];
+    change.fields |= Change::FormFactor;
+    change.formFactor = formFactor;
+    return *this;
+}
+
+bool ScreensController::Transaction::commit()
+{
+    using namespace mir::geometry;
+
+    if (m_changes.isEmpty()) {
+        return true;
+    }
+
+    auto displayConfiguration = m_controller->m_display->configuration();
+
+    // One pass over the outputs, whatever the number of screens and properties changed
+    displayConfiguration->for_each_output(
+        [this](mg::UserDisplayConfigurationOutput &outputConfig)
+        {
+            auto it = m_changes.constFind(outputConfig.id.as_value());
+            if (it == m_changes.constEnd()) {
+                return;
+            }
+
+            const Change &change = it.value();
+            if (change.fields & Change::CurrentModeIndex) {
+                outputConfig.current_mode_index = change.currentModeIndex;
+            }
+            if (change.fields & Change::TopLeft) {
+                outputConfig.top_left = Point{ X{change.topLeft.x()}, Y{change.topLeft.y()}};
+            }
+            if (change.fields & Change::PowerMode) {
+                outputConfig.power_mode = change.powerMode;
+            }
+            if (change.fields & Change::Scale) {
+                outputConfig.scale = change.scale;
+            }
+            if (change.fields & Change::FormFactor) {
+                outputConfig.form_factor = change.formFactor;
+            }
+        });
+
+    m_changes.clear();
+
+    return m_controller->apply(std::move(displayConfiguration));
+}
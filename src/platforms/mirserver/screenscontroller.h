@@ -18,7 +18,9 @@
 #define SCREENSCONTROLLER_H
 
 // Qt
+#include <QHash>
 #include <QObject>
+#include <QPoint>
 #include <QSharedPointer>
 #include <QVector>
 
@@ -30,7 +32,7 @@
 class ScreensModel;
 
 namespace mir {
-    namespace graphics { class Display; }
+    namespace graphics { class Display; class DisplayConfiguration; }
     namespace shell { class DisplayConfigurationController; }
 }
 
@@ -45,10 +47,53 @@ public:
                                const std::shared_ptr<mir::shell::DisplayConfigurationController> &controller,
                                QObject *parent = 0);
 
+    /*
+     * Accumulates changes to any number of screens, which commit() then validates and hands to Mir
+     * as a single configuration, so they cost one display reconfiguration whatever their number.
+     * Properties not set are left as they are.
+     */
+    class Transaction
+    {
+    public:
+        Transaction &setTopLeft(qtmir::OutputId id, const QPoint &topLeft);
+        Transaction &setCurrentModeIndex(qtmir::OutputId id, uint32_t modeIndex);
+        Transaction &setPowerMode(qtmir::OutputId id, MirPowerMode powerMode);
+        Transaction &setScale(qtmir::OutputId id, float scale);
+        Transaction &setFormFactor(qtmir::OutputId id, MirFormFactor formFactor);
+
+        bool isEmpty() const { return m_changes.isEmpty(); }
+
+        // Returns false if the resulting configuration is invalid, in which case nothing is applied
+        bool commit();
+
+    private:
+        friend class ScreensController;
+        explicit Transaction(ScreensController *controller);
+
+        struct Change
+        {
+            enum Field { TopLeft = 0x1, CurrentModeIndex = 0x2, PowerMode = 0x4, Scale = 0x8, FormFactor = 0x10 };
+            int fields{0};
+
+            QPoint topLeft;
+            uint32_t currentModeIndex{0};
+            MirPowerMode powerMode{mir_power_mode_on};
+            float scale{1.0f};
+            MirFormFactor formFactor{mir_form_factor_unknown};
+        };
+
+        ScreensController *m_controller;
+        QHash<int, Change> m_changes; // by output id
+    };
+
     CustomScreenConfigurationList configuration();
     bool setConfiguration(const CustomScreenConfigurationList &newConfig);
 
+    Transaction beginTransaction();
+
 private:
+    bool apply(std::unique_ptr<mir::graphics::DisplayConfiguration> displayConfiguration);
+
     const QSharedPointer<ScreensModel> m_screensModel;
     const std::shared_ptr<mir::graphics::Display> m_display;
     const std::shared_ptr<mir::shell::DisplayConfigurationController> m_displayConfigurationController;
@@ -22,6 +22,7 @@
 #include "mirserverintegration.h"
 #include "screen.h"
 #include "mirqtconversion.h"
+#include "tracepoints.h" // generated from tracepoints.tp
 
 // Mir
 #include <mir/graphics/display.h>
@@ -39,6 +40,26 @@
 
 namespace mg = mir::graphics;
 
+namespace {
+
+// How long an announced configuration is awaited. Should it not cause the compositor to stop
+// (eg. it was rejected), a later, unannounced, change must not be mistaken for it.
+const qint64 expectationTimeoutMs = 1000;
+
+const char *changeToStr(ScreensModel::ConfigurationChange change)
+{
+    switch (change) {
+    case ScreensModel::ConfigurationChange::None:
+        return "none";
+    case ScreensModel::ConfigurationChange::Live:
+        return "live";
+    case ScreensModel::ConfigurationChange::Structural:
+        return "structural";
+    }
+    return "???";
+}
+
+} // namespace {
 
 ScreensModel::ScreensModel(QObject *parent)
     : QObject(parent)
@@ -82,6 +103,20 @@ void ScreensModel::onCompositorStarting()
     update(); // must handle all hardware changes before starting the renderer
 
     startRenderer();
+
+    if (m_blackoutTimer.isValid()) {
+        const qint64 ms = m_blackoutTimer.elapsed();
+        m_blackoutTimer.invalidate();
+
+        BlackoutStats &stats = m_blackoutStats[static_cast<int>(m_blackoutChange)];
+        ++stats.count;
+        stats.totalMs += ms;
+        stats.maxMs = qMax(stats.maxMs, ms);
+
+        tracepoint(qtmirserver, screensBlackout, static_cast<int>(m_blackoutChange), ms);
+        qCDebug(QTMIR_SCREENS) << "ScreensModel - rendering resumed after" << ms << "ms for a"
+                               << changeToStr(m_blackoutChange) << "configuration change";
+    }
 }
 
 void ScreensModel::onCompositorStopping()
@@ -89,11 +124,105 @@ void ScreensModel::onCompositorStopping()
     qCDebug(QTMIR_SCREENS) << "ScreensModel::onCompositorStopping";
     m_compositing = false;
 
-    haltRenderer(); // must stop all rendering before handling any hardware changes
+    m_blackoutChange = takeExpectedChange();
+    m_blackoutTimer.start();
+
+    // must stop all rendering before handling any hardware changes
+    haltRenderer(m_blackoutChange == ConfigurationChange::Structural);
 
     update();
 }
 
+void ScreensModel::expectConfiguration(const mg::DisplayConfiguration &config)
+{
+    // Mir may apply a pending configuration before this one, so the renderer has to cope with either
+    const ConfigurationChange change = classify(config);
+    m_expectedChange = expectingConfiguration() ? qMax(m_expectedChange, change) : change;
+    m_expectationTimer.start();
+    qCDebug(QTMIR_SCREENS) << "ScreensModel::expectConfiguration - change is" << changeToStr(m_expectedChange);
+}
+
+bool ScreensModel::expectingConfiguration() const
+{
+    return m_expectationTimer.isValid() && !m_expectationTimer.hasExpired(expectationTimeoutMs);
+}
+
+ScreensModel::ConfigurationChange ScreensModel::takeExpectedChange()
+{
+    ConfigurationChange change = ConfigurationChange::Structural;
+    if (expectingConfiguration()) {
+        change = m_expectedChange;
+    }
+    m_expectationTimer.invalidate();
+    m_expectedChange = ConfigurationChange::Structural;
+    return change;
+}
+
+ScreensModel::BlackoutStats ScreensModel::blackoutStats(ConfigurationChange change) const
+{
+    return m_blackoutStats[static_cast<int>(change)];
+}
+
+ScreensModel::ConfigurationChange ScreensModel::classify(const mg::DisplayConfiguration &config) const
+{
+    ConfigurationChange change = ConfigurationChange::None;
+    int matchedScreens = 0;
+
+    config.for_each_output([&](const mg::DisplayConfigurationOutput &output) {
+        if (!output.used || !output.connected) {
+            return;
+        }
+
+        Screen *screen = nullptr;
+        for (Screen *candidate : m_screenList) {
+            if (candidate->outputId() == output.id) {
+                screen = candidate;
+                break;
+            }
+        }
+
+        if (!screen) {
+            change = ConfigurationChange::Structural;
+            return;
+        }
+
+        ++matchedScreens;
+        change = qMax(change, classify(screen, output));
+    });
+
+    if (matchedScreens != m_screenList.count()) { // some output went away
+        change = ConfigurationChange::Structural;
+    }
+    return change;
+}
+
+ScreensModel::ConfigurationChange ScreensModel::classify(const Screen *screen, const mg::DisplayConfigurationOutput &output)
+{
+    // Anything which needs new display buffers from Mir invalidates what the renderer holds
+    if (output.current_mode_index >= output.modes.size()
+            || output.current_mode_index != screen->currentModeIndex()) {
+        return ConfigurationChange::Structural;
+    }
+
+    const auto &mode = output.modes[output.current_mode_index];
+    if (mode.size.width.as_int() != screen->geometry().width()
+            || mode.size.height.as_int() != screen->geometry().height()
+            || !qFuzzyCompare(mode.vrefresh_hz, screen->refreshRate())
+            || static_cast<int>(8 * MIR_BYTES_PER_PIXEL(output.current_format)) != screen->depth()) {
+        return ConfigurationChange::Structural;
+    }
+
+    if (output.top_left.x.as_int() != screen->geometry().x()
+            || output.top_left.y.as_int() != screen->geometry().y()
+            || !qFuzzyCompare(output.scale, screen->scale())
+            || output.form_factor != screen->formFactor()
+            || output.power_mode != screen->powerMode()) {
+        return ConfigurationChange::Live;
+    }
+
+    return ConfigurationChange::None;
+}
+
 void ScreensModel::update()
 {
     qCDebug(QTMIR_SCREENS) << "ScreensModel::update";
@@ -146,6 +275,7 @@ void ScreensModel::update()
 
     // Announce new Screens to Qt
     Q_FOREACH (auto screen, newScreenList) {
+        connect(screen, &Screen::poweredChanged, this, [this, screen]() { onScreenPoweredChanged(screen); });
         Q_EMIT screenAdded(screen);
         m_displayListener->add_display(qtmir::toMirRectangle(screen->geometry()));
     }
@@ -226,28 +356,52 @@ bool ScreensModel::canUpdateExistingScreen(const Screen *screen, const mg::Displ
 void ScreensModel::startRenderer()
 {
     Q_FOREACH (const auto screen, m_screenList) {
+        const auto window = static_cast<ScreenWindow *>(screen->window());
+        if (!window || !window->window()) {
+            continue;
+        }
+
         // Only set windows exposed on displays which are turned on, as the GL context Mir provided
-        // is invalid in that situation
-        if (screen->powerMode() == mir_power_mode_on) {
-            const auto window = static_cast<ScreenWindow *>(screen->window());
-            if (window && window->window()) {
-                window->setExposed(true);
-            }
+        // is invalid in that situation, and nobody would see the result anyway
+        if (screen->isPowered()) {
+            window->setExposed(true);
+        } else {
+            window->suspendRendering();
         }
     }
 }
 
+void ScreensModel::onScreenPoweredChanged(Screen *screen)
+{
+    if (!m_compositing) {
+        return; // startRenderer() will take it into account
+    }
+
+    const auto window = static_cast<ScreenWindow *>(screen->window());
+    if (!window || !window->window()) {
+        return;
+    }
+
+    qCDebug(QTMIR_SCREENS) << "ScreensModel::onScreenPoweredChanged" << screen << screen->isPowered();
+    if (screen->isPowered()) {
+        window->setExposed(true);
+    } else {
+        window->suspendRendering();
+    }
+}
+
 /*
  * ScreensModel::haltRenderer()
  * Stop Qt's render thread(s) by setting all windows with a corresponding screen to not exposed.
+ * Unless a rebuild is asked for, their GL context and scene graph are kept for when they resume.
  * It is blocking, it returns after the render thread(s) have all stopped.
  */
-void ScreensModel::haltRenderer()
+void ScreensModel::haltRenderer(bool rebuild)
 {
     Q_FOREACH (const auto screen, m_screenList) {
         const auto window = static_cast<ScreenWindow *>(screen->window());
         if (window && window->window()) {
-            window->setExposed(false);
+            window->setExposed(false, !rebuild);
         }
     }
 }
@@ -17,6 +17,7 @@
 #ifndef SCREENCONTROLLER_H
 #define SCREENCONTROLLER_H
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QPoint>
 
@@ -43,6 +44,13 @@ class QtCompositor;
  * 2. to stop the Qt renderer by hiding its QWindow when Mir wants to stop all compositing,
  *    and resume Qt's renderer by showing its QWindow when Mir wants to resume compositing.
  *
+ * Mir stops the compositor for every configuration change. Only structural changes (outputs
+ * added or removed, or a new mode) need the Qt scene graph and GL context to be rebuilt though,
+ * the others are applied to the existing Screens and rendering resumes with all GL resources
+ * intact. The time spent without rendering is measured for every change.
+ *
+ * 3. to suspend rendering to screens which are powered off, and resume it once they are back on.
+ *
  *
  * Threading Note:
  * This object must have affinity to the main Qt GUI thread, as it creates & destroys Platform
@@ -65,6 +73,30 @@ public:
 
     QWindow* getWindowForPoint(QPoint point);
 
+    enum class ConfigurationChange {
+        None,
+        Live,      // position, scale, form factor or power mode: applied to the existing Screens
+        Structural // outputs added or removed, or a mode change: the renderer needs rebuilding
+    };
+
+    ConfigurationChange classify(const mir::graphics::DisplayConfiguration &config) const;
+    static ConfigurationChange classify(const Screen *screen, const mir::graphics::DisplayConfigurationOutput &output);
+
+    // To be called just before the given configuration is applied, so the renderer is only rebuilt
+    // if needed when the compositor stops. Unannounced changes (eg. hotplug) are taken as structural.
+    void expectConfiguration(const mir::graphics::DisplayConfiguration &config);
+
+    // Whether an announced configuration has not reached the Screens yet
+    bool expectingConfiguration() const;
+
+    // Time between the compositor stopping and rendering being resumed, by kind of change
+    struct BlackoutStats {
+        int count{0};
+        qint64 totalMs{0};
+        qint64 maxMs{0};
+    };
+    BlackoutStats blackoutStats(ConfigurationChange change) const;
+
 Q_SIGNALS:
     void screenAdded(Screen *screen);
     void screenRemoved(Screen *screen);
@@ -91,13 +123,21 @@ private:
     Screen* findScreenWithId(const QList<Screen*> &list, const mir::graphics::DisplayConfigurationOutputId id);
     bool canUpdateExistingScreen(const Screen *screen, const mir::graphics::DisplayConfigurationOutput &output);
     void startRenderer();
-    void haltRenderer();
+    void haltRenderer(bool rebuild);
+    void onScreenPoweredChanged(Screen *screen);
+    ConfigurationChange takeExpectedChange();
 
     std::weak_ptr<mir::graphics::Display> m_display;
     std::shared_ptr<QtCompositor> m_compositor;
     std::shared_ptr<mir::compositor::DisplayListener> m_displayListener;
     QList<Screen*> m_screenList;
     bool m_compositing;
+
+    ConfigurationChange m_expectedChange{ConfigurationChange::Structural};
+    QElapsedTimer m_expectationTimer;
+    ConfigurationChange m_blackoutChange{ConfigurationChange::Structural};
+    QElapsedTimer m_blackoutTimer;
+    BlackoutStats m_blackoutStats[static_cast<int>(ConfigurationChange::Structural) + 1];
 };
 
 #endif // SCREENCONTROLLER_H
@@ -25,6 +25,8 @@
 #include <qpa/qwindowsysteminterface.h>
 #include <qpa/qplatformscreen.h>
 #include <QQuickWindow>
+#include <QTimer>
+#include <QtGui/private/qwindow_p.h>
 #include <QtQuick/private/qsgrenderloop_p.h>
 #include <QDebug>
 
@@ -40,17 +42,24 @@ static WId newWId()
     return ++id;
 }
 
+// Note: window->screen() is set to the primaryScreen(), if not specified explicitly.
 ScreenWindow::ScreenWindow(QWindow *window)
+    : ScreenWindow(window, static_cast<Screen *>(window->screen()->handle()))
+{
+}
+
+ScreenWindow::ScreenWindow(QWindow *window, Screen *screen)
     : QPlatformWindow(window)
     , m_exposed(false)
+    , m_renderingSuspended(false)
+    , m_suppressedUpdateRequests(0)
     , m_winId(newWId())
+    , m_screen(screen)
 {
-    // Note: window->screen() is set to the primaryScreen(), if not specified explicitly.
-    const auto myScreen = static_cast<Screen *>(window->screen()->handle());
-    myScreen->setWindow(this);
-    qCDebug(QTMIR_SCREENS) << "ScreenWindow" << this << "with window ID" << uint(m_winId) << "backed by" << myScreen << "with ID" << myScreen->outputId().as_value();
+    m_screen->setWindow(this);
+    qCDebug(QTMIR_SCREENS) << "ScreenWindow" << this << "with window ID" << uint(m_winId) << "backed by" << m_screen << "with ID" << m_screen->outputId().as_value();
 
-    QRect screenGeometry(screen()->availableGeometry());
+    QRect screenGeometry(m_screen->availableGeometry());
     if (window->geometry() != screenGeometry) {
         setGeometry(screenGeometry);
         window->setGeometry(screenGeometry);
@@ -61,7 +70,7 @@ ScreenWindow::ScreenWindow(QWindow *window)
 ScreenWindow::~ScreenWindow()
 {
     qCDebug(QTMIR_SCREENS) << "Destroying ScreenWindow" << this;
-    static_cast<Screen *>(screen())->setWindow(nullptr);
+    m_screen->setWindow(nullptr);
 }
 
 bool ScreenWindow::isExposed() const
@@ -69,9 +78,12 @@ bool ScreenWindow::isExposed() const
     return m_exposed;
 }
 
-void ScreenWindow::setExposed(const bool exposed)
+void ScreenWindow::setExposed(const bool exposed, const bool keepSceneGraph)
 {
-    qCDebug(QTMIR_SCREENS) << "ScreenWindow::setExposed" << this << exposed << screen();
+    qCDebug(QTMIR_SCREENS) << "ScreenWindow::setExposed" << this << exposed << keepSceneGraph << m_screen;
+    if (exposed) {
+        m_renderingSuspended = false;
+    }
     if (m_exposed == exposed)
         return;
 
@@ -80,7 +92,7 @@ void ScreenWindow::setExposed(const bool exposed)
         return;
 
     // If backing a QQuickWindow, need to stop/start its renderer immediately
-    auto quickWindow = static_cast<QQuickWindow *>(window());
+    auto quickWindow = qobject_cast<QQuickWindow *>(window());
     if (!quickWindow)
         return;
 
@@ -90,22 +102,56 @@ void ScreenWindow::setExposed(const bool exposed)
         QWindowSystemInterface::handleExposeEvent(window(), geometry()); // else it won't redraw
         QWindowSystemInterface::handleWindowActivated(window(), Qt::ActiveWindowFocusReason);
     } else {
-        quickWindow->setPersistentOpenGLContext(false);
-        quickWindow->setPersistentSceneGraph(false);
+        quickWindow->setPersistentOpenGLContext(keepSceneGraph);
+        quickWindow->setPersistentSceneGraph(keepSceneGraph);
         renderer->hide(quickWindow); // ExposeEvent will arrive too late, need to stop compositor immediately
     }
 }
 
+void ScreenWindow::suspendRendering()
+{
+    setExposed(false, true);
+    m_renderingSuspended = true;
+    if (window()) {
+        QWindowSystemInterface::handleExposeEvent(window(), QRegion());
+    }
+}
+
+void ScreenWindow::requestUpdate()
+{
+    if (m_renderingSuspended) {
+        // Nothing would be shown. Exposing the window again redraws it anyway, but Qt must be told
+        // this request is over, or it won't pass on any other.
+        ++m_suppressedUpdateRequests;
+        qt_window_private(window())->updateRequestPending = false;
+        return;
+    }
+
+    if (!m_screen->lateStartRendering()) {
+        QPlatformWindow::requestUpdate();
+        return;
+    }
+
+    // Deliver the update request, upon which Qt polishes, syncs and renders the scene, as late as
+    // possible while still making it for the next vsync.
+    const int delayMs = m_screen->scheduleRenderStart() / 1000000;
+    QWindow *w = window();
+    QTimer::singleShot(delayMs, Qt::PreciseTimer, w, [w]() {
+        qt_window_private(w)->deliverUpdateRequest();
+    });
+}
+
 void ScreenWindow::setScreen(QPlatformScreen *newScreen)
 {
     // Dis-associate the old screen
-    if (screen()) {
-        static_cast<Screen *>(screen())->setWindow(nullptr);
+    if (m_screen) {
+        m_screen->setWindow(nullptr);
     }
 
     // Associate new screen and announce to Qt
     auto myScreen = static_cast<Screen *>(newScreen);
     Q_ASSERT(myScreen);
+    m_screen = myScreen;
     myScreen->setWindow(this);
 
     QWindowSystemInterface::handleWindowScreenChanged(window(), myScreen->screen());
@@ -115,15 +161,15 @@ void ScreenWindow::setScreen(QPlatformScreen *newScreen)
 
 void ScreenWindow::swapBuffers()
 {
-    static_cast<Screen *>(screen())->swapBuffers();
+    m_screen->swapBuffers();
 }
 
 void ScreenWindow::makeCurrent()
 {
-    static_cast<Screen *>(screen())->makeCurrent();
+    m_screen->makeCurrent();
 }
 
 void ScreenWindow::doneCurrent()
 {
-    static_cast<Screen *>(screen())->doneCurrent();
+    m_screen->doneCurrent();
 }
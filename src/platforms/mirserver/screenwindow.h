@@ -19,6 +19,8 @@
 
 #include <qpa/qplatformwindow.h>
 
+class Screen;
+
 // ScreenWindow implements the basics of a QPlatformWindow.
 // QtMir enforces one Window per Screen, so Window and Screen are tightly coupled.
 // All Mir specifics live in the associated Screen object.
@@ -27,13 +29,27 @@ class ScreenWindow : public QPlatformWindow
 {
 public:
     explicit ScreenWindow(QWindow *window);
+    // To make it testable, as with other platforms the window's own screen isn't a Screen
+    ScreenWindow(QWindow *window, Screen *screen);
     virtual ~ScreenWindow();
 
     bool isExposed() const override;
-    void setExposed(const bool exposed);
+    // keepSceneGraph: when hiding, keep the GL context and scene graph around for when it gets exposed again
+    void setExposed(const bool exposed, const bool keepSceneGraph = false);
+
+    // Stops rendering to a display which is off, keeping the scene graph. Unlike a plain setExposed(false),
+    // Qt gets told about it, so that the surfaces shown in this window are known to be occluded.
+    // Update requests are dropped until the window gets exposed again.
+    void suspendRendering();
+    bool renderingSuspended() const { return m_renderingSuspended; }
+
+    // Update requests dropped while rendering was suspended, each a frame nobody would have seen
+    quint64 suppressedUpdateRequests() const { return m_suppressedUpdateRequests; }
 
     WId winId() const override { return m_winId; }
 
+    void requestUpdate() override;
+
     void setScreen(QPlatformScreen *screen);
 
     void swapBuffers();
@@ -42,7 +58,10 @@ public:
 
 private:
     bool m_exposed;
+    bool m_renderingSuspended;
+    quint64 m_suppressedUpdateRequests;
     WId m_winId;
+    Screen *m_screen;
 };
 
 #endif // SCREENWINDOW_H
@@ -48,7 +48,7 @@ public:
 
 Q_SIGNALS:
     void attributeChanged(const MirWindowAttrib attribute, const int value);
-    void framesPosted();
+    void framesPosted(const QSize &frameSize);
     void resized(const QSize &size);
     void nameChanged(const QString &name);
     void cursorChanged(const QCursor &cursor);
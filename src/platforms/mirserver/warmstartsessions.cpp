@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "warmstartsessions.h"
+
+#include <QMutexLocker>
+
+QSet<pid_t> WarmStartSessions::pids;
+QMutex WarmStartSessions::mutex;
+
+void WarmStartSessions::add(pid_t pid)
+{
+    QMutexLocker locker(&mutex);
+
+    pids.insert(pid);
+}
+
+void WarmStartSessions::remove(pid_t pid)
+{
+    QMutexLocker locker(&mutex);
+
+    pids.remove(pid);
+}
+
+bool WarmStartSessions::contains(pid_t pid)
+{
+    QMutexLocker locker(&mutex);
+
+    return pids.contains(pid);
+}
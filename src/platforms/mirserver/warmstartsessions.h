@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_WARMSTARTSESSIONS_H
+#define QTMIR_WARMSTARTSESSIONS_H
+
+#include <QMutex>
+#include <QSet>
+
+#include <sys/types.h>
+
+/*
+  Processes of applications pre-started by the shell and kept suspended until the user launches
+  them. Their windows are created hidden and not given focus.
+
+  Qt GUI thread fills it with data and mir/miral thread queries it
+ */
+class WarmStartSessions
+{
+public:
+    static void add(pid_t);
+    static void remove(pid_t);
+    static bool contains(pid_t);
+private:
+    static QSet<pid_t> pids;
+    static QMutex mutex;
+};
+
+#endif // QTMIR_WARMSTARTSESSIONS_H
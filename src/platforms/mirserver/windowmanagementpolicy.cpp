@@ -20,7 +20,9 @@
 #include "initialsurfacesizes.h"
 #include "screensmodel.h"
 #include "surfaceobserver.h"
+#include "warmstartsessions.h"
 
+#include "miral/application.h"
 #include "miral/window_manager_tools.h"
 #include "miral/window_specification.h"
 
@@ -35,15 +37,26 @@ namespace qtmir {
 
 using namespace qtmir;
 
+namespace {
+
+QString appNameOf(const miral::Application &application)
+{
+    return QString::fromStdString(miral::name_of(application));
+}
+
+} // namespace {
+
 WindowManagementPolicy::WindowManagementPolicy(const miral::WindowManagerTools &tools,
                                                qtmir::WindowModelNotifier &windowModel,
                                                qtmir::WindowController &windowController,
                                                qtmir::AppNotifier &appNotifier,
-                                               const QSharedPointer<ScreensModel> screensModel)
+                                               const QSharedPointer<ScreensModel> screensModel,
+                                               const QString &windowStatesPath)
     : CanonicalWindowManagerPolicy(tools)
     , m_windowModel(windowModel)
     , m_appNotifier(appNotifier)
     , m_eventFeeder(new QtEventFeeder(screensModel))
+    , m_windowStateStore(windowStatesPath.isEmpty() ? nullptr : new qtmir::WindowStateStore(windowStatesPath))
 {
     qRegisterMetaType<qtmir::NewWindow>();
     qRegisterMetaType<std::vector<miral::Window>>();
@@ -57,26 +70,53 @@ miral::WindowSpecification WindowManagementPolicy::place_new_window(
     const miral::WindowSpecification &requestParameters)
 {
     auto parameters = CanonicalWindowManagerPolicy::place_new_window(appInfo, requestParameters);
+    auto extraInfo = std::make_shared<ExtraWindowInfo>();
 
     if (!requestParameters.parent().is_set() || requestParameters.parent().value().lock().get() == nullptr) {
 
         int surfaceType = requestParameters.type().is_set() ? requestParameters.type().value() : -1;
 
+        if (surfaceType == mir_window_type_normal && m_windowStateStore) {
+            const std::string windowName = requestParameters.name().is_set() ? requestParameters.name().value() : std::string();
+            const WindowState savedState =
+                    m_windowStateStore->lookupForPlacement(appNameOf(appInfo.application()),
+                                                          QString::fromStdString(windowName));
+            if (savedState.isValid()) {
+                applySavedWindowState(savedState, parameters, *extraInfo);
+            }
+        }
+
+        // The shell has the final say on the size
         QSize initialSize = InitialSurfaceSizes::get(miral::pid_of(appInfo.application()));
 
         if (initialSize.isValid() && surfaceType == mir_surface_type_normal) {
             parameters.size() = toMirSize(initialSize);
         }
+
+        // Pre-started, the user hasn't launched it yet
+        if (WarmStartSessions::contains(miral::pid_of(appInfo.application()))) {
+            parameters.state() = mir_window_state_hidden;
+        }
     }
 
-    parameters.userdata() = std::make_shared<ExtraWindowInfo>();
+    parameters.userdata() = extraInfo;
 
     return parameters;
 }
 
 void WindowManagementPolicy::handle_window_ready(miral::WindowInfo &windowInfo)
 {
-    CanonicalWindowManagerPolicy::handle_window_ready(windowInfo);
+    // So that restoring it brings it back where the user last had it, not where it is maximized
+    auto extraWinInfo = getExtraInfo(windowInfo);
+    if (extraWinInfo->savedRestoreRect.isValid()) {
+        windowInfo.restore_rect(toMirRectangle(extraWinInfo->savedRestoreRect));
+        extraWinInfo->savedRestoreRect = QRect();
+    }
+
+    // Don't let a pre-started application take focus
+    if (!WarmStartSessions::contains(miral::pid_of(windowInfo.window().application()))) {
+        CanonicalWindowManagerPolicy::handle_window_ready(windowInfo);
+    }
 
     Q_EMIT m_windowModel.windowReady(windowInfo);
 
@@ -178,16 +218,26 @@ void WindowManagementPolicy::advise_state_change(const miral::WindowInfo &window
         extraWinInfo->state = toQtState(state);
     }
 
+    auto window = windowInfo.window();
+    saveWindowState(windowInfo, QRect(toQPoint(window.top_left()), toQSize(window.size())), extraWinInfo->state);
+
     Q_EMIT m_windowModel.windowStateChanged(windowInfo, extraWinInfo->state);
 }
 
 void WindowManagementPolicy::advise_move_to(const miral::WindowInfo &windowInfo, Point topLeft)
 {
+    // Called before the window is actually moved, so pass the new geometry along
+    saveWindowState(windowInfo, QRect(toQPoint(topLeft), toQSize(windowInfo.window().size())),
+                    getExtraInfo(windowInfo)->state);
+
     Q_EMIT m_windowModel.windowMoved(windowInfo, toQPoint(topLeft));
 }
 
 void WindowManagementPolicy::advise_resize(const miral::WindowInfo &windowInfo, const Size &newSize)
 {
+    saveWindowState(windowInfo, QRect(toQPoint(windowInfo.window().top_left()), toQSize(newSize)),
+                    getExtraInfo(windowInfo)->state);
+
     Q_EMIT m_windowModel.windowResized(windowInfo, toQSize(newSize));
 }
 
@@ -223,17 +273,66 @@ void WindowManagementPolicy::ensureWindowIsActive(const miral::Window &window)
     });
 }
 
+// If several confinement regions intersect rect, the one sharing the largest area with it is used.
 QRect WindowManagementPolicy::getConfinementRect(const QRect rect) const
 {
-    QRect confinementRect;
-    for (const QRect r : m_confinementRegions) {
-        if (r.intersects(rect)) {
-            confinementRect = r;
-            // TODO: What if there are multiple confinement regions and they intersect??
-            break;
+    return m_confinementRegions.regionFor(rect);
+}
+
+void WindowManagementPolicy::applySavedWindowState(const WindowState &savedState,
+                                                   miral::WindowSpecification &parameters,
+                                                   ExtraWindowInfo &extraInfo) const
+{
+    QRect geometry = savedState.geometry;
+
+    switch (savedState.state) {
+    case Mir::UnknownState:
+    case Mir::MinimizedState:
+    case Mir::HiddenState:
+        // a window reappearing minimized or hidden would look like it failed to start
+        break;
+    case Mir::RestoredState:
+        parameters.state() = toMirState(savedState.state);
+        break;
+    default:
+        parameters.state() = toMirState(savedState.state);
+        // Mir sizes the window for its state anyway. Place it at its restore rect instead, which is
+        // where it has to go back to once restored.
+        if (savedState.restoreRect.isValid()) {
+            geometry = savedState.restoreRect;
+            extraInfo.savedRestoreRect = savedState.restoreRect;
         }
     }
-    return confinementRect;
+
+    // Outputs may have changed since the state was saved, don't place the window somewhere unreachable
+    if (m_confinementRegions.isEmpty() || !getConfinementRect(geometry).isNull()) {
+        parameters.top_left() = toMirPoint(geometry.topLeft());
+    }
+    parameters.size() = toMirSize(geometry.size());
+}
+
+void WindowManagementPolicy::saveWindowState(const miral::WindowInfo &windowInfo, const QRect &geometry,
+                                             Mir::State state)
+{
+    // Only top-level application windows get restored, see place_new_window
+    if (!m_windowStateStore || windowInfo.type() != mir_window_type_normal || windowInfo.parent()) {
+        return;
+    }
+
+    auto extraWinInfo = getExtraInfo(windowInfo);
+    if (extraWinInfo->persistentId.isEmpty()) {
+        return;
+    }
+
+    WindowState windowState;
+    windowState.geometry = geometry;
+    windowState.state = state;
+    windowState.restoreRect = toQRect(windowInfo.restore_rect());
+
+    m_windowStateStore->save(extraWinInfo->persistentId,
+                             appNameOf(windowInfo.window().application()),
+                             QString::fromStdString(windowInfo.name()),
+                             windowState);
 }
 
 /* Following methods all called from the Qt GUI thread to deliver events to clients */
@@ -341,7 +440,11 @@ void WindowManagementPolicy::forceClose(const miral::Window &window)
 
 void WindowManagementPolicy::set_window_confinement_regions(const QVector<QRect> &regions)
 {
-    m_confinementRegions = regions;
+    // Build the index outside the lock, confirm_inherited_move queries it from the Mir thread
+    ConfinementRegionIndex index(regions);
+    tools.invoke_under_lock([&index, this]() {
+        m_confinementRegions = std::move(index);
+    });
 
     // TODO: update window positions to respect new boundary.
 }
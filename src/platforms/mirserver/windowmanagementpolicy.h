@@ -20,9 +20,11 @@
 #include "miral/canonical_window_manager.h"
 
 #include "appnotifier.h"
+#include "confinementregionindex.h"
 #include "qteventfeeder.h"
 #include "windowcontroller.h"
 #include "windowmodelnotifier.h"
+#include "windowstatestore.h"
 
 #include <QScopedPointer>
 
@@ -37,7 +39,8 @@ public:
                            qtmir::WindowModelNotifier &windowModel,
                            qtmir::WindowController &windowController,
                            qtmir::AppNotifier &appNotifier,
-                           const QSharedPointer<ScreensModel> screensModel);
+                           const QSharedPointer<ScreensModel> screensModel,
+                           const QString &windowStatesPath); // empty to not save window states
 
     // From WindowManagementPolicy
     auto place_new_window(const miral::ApplicationInfo &app_info,
@@ -92,12 +95,16 @@ public:
 private:
     void ensureWindowIsActive(const miral::Window &window);
     QRect getConfinementRect(const QRect rect) const;
+    void applySavedWindowState(const qtmir::WindowState &savedState, miral::WindowSpecification &parameters,
+                               qtmir::ExtraWindowInfo &extraInfo) const;
+    void saveWindowState(const miral::WindowInfo &windowInfo, const QRect &geometry, Mir::State state);
 
     qtmir::WindowModelNotifier &m_windowModel;
     qtmir::AppNotifier &m_appNotifier;
     const QScopedPointer<QtEventFeeder> m_eventFeeder;
-    QVector<QRect> m_confinementRegions;
+    qtmir::ConfinementRegionIndex m_confinementRegions;
     QMargins m_windowMargins[mir_window_types];
+    const QScopedPointer<qtmir::WindowStateStore> m_windowStateStore; // null if window states aren't saved
 };
 
 #endif // WINDOWMANAGEMENTPOLICY_H
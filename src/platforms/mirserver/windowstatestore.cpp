@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "windowstatestore.h"
+#include "logging.h"
+
+// Qt
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QThread>
+#include <QWaitCondition>
+
+// std
+#include <cstring>
+
+// system
+#include <sys/mman.h>
+
+using namespace qtmir;
+
+namespace {
+
+struct Header
+{
+    quint32 magic;
+    quint32 version;
+    quint32 capacity;
+    quint32 recordSize;
+};
+
+} // namespace {
+
+const quint32 WindowStateStore::magic = 0x51574D53; // "QWMS"
+const quint32 WindowStateStore::version = 2;
+const int WindowStateStore::capacity = 512;
+
+class WindowStateStore::Writer : public QThread
+{
+public:
+    Writer(WindowStateStore *store, int flushIntervalMs)
+        : m_store(store)
+        , m_flushIntervalMs(flushIntervalMs)
+    {}
+
+    // All following methods must be called with m_store->m_mutex held
+    void scheduleWrite() { m_wakeup.wakeOne(); }
+
+    void waitUntilWritten()
+    {
+        m_flushRequested = true;
+        m_wakeup.wakeOne();
+        while (!m_store->m_dirtySlots.isEmpty() || m_writing) {
+            m_written.wait(&m_store->m_mutex);
+        }
+        m_flushRequested = false;
+    }
+
+    void quit()
+    {
+        m_quit = true;
+        m_wakeup.wakeOne();
+    }
+
+protected:
+    void run() override
+    {
+        QMutexLocker locker(&m_store->m_mutex);
+
+        while (!m_quit) {
+            if (m_store->m_dirtySlots.isEmpty()) {
+                m_wakeup.wait(&m_store->m_mutex);
+                continue;
+            }
+
+            // Give further changes the chance to accumulate, a window being dragged around
+            // would otherwise cause a write per frame.
+            QElapsedTimer batchTimer;
+            batchTimer.start();
+            while (!m_quit && !m_flushRequested && batchTimer.elapsed() < m_flushIntervalMs) {
+                m_wakeup.wait(&m_store->m_mutex, m_flushIntervalMs - batchTimer.elapsed());
+            }
+
+            m_writing = true;
+            m_store->writeDirtyRecords();
+            m_writing = false;
+            m_written.wakeAll();
+        }
+
+        // write out anything left before the store goes away
+        m_store->writeDirtyRecords();
+        m_written.wakeAll();
+    }
+
+private:
+    WindowStateStore *const m_store;
+    const int m_flushIntervalMs;
+    QWaitCondition m_wakeup;
+    QWaitCondition m_written;
+    bool m_quit{false};
+    bool m_flushRequested{false};
+    bool m_writing{false};
+};
+
+WindowStateStore::WindowStateStore(const QString &filePath, int flushIntervalMs)
+    : m_file(filePath)
+    , m_records(capacity)
+{
+    std::memset(m_records.data(), 0, m_records.size() * sizeof(Record));
+
+    if (!openBackingFile()) {
+        qCWarning(QTMIR_SURFACES) << "WindowStateStore - unable to use" << filePath
+                                  << "window states will not be persisted";
+        return;
+    }
+
+    loadRecords();
+
+    m_writer.reset(new Writer(this, flushIntervalMs));
+    m_writer->start(QThread::LowPriority);
+}
+
+WindowStateStore::~WindowStateStore()
+{
+    if (m_writer) {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_writer->quit();
+        }
+        m_writer->wait();
+    }
+
+    if (m_mapping) {
+        ::msync(m_mapping, m_file.size(), MS_SYNC);
+        m_file.unmap(m_mapping);
+    }
+}
+
+QString WindowStateStore::defaultFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+            + QStringLiteral("/qtmir/windowstates");
+}
+
+QString WindowStateStore::placementKey(const QString &appName, const QString &windowName)
+{
+    return appName + QLatin1Char('/') + windowName;
+}
+
+bool WindowStateStore::openBackingFile()
+{
+    QFileInfo fileInfo(m_file);
+    if (!QDir().mkpath(fileInfo.absolutePath())) {
+        return false;
+    }
+
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+
+    const qint64 expectedSize = sizeof(Header) + capacity * sizeof(Record);
+
+    bool reset = (m_file.size() != expectedSize);
+    if (!reset) {
+        Header header;
+        reset = (m_file.read(reinterpret_cast<char*>(&header), sizeof(Header)) != sizeof(Header))
+                || header.magic != magic
+                || header.version != version
+                || header.capacity != static_cast<quint32>(capacity)
+                || header.recordSize != sizeof(Record);
+    }
+
+    if (reset) {
+        // Unknown, older or corrupt layout. Start afresh rather than trying to convert it.
+        if (!m_file.resize(0) || !m_file.resize(expectedSize)) {
+            m_file.close();
+            return false;
+        }
+    }
+
+    m_mapping = m_file.map(0, expectedSize);
+    if (!m_mapping) {
+        m_file.close();
+        return false;
+    }
+
+    if (reset) {
+        Header header{magic, version, static_cast<quint32>(capacity), sizeof(Record)};
+        std::memcpy(m_mapping, &header, sizeof(Header));
+    }
+
+    return true;
+}
+
+void WindowStateStore::loadRecords()
+{
+    QMutexLocker locker(&m_mutex);
+
+    std::memcpy(m_records.data(), m_mapping + sizeof(Header), capacity * sizeof(Record));
+
+    for (int slot = 0; slot < capacity; ++slot) {
+        const Record &record = m_records[slot];
+        if (record.idHash == 0) {
+            continue;
+        }
+
+        m_slotForId.insert(record.idHash, slot);
+
+        auto existing = m_slotForPlacement.constFind(record.placementHash);
+        if (existing == m_slotForPlacement.constEnd() || m_records[existing.value()].serial < record.serial) {
+            m_slotForPlacement.insert(record.placementHash, slot);
+        }
+
+        m_serial = qMax(m_serial, record.serial);
+    }
+}
+
+WindowState WindowStateStore::lookup(const QString &persistentId) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_slotForId.constFind(hash(persistentId));
+    if (it == m_slotForId.constEnd()) {
+        return WindowState();
+    }
+    return toWindowState(m_records[it.value()]);
+}
+
+WindowState WindowStateStore::lookupForPlacement(const QString &appName, const QString &windowName) const
+{
+    const quint64 placementHash = hash(placementKey(appName, windowName));
+
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_slotForPlacement.constFind(placementHash);
+    if (it == m_slotForPlacement.constEnd()) {
+        return WindowState();
+    }
+    return toWindowState(m_records[it.value()]);
+}
+
+void WindowStateStore::save(const QString &persistentId, const QString &appName, const QString &windowName,
+                            const WindowState &state)
+{
+    if (persistentId.isEmpty() || !state.isValid()) {
+        return;
+    }
+
+    const quint64 idHash = hash(persistentId);
+    const quint64 placementHash = hash(placementKey(appName, windowName));
+    const quint64 appHash = hash(appName);
+
+    QMutexLocker locker(&m_mutex);
+
+    int slot;
+    auto it = m_slotForId.constFind(idHash);
+    if (it != m_slotForId.constEnd()) {
+        slot = it.value();
+    } else {
+        slot = allocateSlot();
+        m_slotForId.insert(idHash, slot);
+    }
+
+    Record &record = m_records[slot];
+    record.idHash = idHash;
+    record.placementHash = placementHash;
+    record.appHash = appHash;
+    record.serial = ++m_serial;
+    record.x = state.geometry.x();
+    record.y = state.geometry.y();
+    record.width = state.geometry.width();
+    record.height = state.geometry.height();
+    record.state = state.state;
+    record.restoreX = state.restoreRect.x();
+    record.restoreY = state.restoreRect.y();
+    record.restoreWidth = state.restoreRect.width();
+    record.restoreHeight = state.restoreRect.height();
+
+    // most recently saved window wins the placement key
+    m_slotForPlacement.insert(placementHash, slot);
+
+    markDirty(slot);
+}
+
+void WindowStateStore::remove(const QString &persistentId)
+{
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_slotForId.constFind(hash(persistentId));
+    if (it != m_slotForId.constEnd()) {
+        removeSlot(it.value());
+    }
+}
+
+void WindowStateStore::removeApplication(const QString &appName)
+{
+    const quint64 appHash = hash(appName);
+
+    QMutexLocker locker(&m_mutex);
+
+    for (int slot = 0; slot < capacity; ++slot) {
+        if (m_records[slot].idHash != 0 && m_records[slot].appHash == appHash) {
+            removeSlot(slot);
+        }
+    }
+}
+
+void WindowStateStore::flush()
+{
+    if (!m_writer) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_writer->waitUntilWritten();
+}
+
+int WindowStateStore::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_slotForId.count();
+}
+
+// Must be called with m_mutex held
+int WindowStateStore::allocateSlot()
+{
+    // Use a free slot if any, otherwise evict the least recently saved entry
+    int victim = 0;
+    for (int slot = 0; slot < capacity; ++slot) {
+        const Record &record = m_records[slot];
+        if (record.idHash == 0) {
+            return slot;
+        }
+        if (record.serial < m_records[victim].serial) {
+            victim = slot;
+        }
+    }
+
+    Record &record = m_records[victim];
+    m_slotForId.remove(record.idHash);
+    auto placementIt = m_slotForPlacement.find(record.placementHash);
+    if (placementIt != m_slotForPlacement.end() && placementIt.value() == victim) {
+        m_slotForPlacement.erase(placementIt);
+    }
+    return victim;
+}
+
+// Must be called with m_mutex held
+void WindowStateStore::removeSlot(int slot)
+{
+    Record &record = m_records[slot];
+    m_slotForId.remove(record.idHash);
+
+    auto placementIt = m_slotForPlacement.find(record.placementHash);
+    if (placementIt != m_slotForPlacement.end() && placementIt.value() == slot) {
+        m_slotForPlacement.erase(placementIt);
+    }
+
+    std::memset(&record, 0, sizeof(Record));
+
+    markDirty(slot);
+}
+
+// Must be called with m_mutex held
+void WindowStateStore::markDirty(int slot)
+{
+    if (m_writer) {
+        const bool wasIdle = m_dirtySlots.isEmpty();
+        m_dirtySlots.insert(slot);
+        if (wasIdle) {
+            m_writer->scheduleWrite();
+        }
+    }
+}
+
+// Called by the Writer thread with m_mutex held. Releases it while touching the mapping.
+void WindowStateStore::writeDirtyRecords()
+{
+    if (m_dirtySlots.isEmpty()) {
+        return;
+    }
+
+    QVector<QPair<int, Record>> batch;
+    batch.reserve(m_dirtySlots.count());
+    for (int slot : m_dirtySlots) {
+        batch.append(qMakePair(slot, m_records[slot]));
+    }
+    m_dirtySlots.clear();
+
+    m_mutex.unlock();
+
+    uchar *const records = m_mapping + sizeof(Header);
+    for (const auto &entry : batch) {
+        std::memcpy(records + entry.first * sizeof(Record), &entry.second, sizeof(Record));
+    }
+    ::msync(m_mapping, m_file.size(), MS_ASYNC);
+
+    m_mutex.lock();
+}
+
+quint64 WindowStateStore::hash(const QString &key)
+{
+    // 64 bit FNV-1a. Stable across runs, unlike qHash which is seeded.
+    const QByteArray utf8 = key.toUtf8();
+    quint64 h = 14695981039346656037ULL;
+    for (const char c : utf8) {
+        h ^= static_cast<uchar>(c);
+        h *= 1099511628211ULL;
+    }
+    return h ? h : 1; // 0 marks a free slot
+}
+
+WindowState WindowStateStore::toWindowState(const Record &record)
+{
+    WindowState state;
+    state.geometry = QRect(record.x, record.y, record.width, record.height);
+    state.state = static_cast<Mir::State>(record.state);
+    state.restoreRect = QRect(record.restoreX, record.restoreY, record.restoreWidth, record.restoreHeight);
+    return state;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_WINDOWSTATESTORE_H
+#define QTMIR_WINDOWSTATESTORE_H
+
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QRect>
+#include <QScopedPointer>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+// Unity API
+#include <unity/shell/application/Mir.h>
+
+namespace qtmir {
+
+struct WindowState
+{
+    QRect geometry;
+    Mir::State state{Mir::UnknownState};
+    QRect restoreRect;
+
+    bool isValid() const { return geometry.isValid(); }
+};
+
+/*
+  Persists the last known geometry and state of windows across sessions, so that they can be placed
+  at their final position with a single configure when they are created again.
+
+  Entries are keyed by window persistent id. As the persistent id of a window is only known once Mir
+  has created it, entries are also indexed by application name + window name, which is what gets
+  queried when placing a new window. All entries of an application can be dropped at once, for when
+  it gets uninstalled.
+
+  The backing file is a fixed-size, versioned array of records which is memory mapped. Callers only
+  touch an in-memory copy; dirty records are copied into the mapping by a writer thread in batches.
+
+  Thread safety: all public methods may be called from any thread.
+ */
+class WindowStateStore
+{
+public:
+    explicit WindowStateStore(const QString &filePath = defaultFilePath(), int flushIntervalMs = 500);
+    ~WindowStateStore();
+
+    WindowState lookup(const QString &persistentId) const;
+    WindowState lookupForPlacement(const QString &appName, const QString &windowName) const;
+
+    void save(const QString &persistentId, const QString &appName, const QString &windowName,
+              const WindowState &state);
+    void remove(const QString &persistentId);
+    void removeApplication(const QString &appName);
+
+    // Blocks until all pending changes have been written to the backing file
+    void flush();
+
+    bool isPersistent() const { return m_mapping != nullptr; }
+    int count() const;
+
+    static QString defaultFilePath();
+
+    static const quint32 magic;
+    static const quint32 version;
+    static const int capacity;
+
+    struct Record
+    {
+        quint64 idHash;
+        quint64 placementHash;
+        quint64 appHash;
+        quint64 serial;
+        qint32 x, y, width, height;
+        qint32 state;
+        qint32 restoreX, restoreY, restoreWidth, restoreHeight;
+        qint32 reserved;
+    };
+
+private:
+    class Writer;
+
+    bool openBackingFile();
+    void loadRecords();
+    int allocateSlot();
+    void removeSlot(int slot);
+    void markDirty(int slot);
+    void writeDirtyRecords();
+
+    static quint64 hash(const QString &key);
+    static QString placementKey(const QString &appName, const QString &windowName);
+    static WindowState toWindowState(const Record &record);
+
+    QFile m_file;
+    uchar *m_mapping{nullptr};
+
+    mutable QMutex m_mutex;
+    QVector<Record> m_records;
+    QHash<quint64, int> m_slotForId;
+    QHash<quint64, int> m_slotForPlacement;
+    QSet<int> m_dirtySlots;
+    quint64 m_serial{0};
+
+    QScopedPointer<Writer> m_writer;
+    friend class Writer;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_WINDOWSTATESTORE_H
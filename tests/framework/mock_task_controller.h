@@ -32,6 +32,7 @@ struct MockTaskController : public qtmir::TaskController
     virtual ~MockTaskController();
 
     MOCK_METHOD2(appIdHasProcessId, bool(const QString&, pid_t));
+    MOCK_METHOD1(processIds, QVector<pid_t>(const QString&));
     MOCK_CONST_METHOD1(getInfoForApp, QSharedPointer<qtmir::ApplicationInfo> (const QString &));
 
     MOCK_METHOD1(stop, bool(const QString&));
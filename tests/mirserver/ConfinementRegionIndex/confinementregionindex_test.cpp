@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "confinementregionindex.h"
+
+using namespace qtmir;
+
+TEST(ConfinementRegionIndexTest, emptyIndexMatchesNothing)
+{
+    ConfinementRegionIndex index;
+
+    EXPECT_TRUE(index.isEmpty());
+    EXPECT_TRUE(index.regionFor(QRect(0, 0, 100, 100)).isNull());
+}
+
+TEST(ConfinementRegionIndexTest, findsTheIntersectingRegion)
+{
+    ConfinementRegionIndex index({QRect(0, 0, 1920, 1080), QRect(1920, 0, 1280, 1024)});
+
+    EXPECT_EQ(QRect(0, 0, 1920, 1080), index.regionFor(QRect(100, 100, 200, 200)));
+    EXPECT_EQ(QRect(1920, 0, 1280, 1024), index.regionFor(QRect(2000, 100, 200, 200)));
+    EXPECT_TRUE(index.regionFor(QRect(4000, 100, 200, 200)).isNull());
+}
+
+TEST(ConfinementRegionIndexTest, regionWithLargestOverlapWins)
+{
+    ConfinementRegionIndex index({QRect(0, 0, 1920, 1080), QRect(1920, 0, 1280, 1024)});
+
+    // mostly on the second output
+    EXPECT_EQ(QRect(1920, 0, 1280, 1024), index.regionFor(QRect(1900, 100, 400, 200)));
+    // mostly on the first output
+    EXPECT_EQ(QRect(0, 0, 1920, 1080), index.regionFor(QRect(1600, 100, 400, 200)));
+}
+
+TEST(ConfinementRegionIndexTest, firstListedRegionWinsTies)
+{
+    // nested regions, both fully containing the window
+    ConfinementRegionIndex index({QRect(100, 100, 500, 500), QRect(0, 0, 1000, 1000)});
+
+    EXPECT_EQ(QRect(100, 100, 500, 500), index.regionFor(QRect(200, 200, 50, 50)));
+}
+
+TEST(ConfinementRegionIndexTest, manyRegions)
+{
+    // tiled layout of 32x32 cells
+    QVector<QRect> regions;
+    for (int row = 0; row < 32; ++row) {
+        for (int column = 0; column < 32; ++column) {
+            regions.append(QRect(column * 100, row * 100, 100, 100));
+        }
+    }
+    ConfinementRegionIndex index(regions);
+
+    EXPECT_EQ(1024, index.count());
+    for (int i = 0; i < 32; ++i) {
+        EXPECT_EQ(QRect(i * 100, (31 - i) * 100, 100, 100), index.regionFor(QRect(i * 100 + 10, (31 - i) * 100 + 10, 20, 20)));
+    }
+}
+
+TEST(ConfinementRegionIndexTest, regionsStackedOverTheSameColumns)
+{
+    // outputs stacked vertically, all spanning the same columns
+    QVector<QRect> regions;
+    for (int row = 0; row < 64; ++row) {
+        regions.append(QRect(0, row * 100, 1000, 100));
+    }
+    ConfinementRegionIndex index(regions);
+
+    for (int row = 0; row < 64; ++row) {
+        EXPECT_EQ(QRect(0, row * 100, 1000, 100), index.regionFor(QRect(10, row * 100 + 10, 20, 20)));
+    }
+    EXPECT_TRUE(index.regionFor(QRect(10, 6500, 20, 20)).isNull());
+}
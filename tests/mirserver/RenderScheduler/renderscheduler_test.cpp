@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "renderscheduler.h"
+
+using namespace qtmir;
+
+namespace {
+const qint64 msecs = 1000000;
+const qint64 frameNs = 1000000000 / 60;
+}
+
+class RenderSchedulerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        scheduler.setRefreshRate(60);
+
+        // a first frame, rendered straight away
+        scheduler.frameStarted(0);
+        scheduler.renderFinished(4 * msecs);
+        scheduler.frameSwapped(frameNs);
+        now = frameNs;
+    }
+
+    // Renders a frame taking the given time, returns when it got flipped
+    qint64 renderFrame(qint64 renderNs)
+    {
+        now += scheduler.scheduleStart(now);
+        scheduler.frameStarted(now);
+        now += renderNs;
+        scheduler.renderFinished(now);
+        now = (now / frameNs + 1) * frameNs; // blocks until the next vsync
+        scheduler.frameSwapped(now);
+        return now;
+    }
+
+    RenderScheduler scheduler;
+    qint64 now;
+};
+
+TEST_F(RenderSchedulerTest, renderingStartsJustBeforeTheDeadline)
+{
+    const qint64 delay = scheduler.scheduleStart(now);
+    EXPECT_EQ(frameNs - 4 * msecs - scheduler.safetyMarginNs(), delay);
+
+    EXPECT_EQ(2 * frameNs, renderFrame(4 * msecs));
+
+    auto stats = scheduler.stats();
+    EXPECT_EQ(2u, stats.frames);
+    EXPECT_EQ(1u, stats.lateStarts);
+    EXPECT_EQ(0u, stats.missedDeadlines);
+    // the late started frame was shown 4ms of rendering plus the margin after being started
+    EXPECT_EQ(4 * msecs + scheduler.safetyMarginNs(), stats.totalLatencyNs - frameNs);
+}
+
+TEST_F(RenderSchedulerTest, missedDeadlineFallsBackToImmediateRendering)
+{
+    renderFrame(4 * msecs);
+    const qint64 margin = scheduler.safetyMarginNs();
+
+    // a frame much slower than the recent ones overshoots its vsync
+    renderFrame(12 * msecs);
+
+    EXPECT_EQ(1u, scheduler.stats().missedDeadlines);
+    EXPECT_EQ(2 * margin, scheduler.safetyMarginNs());
+    EXPECT_EQ(0, scheduler.scheduleStart(now));
+
+    // back to late starts once things settled down
+    for (int i = 0; i < RenderScheduler::backoffFrames; ++i) {
+        renderFrame(4 * msecs);
+    }
+    EXPECT_GT(scheduler.scheduleStart(now), 0);
+    EXPECT_EQ(1u, scheduler.stats().missedDeadlines);
+}
+
+TEST_F(RenderSchedulerTest, noLateStartWithoutRefreshRate)
+{
+    RenderScheduler unknownRate;
+    unknownRate.frameStarted(0);
+    unknownRate.renderFinished(4 * msecs);
+    unknownRate.frameSwapped(frameNs);
+
+    EXPECT_EQ(0, unknownRate.scheduleStart(frameNs));
+}
@@ -22,6 +22,8 @@
 
 #include <screen.h>
 
+#include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QSensorManager>
 
 using namespace ::testing;
@@ -103,3 +105,98 @@ TEST_F(ScreenTest, ReadDifferentConfigurationFromDisplayConfig)
     EXPECT_EQ(screen->physicalSize(), QSize(1000, 2000));
     EXPECT_EQ(screen->outputType(), qtmir::OutputTypes::LVDS);
 }
+
+TEST_F(ScreenTest, TimeSpentUnpoweredIsMeasured)
+{
+    const qint64 msecs = 1000000;
+    qint64 now = 0;
+    const auto defaultClock = Screen::clockNs;
+    Screen::clockNs = [&now]() { return now; };
+
+    Screen *screen = new Screen(fakeOutput2); // is internal display
+
+    bool poweredChangedEmitted = false;
+    QObject::connect(screen, &Screen::poweredChanged, [&]() { poweredChangedEmitted = true; });
+
+    ASSERT_TRUE(screen->isPowered());
+    now += 50 * msecs;
+    EXPECT_EQ(0, screen->unpoweredMs());
+
+    screen->onDisplayPowerStateChanged(0,0);
+    EXPECT_FALSE(screen->isPowered());
+    EXPECT_TRUE(poweredChangedEmitted);
+
+    now += 100 * msecs;
+    EXPECT_EQ(100, screen->unpoweredMs());
+
+    poweredChangedEmitted = false;
+    screen->onDisplayPowerStateChanged(1,0);
+    EXPECT_TRUE(screen->isPowered());
+    EXPECT_TRUE(poweredChangedEmitted);
+
+    // and nothing is counted while on
+    now += 50 * msecs;
+    EXPECT_EQ(100, screen->unpoweredMs());
+
+    Screen::clockNs = defaultClock;
+}
+
+TEST_F(ScreenTest, DisplayPowerStateIgnoredForExternalDisplay)
+{
+    Screen *screen = new Screen(fakeOutput1); // is external display (dvi)
+
+    screen->onDisplayPowerStateChanged(0,0);
+    EXPECT_TRUE(screen->isPowered());
+}
+
+TEST_F(ScreenTest, OrientationSensorOffWhileOrientationLocked)
+{
+    Screen *screen = new Screen(fakeOutput2); // is internal display
+    ASSERT_TRUE(screen->orientationSensorEnabled());
+
+    screen->setOrientationLocked(true);
+    EXPECT_FALSE(screen->orientationSensorEnabled());
+
+    screen->onDisplayPowerStateChanged(0,0);
+    screen->setOrientationLocked(false);
+    EXPECT_FALSE(screen->orientationSensorEnabled());
+
+    screen->onDisplayPowerStateChanged(1,0);
+    EXPECT_TRUE(screen->orientationSensorEnabled());
+}
+
+TEST_F(ScreenTest, OrientationReadingsAreDebounced)
+{
+    int argc = 0;
+    char **argv = nullptr;
+    QCoreApplication app(argc, argv); // for the stability timer
+
+    const int defaultStabilityMs = Screen::orientationStabilityMs;
+    Screen::orientationStabilityMs = 20;
+
+    Screen *screen = new Screen(fakeOutput2); // is internal display, in portrait
+    ASSERT_EQ(Qt::PortraitOrientation, screen->orientation());
+
+    // Device wobbling while being turned
+    screen->onOrientationReading(Qt::LandscapeOrientation);
+    screen->onOrientationReading(Qt::PortraitOrientation); // back to current, cancels the above
+    screen->onOrientationReading(Qt::InvertedLandscapeOrientation);
+    screen->onOrientationReading(Qt::LandscapeOrientation);
+    screen->onOrientationReading(Qt::PrimaryOrientation); // lying flat, cancels the above
+    screen->onOrientationReading(Qt::LandscapeOrientation);
+    screen->onOrientationReading(Qt::LandscapeOrientation);
+    EXPECT_EQ(Qt::PortraitOrientation, screen->orientation());
+
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 100) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+
+    EXPECT_EQ(Qt::LandscapeOrientation, screen->orientation());
+
+    // 6 readings of an actual orientation, a single change applied
+    EXPECT_EQ(5u, screen->orientationRelayoutsAvoided());
+
+    Screen::orientationStabilityMs = defaultStabilityMs;
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+#include "gmock_fixes.h"
+
+#include "mock_gl_display_buffer.h"
+#include "fake_displayconfigurationoutput.h"
+
+#include <mir/test/doubles/null_display_sync_group.h>
+
+#include "screen.h"
+#include "screenwindow.h"
+
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QLoggingCategory>
+#include <QWindow>
+
+using namespace ::testing;
+
+namespace mg = mir::graphics;
+
+namespace {
+const qint64 msecs = 1000000;
+
+class TestableScreen : public Screen
+{
+public:
+    using Screen::Screen;
+    using Screen::setMirDisplayBuffer;
+};
+
+class UpdateRequestCounter : public QObject
+{
+public:
+    bool eventFilter(QObject *, QEvent *event) override
+    {
+        if (event->type() == QEvent::UpdateRequest) {
+            ++count;
+        }
+        return false;
+    }
+
+    int count{0};
+};
+} // namespace
+
+class ScreenWindowTest : public ::testing::Test {
+protected:
+    void SetUp() override;
+    void TearDown() override;
+
+    // A screen backed by a display buffer, whose window is rendered to
+    void createScreen(const mg::DisplayConfigurationOutput &output);
+
+    // Qt renders a frame upon an update request, taking the given time
+    void renderFrame(qint64 renderNs);
+
+    // Processes events until an update request got delivered or the timeout expired
+    void waitForUpdateRequest(int timeoutMs);
+
+    qint64 now{0};
+    std::function<qint64()> defaultClock;
+
+    NiceMock<MockGLDisplayBuffer> displayBuffer;
+    mir::test::doubles::NullDisplaySyncGroup displayGroup;
+    TestableScreen *screen{nullptr};
+    QWindow *window{nullptr};
+    ScreenWindow *screenWindow{nullptr};
+    UpdateRequestCounter updateRequests;
+    QGuiApplication *app;
+};
+
+void ScreenWindowTest::SetUp()
+{
+    setenv("QT_QPA_PLATFORM", "minimal", 1);
+    Screen::skipDBusRegistration = true;
+
+    // We don't want the logging spam cluttering the test results
+    QLoggingCategory::setFilterRules(QStringLiteral("qtmir.*=false"));
+
+    defaultClock = Screen::clockNs;
+    Screen::clockNs = [this]() { return now; };
+
+    int argc = 0;
+    char **argv = nullptr;
+    app = new QGuiApplication(argc, argv);
+}
+
+void ScreenWindowTest::TearDown()
+{
+    delete screenWindow;
+    delete window;
+    delete screen;
+    delete app;
+
+    Screen::clockNs = defaultClock;
+    unsetenv("QTMIR_LATE_START_RENDERING");
+}
+
+void ScreenWindowTest::createScreen(const mg::DisplayConfigurationOutput &output)
+{
+    screen = new TestableScreen(output);
+    screen->setMirDisplayBuffer(&displayBuffer, &displayGroup);
+
+    window = new QWindow;
+    window->installEventFilter(&updateRequests);
+    screenWindow = new ScreenWindow(window, screen);
+}
+
+void ScreenWindowTest::renderFrame(qint64 renderNs)
+{
+    QEvent updateRequest(QEvent::UpdateRequest);
+    QCoreApplication::sendEvent(window, &updateRequest);
+    now += renderNs;
+    screenWindow->swapBuffers();
+}
+
+void ScreenWindowTest::waitForUpdateRequest(int timeoutMs)
+{
+    const int count = updateRequests.count;
+    QElapsedTimer timer;
+    timer.start();
+    while (updateRequests.count == count && timer.elapsed() < timeoutMs) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+    }
+}
+
+TEST_F(ScreenWindowTest, FramesAreTimedWithoutLateStartRendering)
+{
+    createScreen(fakeOutput1);
+    ASSERT_FALSE(screen->lateStartRendering());
+
+    renderFrame(4 * msecs);
+    renderFrame(6 * msecs);
+
+    auto stats = screen->renderStats();
+    EXPECT_EQ(2u, stats.frames);
+    EXPECT_EQ(10 * msecs, stats.totalLatencyNs);
+    EXPECT_EQ(6 * msecs, stats.maxLatencyNs);
+    EXPECT_EQ(0u, stats.lateStarts);
+}
+
+TEST_F(ScreenWindowTest, UpdateRequestIsDeferredWithLateStartRendering)
+{
+    setenv("QTMIR_LATE_START_RENDERING", "1", 1);
+
+    // A slow refresh rate leaves lots of time to start rendering late
+    mg::DisplayConfigurationOutput output = fakeOutput1;
+    output.modes[output.current_mode_index].vrefresh_hz = 10;
+    createScreen(output);
+    ASSERT_TRUE(screen->lateStartRendering());
+
+    // A first frame, flipped 4ms after it started
+    renderFrame(4 * msecs);
+
+    // The next vsync is 100ms after, the frame can start 4ms of rendering and a 10ms margin before
+    const qint64 expectedDelayMs = 100 - 4 - 10;
+
+    QElapsedTimer sinceRequest;
+    sinceRequest.start();
+    screenWindow->requestUpdate();
+    EXPECT_EQ(0, updateRequests.count);
+
+    // Qt itself would have delivered it after 5ms
+    waitForUpdateRequest(20);
+    EXPECT_EQ(0, updateRequests.count);
+
+    waitForUpdateRequest(1000);
+    ASSERT_EQ(1, updateRequests.count);
+    EXPECT_GE(sinceRequest.elapsed(), expectedDelayMs);
+    EXPECT_EQ(1u, screen->renderStats().lateStarts);
+}
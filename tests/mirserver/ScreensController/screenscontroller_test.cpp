@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <gtest/gtest.h>
+#include "gmock_fixes.h"
+
+#include "stub_display.h"
+#include "stub_displayconfigurationcontroller.h"
+#include "mock_gl_display_buffer.h"
+#include "qtcompositor.h"
+#include "fake_displayconfigurationoutput.h"
+
+#include "testable_screensmodel.h"
+#include "screen.h"
+#include "screenscontroller.h"
+
+#include <QGuiApplication>
+#include <QLoggingCategory>
+
+using namespace ::testing;
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+class ScreensControllerTest : public ::testing::Test {
+protected:
+    void SetUp() override;
+    void TearDown() override;
+
+    // Output state as last handed to Mir
+    mg::DisplayConfigurationOutput appliedOutput(mg::DisplayConfigurationOutputId id) const;
+
+    QSharedPointer<ScreensModel> screensModel;
+    std::shared_ptr<StubDisplay> display;
+    std::shared_ptr<StubDisplayConfigurationController> displayConfigurationController;
+    std::shared_ptr<QtCompositor> compositor;
+    ScreensController *screensController;
+    QGuiApplication *app;
+};
+
+void ScreensControllerTest::SetUp()
+{
+    setenv("QT_QPA_PLATFORM", "minimal", 1);
+    Screen::skipDBusRegistration = true;
+
+    // We don't want the logging spam cluttering the test results
+    QLoggingCategory::setFilterRules(QStringLiteral("qtmir.*=false"));
+
+    screensModel = QSharedPointer<ScreensModel>(new TestableScreensModel);
+    display = std::make_shared<StubDisplay>();
+    displayConfigurationController = std::make_shared<StubDisplayConfigurationController>();
+    compositor = std::make_shared<QtCompositor>();
+
+    static_cast<TestableScreensModel*>(screensModel.data())->do_init(
+        display, compositor, std::make_shared<StubDisplayListener>());
+
+    int argc = 0;
+    char **argv = nullptr;
+    app = new QGuiApplication(argc, argv);
+
+    std::vector<mg::DisplayConfigurationOutput> config{fakeOutput1, fakeOutput2};
+    std::vector<MockGLDisplayBuffer*> bufferConfig; // only used to match buffer with display, unecessary here
+    display->setFakeConfiguration(config, bufferConfig);
+    screensModel->update();
+
+    screensController = new ScreensController(screensModel, display, displayConfigurationController);
+}
+
+void ScreensControllerTest::TearDown()
+{
+    delete screensController;
+    screensModel.reset();
+    delete app;
+}
+
+mg::DisplayConfigurationOutput ScreensControllerTest::appliedOutput(mg::DisplayConfigurationOutputId id) const
+{
+    mg::DisplayConfigurationOutput result = fakeOutput1;
+    const mg::DisplayConfiguration &applied = *displayConfigurationController->baseConfiguration;
+    applied.for_each_output([&](const mg::DisplayConfigurationOutput &output) {
+        if (output.id == id) {
+            result = output;
+        }
+    });
+    return result;
+}
+
+TEST_F(ScreensControllerTest, TransactionIsCommittedAsOneConfiguration)
+{
+    const bool committed = screensController->beginTransaction()
+            .setScale(fakeOutput1.id, 2.0f)
+            .setTopLeft(fakeOutput2.id, QPoint(150, 0))
+            .setFormFactor(fakeOutput2.id, mir_form_factor_monitor)
+            .commit();
+
+    EXPECT_TRUE(committed);
+    ASSERT_EQ(1, displayConfigurationController->baseConfigurationCount);
+
+    EXPECT_FLOAT_EQ(2.0f, appliedOutput(fakeOutput1.id).scale);
+    EXPECT_EQ(geom::Point(0, 0), appliedOutput(fakeOutput1.id).top_left);
+    EXPECT_EQ(geom::Point(150, 0), appliedOutput(fakeOutput2.id).top_left);
+    EXPECT_EQ(mir_form_factor_monitor, appliedOutput(fakeOutput2.id).form_factor);
+    EXPECT_FLOAT_EQ(1.0f, appliedOutput(fakeOutput2.id).scale);
+}
+
+TEST_F(ScreensControllerTest, InvalidTransactionIsRolledBack)
+{
+    const bool committed = screensController->beginTransaction()
+            .setScale(fakeOutput1.id, 2.0f)
+            .setCurrentModeIndex(fakeOutput2.id, 42)
+            .commit();
+
+    EXPECT_FALSE(committed);
+    EXPECT_EQ(0, displayConfigurationController->baseConfigurationCount);
+}
+
+TEST_F(ScreensControllerTest, TransactionMatchingTheScreensIsNotApplied)
+{
+    auto transaction = screensController->beginTransaction();
+    EXPECT_TRUE(transaction.isEmpty());
+    EXPECT_TRUE(transaction.commit());
+
+    const bool committed = screensController->beginTransaction()
+            .setScale(fakeOutput1.id, 1.0f)
+            .setTopLeft(fakeOutput2.id, QPoint(500, 600))
+            .commit();
+
+    EXPECT_TRUE(committed);
+    EXPECT_EQ(0, displayConfigurationController->baseConfigurationCount);
+}
+
+TEST_F(ScreensControllerTest, TransactionUndoingOneInFlightIsApplied)
+{
+    EXPECT_TRUE(screensController->beginTransaction().setScale(fakeOutput1.id, 2.0f).commit());
+
+    // The compositor has not restarted, so the Screens still have the old scale
+    ASSERT_FLOAT_EQ(1.0f, screensModel->screens().at(0)->scale());
+    EXPECT_TRUE(screensController->beginTransaction().setScale(fakeOutput1.id, 1.0f).commit());
+
+    ASSERT_EQ(2, displayConfigurationController->baseConfigurationCount);
+    EXPECT_FLOAT_EQ(1.0f, appliedOutput(fakeOutput1.id).scale);
+}
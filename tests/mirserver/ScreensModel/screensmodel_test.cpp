@@ -31,6 +31,7 @@
 
 #include <QGuiApplication>
 #include <QLoggingCategory>
+#include <QWindow>
 
 using namespace ::testing;
 
@@ -39,6 +40,22 @@ namespace geom = mir::geometry;
 
 using StubDisplayBuffer = mir::test::doubles::StubDisplayBuffer;
 
+namespace {
+class UpdateRequestCounter : public QObject
+{
+public:
+    bool eventFilter(QObject *, QEvent *event) override
+    {
+        if (event->type() == QEvent::UpdateRequest) {
+            ++count;
+        }
+        return false;
+    }
+
+    int count{0};
+};
+} // namespace
+
 class ScreensModelTest : public ::testing::Test {
 protected:
     void SetUp() override;
@@ -187,3 +204,97 @@ TEST_F(ScreensModelTest, MultipleMatchBuffersWithDisplays)
     static_cast<StubScreen*>(screensModel->screens().at(0))->makeCurrent();
     static_cast<StubScreen*>(screensModel->screens().at(1))->makeCurrent();
 }
+
+TEST_F(ScreensModelTest, ConfigurationChangesAreClassified)
+{
+    std::vector<mg::DisplayConfigurationOutput> config{fakeOutput1, fakeOutput2};
+    std::vector<MockGLDisplayBuffer*> bufferConfig; // only used to match buffer with display, unecessary here
+    display->setFakeConfiguration(config, bufferConfig);
+
+    screensModel->update();
+
+    using Change = ScreensModel::ConfigurationChange;
+    EXPECT_EQ(Change::None, screensModel->classify(StubDisplayConfiguration(config)));
+
+    auto moved = config;
+    moved[1].top_left = geom::Point(150, 0);
+    moved[1].scale = 2.0f;
+    EXPECT_EQ(Change::Live, screensModel->classify(StubDisplayConfiguration(moved)));
+
+    auto switchedOff = config;
+    switchedOff[0].power_mode = mir_power_mode_off;
+    EXPECT_EQ(Change::Live, screensModel->classify(StubDisplayConfiguration(switchedOff)));
+
+    auto newMode = moved;
+    newMode[0].current_mode_index = 0;
+    EXPECT_EQ(Change::Structural, screensModel->classify(StubDisplayConfiguration(newMode)));
+
+    std::vector<mg::DisplayConfigurationOutput> unplugged{fakeOutput1};
+    EXPECT_EQ(Change::Structural, screensModel->classify(StubDisplayConfiguration(unplugged)));
+}
+
+TEST_F(ScreensModelTest, BlackoutIsMeasuredByKindOfChange)
+{
+    auto testableModel = static_cast<TestableScreensModel*>(screensModel);
+
+    std::vector<mg::DisplayConfigurationOutput> config{fakeOutput1};
+    std::vector<MockGLDisplayBuffer*> bufferConfig; // only used to match buffer with display, unecessary here
+    display->setFakeConfiguration(config, bufferConfig);
+
+    // unannounced, like a hotplug
+    testableModel->do_compositorStopping();
+    testableModel->do_compositorStarting();
+
+    config[0].scale = 2.0f;
+    screensModel->expectConfiguration(StubDisplayConfiguration(config));
+    display->setFakeConfiguration(config, bufferConfig);
+    testableModel->do_compositorStopping();
+    testableModel->do_compositorStarting();
+
+    using Change = ScreensModel::ConfigurationChange;
+    EXPECT_EQ(1, screensModel->blackoutStats(Change::Structural).count);
+    EXPECT_EQ(1, screensModel->blackoutStats(Change::Live).count);
+    EXPECT_EQ(0, screensModel->blackoutStats(Change::None).count);
+    EXPECT_FLOAT_EQ(2.0f, screensModel->screens().first()->scale());
+}
+
+TEST_F(ScreensModelTest, NoFramesWhileDisplayIsOff)
+{
+    auto testableModel = static_cast<TestableScreensModel*>(screensModel);
+
+    std::vector<mg::DisplayConfigurationOutput> config{fakeOutput2}; // is internal display
+    std::vector<MockGLDisplayBuffer*> bufferConfig; // only used to match buffer with display, unecessary here
+    display->setFakeConfiguration(config, bufferConfig);
+    screensModel->update();
+
+    ASSERT_EQ(1, screensModel->screens().count());
+    Screen *screen = screensModel->screens().first();
+
+    QWindow window;
+    UpdateRequestCounter updateRequests;
+    window.installEventFilter(&updateRequests);
+    ScreenWindow *screenWindow = new ScreenWindow(&window, screen);
+
+    testableModel->do_compositorStarting();
+    ASSERT_TRUE(screenWindow->isExposed());
+    ASSERT_FALSE(screenWindow->renderingSuspended());
+
+    screen->onDisplayPowerStateChanged(0,0);
+    EXPECT_TRUE(screenWindow->renderingSuspended());
+    EXPECT_FALSE(screenWindow->isExposed());
+
+    screenWindow->requestUpdate();
+    screenWindow->requestUpdate();
+    QCoreApplication::processEvents();
+    EXPECT_EQ(2u, screenWindow->suppressedUpdateRequests());
+    EXPECT_EQ(0, updateRequests.count);
+
+    screen->onDisplayPowerStateChanged(1,0);
+    EXPECT_FALSE(screenWindow->renderingSuspended());
+    EXPECT_TRUE(screenWindow->isExposed());
+
+    screenWindow->requestUpdate();
+    EXPECT_EQ(2u, screenWindow->suppressedUpdateRequests());
+
+    delete screenWindow;
+}
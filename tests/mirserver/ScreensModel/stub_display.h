@@ -45,8 +45,27 @@ public:
         }
     }
 
+    void for_each_output(std::function<void(mg::UserDisplayConfigurationOutput&)> f) override
+    {
+        for (auto &config : m_config) {
+            mg::UserDisplayConfigurationOutput userConfig(config);
+            f(userConfig);
+        }
+    }
+
+    // The part of Mir's checks which matters here: each output in use needs a valid mode
+    bool valid() const override
+    {
+        for (const auto &config : m_config) {
+            if (config.used && config.current_mode_index >= config.modes.size()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
 private:
-    const std::vector<mg::DisplayConfigurationOutput> m_config;
+    std::vector<mg::DisplayConfigurationOutput> m_config;
 };
 
 
@@ -21,10 +21,16 @@
 
 class StubDisplayConfigurationController : public mir::shell::DisplayConfigurationController
 {
+public:
     std::future<void> set_base_configuration(
-        std::shared_ptr<mir::graphics::DisplayConfiguration> const&) override {
+        std::shared_ptr<mir::graphics::DisplayConfiguration> const& conf) override {
+        ++baseConfigurationCount;
+        baseConfiguration = conf;
         return std::future<void>();
     }
+
+    int baseConfigurationCount{0};
+    std::shared_ptr<mir::graphics::DisplayConfiguration> baseConfiguration;
 };
 
 #endif // STUBDISPLAYCONFIGURATIONCONTROLLER_H
@@ -35,4 +35,7 @@ public:
     }
 
     void do_terminate() { terminate(); }
+
+    void do_compositorStopping() { onCompositorStopping(); }
+    void do_compositorStarting() { onCompositorStarting(); }
 };
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "windowstatestore.h"
+
+using namespace qtmir;
+
+class WindowStateStoreTest : public ::testing::Test
+{
+protected:
+    QString storePath() const { return tempDir.path() + QStringLiteral("/windowstates"); }
+
+    static WindowState makeState(const QRect &geometry, Mir::State state = Mir::RestoredState)
+    {
+        WindowState windowState;
+        windowState.geometry = geometry;
+        windowState.state = state;
+        windowState.restoreRect = geometry;
+        return windowState;
+    }
+
+    QTemporaryDir tempDir;
+};
+
+TEST_F(WindowStateStoreTest, savedStateIsFoundByPersistentIdAndPlacementKey)
+{
+    WindowStateStore store(storePath());
+    ASSERT_TRUE(store.isPersistent());
+
+    store.save(QStringLiteral("id-1"), QStringLiteral("gedit"), QStringLiteral("main"),
+               makeState(QRect(10, 20, 300, 400), Mir::MaximizedState));
+
+    WindowState byId = store.lookup(QStringLiteral("id-1"));
+    EXPECT_EQ(QRect(10, 20, 300, 400), byId.geometry);
+    EXPECT_EQ(Mir::MaximizedState, byId.state);
+
+    WindowState byPlacement = store.lookupForPlacement(QStringLiteral("gedit"), QStringLiteral("main"));
+    EXPECT_EQ(QRect(10, 20, 300, 400), byPlacement.geometry);
+
+    EXPECT_FALSE(store.lookup(QStringLiteral("id-2")).isValid());
+}
+
+TEST_F(WindowStateStoreTest, mostRecentlySavedWindowWinsPlacementKey)
+{
+    WindowStateStore store(storePath());
+
+    store.save(QStringLiteral("id-1"), QStringLiteral("terminal"), QString(), makeState(QRect(0, 0, 100, 100)));
+    store.save(QStringLiteral("id-2"), QStringLiteral("terminal"), QString(), makeState(QRect(50, 50, 200, 200)));
+
+    EXPECT_EQ(QRect(50, 50, 200, 200), store.lookupForPlacement(QStringLiteral("terminal"), QString()).geometry);
+
+    store.save(QStringLiteral("id-1"), QStringLiteral("terminal"), QString(), makeState(QRect(5, 5, 100, 100)));
+
+    EXPECT_EQ(QRect(5, 5, 100, 100), store.lookupForPlacement(QStringLiteral("terminal"), QString()).geometry);
+}
+
+TEST_F(WindowStateStoreTest, stateSurvivesReopening)
+{
+    {
+        WindowStateStore store(storePath());
+        store.save(QStringLiteral("id-1"), QStringLiteral("gedit"), QStringLiteral("main"), makeState(QRect(10, 20, 300, 400)));
+        store.flush();
+    }
+
+    WindowStateStore store(storePath());
+    EXPECT_EQ(1, store.count());
+    EXPECT_EQ(QRect(10, 20, 300, 400), store.lookupForPlacement(QStringLiteral("gedit"), QStringLiteral("main")).geometry);
+}
+
+TEST_F(WindowStateStoreTest, pendingChangesAreWrittenOnDestruction)
+{
+    {
+        // long flush interval, so nothing gets written before the store goes away
+        WindowStateStore store(storePath(), 60000);
+        store.save(QStringLiteral("id-1"), QStringLiteral("gedit"), QStringLiteral("main"), makeState(QRect(1, 2, 3, 4)));
+    }
+
+    WindowStateStore store(storePath());
+    EXPECT_EQ(QRect(1, 2, 3, 4), store.lookup(QStringLiteral("id-1")).geometry);
+}
+
+TEST_F(WindowStateStoreTest, removedStateIsForgotten)
+{
+    {
+        WindowStateStore store(storePath());
+        store.save(QStringLiteral("id-1"), QStringLiteral("gedit"), QStringLiteral("main"), makeState(QRect(1, 2, 3, 4)));
+        store.remove(QStringLiteral("id-1"));
+        EXPECT_FALSE(store.lookup(QStringLiteral("id-1")).isValid());
+        EXPECT_FALSE(store.lookupForPlacement(QStringLiteral("gedit"), QStringLiteral("main")).isValid());
+    }
+
+    WindowStateStore store(storePath());
+    EXPECT_EQ(0, store.count());
+}
+
+TEST_F(WindowStateStoreTest, incompatibleFileIsDiscarded)
+{
+    {
+        QFile file(storePath());
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write("not a window state store");
+    }
+
+    WindowStateStore store(storePath());
+    EXPECT_TRUE(store.isPersistent());
+    EXPECT_EQ(0, store.count());
+}
+
+TEST_F(WindowStateStoreTest, leastRecentlySavedStateIsEvictedWhenFull)
+{
+    WindowStateStore store(storePath());
+
+    for (int i = 0; i <= WindowStateStore::capacity; ++i) {
+        store.save(QString::number(i), QStringLiteral("app"), QString::number(i), makeState(QRect(i, i, 10, 10)));
+    }
+
+    EXPECT_EQ(WindowStateStore::capacity, store.count());
+    EXPECT_FALSE(store.lookup(QStringLiteral("0")).isValid());
+    EXPECT_TRUE(store.lookup(QString::number(WindowStateStore::capacity)).isValid());
+}
+
+TEST_F(WindowStateStoreTest, removingApplicationForgetsAllOfItsWindows)
+{
+    {
+        WindowStateStore store(storePath());
+        store.save(QStringLiteral("id-1"), QStringLiteral("gedit"), QStringLiteral("main"), makeState(QRect(1, 2, 3, 4)));
+        store.save(QStringLiteral("id-2"), QStringLiteral("gedit"), QStringLiteral("prefs"), makeState(QRect(5, 6, 7, 8)));
+        store.save(QStringLiteral("id-3"), QStringLiteral("terminal"), QString(), makeState(QRect(9, 9, 9, 9)));
+
+        store.removeApplication(QStringLiteral("gedit"));
+
+        EXPECT_FALSE(store.lookup(QStringLiteral("id-1")).isValid());
+        EXPECT_FALSE(store.lookupForPlacement(QStringLiteral("gedit"), QStringLiteral("prefs")).isValid());
+        EXPECT_TRUE(store.lookup(QStringLiteral("id-3")).isValid());
+    }
+
+    WindowStateStore store(storePath());
+    EXPECT_EQ(1, store.count());
+}
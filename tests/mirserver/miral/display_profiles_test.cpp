@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "display_profiles.h"
+#include "persist_display_config.h"
+
+#include <mir/graphics/display_configuration.h>
+namespace mg = mir::graphics; // Bug lp:1614983
+#include <mir/test/doubles/mock_display_configuration.h>
+
+using namespace miral;
+
+namespace
+{
+struct DisplayProfilesTest : ::testing::Test
+{
+    DisplayProfilesTest()
+    {
+        char directory_template[] = "/tmp/display_profiles_test-XXXXXX";
+        directory = mkdtemp(directory_template);
+        path = directory + "/qtmir/display-profiles";
+    }
+
+    ~DisplayProfilesTest()
+    {
+        std::remove(path.c_str());
+        std::remove((directory + "/qtmir").c_str());
+        std::remove(directory.c_str());
+    }
+
+    static DisplayProfiles::Output output(uint64_t identity, int x, int width, int height)
+    {
+        DisplayProfiles::Output output;
+        output.identity = identity;
+        output.used = true;
+        output.top_left_x = x;
+        output.mode_width = width;
+        output.mode_height = height;
+        output.mode_refresh_hz = 60;
+        output.scale = 1.5f;
+        return output;
+    }
+
+    std::string directory;
+    std::string path;
+};
+
+// A single monitor, which the display rejects whenever it would be left with no output in use
+struct StubDisplayConfiguration : mir::test::doubles::MockDisplayConfiguration
+{
+    StubDisplayConfiguration()
+    {
+        output.id = mg::DisplayConfigurationOutputId{1};
+        output.type = mg::DisplayConfigurationOutputType::hdmia;
+        output.modes = {mg::DisplayConfigurationMode{{1920, 1080}, 60.0}};
+        output.connected = true;
+        output.used = true;
+        output.current_mode_index = 0;
+        output.orientation = mir_orientation_normal;
+        output.scale = 1.0f;
+        output.form_factor = mir_form_factor_monitor;
+    }
+
+    void for_each_output(std::function<void(mg::DisplayConfigurationOutput const&)> f) const override
+    {
+        f(output);
+    }
+
+    void for_each_output(std::function<void(mg::UserDisplayConfigurationOutput&)> f) override
+    {
+        mg::UserDisplayConfigurationOutput user_output{output};
+        f(user_output);
+    }
+
+    bool valid() const override
+    {
+        return output.used;
+    }
+
+    auto identity() const -> uint64_t
+    {
+        return DisplayProfiles::identity_of(output.edid, static_cast<int>(output.type), output.id.as_value());
+    }
+
+    mg::DisplayConfigurationOutput output;
+};
+}
+
+TEST_F(DisplayProfilesTest, profile_key_does_not_depend_on_output_order)
+{
+    EXPECT_EQ(DisplayProfiles::key_of({1, 2, 3}), DisplayProfiles::key_of({3, 1, 2}));
+    EXPECT_NE(DisplayProfiles::key_of({1, 2}), DisplayProfiles::key_of({1, 2, 3}));
+}
+
+TEST_F(DisplayProfilesTest, outputs_without_edid_are_identified_by_connector)
+{
+    std::vector<uint8_t> const garbage(128, 0x42);
+
+    EXPECT_EQ(DisplayProfiles::identity_of({}, 1, 2), DisplayProfiles::identity_of(garbage, 1, 2));
+    EXPECT_NE(DisplayProfiles::identity_of({}, 1, 2), DisplayProfiles::identity_of({}, 1, 3));
+}
+
+TEST_F(DisplayProfilesTest, saved_profile_survives_reopening)
+{
+    auto const key = DisplayProfiles::key_of({7, 8});
+    DisplayProfiles::Profile const profile{output(7, 0, 1920, 1080), output(8, 1920, 2560, 1440)};
+
+    {
+        DisplayProfiles profiles{path};
+        profiles.save(key, profile);
+    }
+
+    DisplayProfiles profiles{path};
+    DisplayProfiles::Profile loaded;
+    ASSERT_TRUE(profiles.lookup(key, loaded));
+    EXPECT_EQ(profile, loaded);
+    EXPECT_FALSE(profiles.lookup(DisplayProfiles::key_of({7}), loaded));
+}
+
+TEST_F(DisplayProfilesTest, saving_an_unchanged_profile_does_not_write)
+{
+    DisplayProfiles profiles{path};
+    auto const key = DisplayProfiles::key_of({7});
+
+    profiles.save(key, {output(7, 0, 1920, 1080)});
+    profiles.save(key, {output(7, 0, 1920, 1080)});
+    EXPECT_EQ(1u, profiles.file_writes());
+
+    profiles.save(key, {output(7, 0, 1280, 720)});
+    EXPECT_EQ(2u, profiles.file_writes());
+}
+
+TEST_F(DisplayProfilesTest, least_recently_saved_profile_is_dropped_when_full)
+{
+    DisplayProfiles profiles{path};
+
+    for (uint64_t i = 0; i <= DisplayProfiles::capacity; ++i)
+        profiles.save(DisplayProfiles::key_of({i}), {output(i, 0, 800, 600)});
+
+    DisplayProfiles::Profile loaded;
+    EXPECT_EQ(DisplayProfiles::capacity, profiles.size());
+    EXPECT_FALSE(profiles.lookup(DisplayProfiles::key_of({0}), loaded));
+    EXPECT_TRUE(profiles.lookup(DisplayProfiles::key_of({DisplayProfiles::capacity}), loaded));
+}
+
+TEST_F(DisplayProfilesTest, unknown_file_is_ignored)
+{
+    {
+        DisplayProfiles profiles{path}; // creates the directory
+        profiles.save(DisplayProfiles::key_of({1}), {output(1, 0, 800, 600)});
+    }
+    {
+        std::ofstream out{path, std::ios::trunc};
+        out << "not a display profile file";
+    }
+
+    DisplayProfiles profiles{path};
+    EXPECT_EQ(0u, profiles.size());
+}
+
+TEST_F(DisplayProfilesTest, saved_profile_is_laid_over_the_configuration)
+{
+    StubDisplayConfiguration conf;
+    DisplayProfiles profiles{path};
+    profiles.save(DisplayProfiles::key_of({conf.identity()}), {output(conf.identity(), 100, 1920, 1080)});
+
+    EXPECT_TRUE(apply_display_profile(profiles, conf));
+    EXPECT_EQ(100, conf.output.top_left.x.as_int());
+    EXPECT_EQ(1.5f, conf.output.scale);
+}
+
+TEST_F(DisplayProfilesTest, saved_profile_making_the_configuration_invalid_is_undone)
+{
+    StubDisplayConfiguration conf;
+    DisplayProfiles profiles{path};
+    auto unused = output(conf.identity(), 100, 1920, 1080);
+    unused.used = false;
+    unused.orientation = mir_orientation_left;
+    unused.form_factor = mir_form_factor_projector;
+    profiles.save(DisplayProfiles::key_of({conf.identity()}), {unused});
+
+    EXPECT_FALSE(apply_display_profile(profiles, conf));
+    EXPECT_TRUE(conf.valid());
+    EXPECT_EQ(0, conf.output.top_left.x.as_int());
+    EXPECT_EQ(0u, conf.output.current_mode_index);
+    EXPECT_EQ(mir_orientation_normal, conf.output.orientation);
+    EXPECT_EQ(1.0f, conf.output.scale);
+    EXPECT_EQ(mir_form_factor_monitor, conf.output.form_factor);
+}
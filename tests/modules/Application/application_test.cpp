@@ -23,13 +23,19 @@
 #include <fake_application_info.h>
 #include <fake_session.h>
 #include <mock_application_info.h>
+#include <mock_proc_info.h>
 #include <mock_session.h>
 
+#include <Unity/Application/memoryreclaimer.h>
+#include <Unity/Application/prioritypolicy.h>
+#include <Unity/Application/resourcesampler.h>
 #include <Unity/Application/session.h>
 #include <Unity/Application/timesource.h>
 
+#include <QDir>
 #include <QScopedPointer>
 #include <QSignalSpy>
+#include <QTemporaryDir>
 
 using namespace qtmir;
 
@@ -93,6 +99,20 @@ public:
         return session;
     }
 
+    inline Application *createSuspendedApplicationWithFakes()
+    {
+        Application *application = createApplicationWithFakes();
+        application->setProcessState(Application::ProcessRunning);
+        FakeSession *session = new FakeSession;
+        application->addSession(session);
+        session->setState(SessionInterface::Running);
+
+        application->setRequestedState(Application::RequestedSuspended);
+        session->setState(SessionInterface::Suspended);
+        application->setProcessState(Application::ProcessSuspended);
+        return application;
+    }
+
     inline void passTimeUntilTimerTimesOut(AbstractTimer *timer)
     {
         FakeTimer *fakeTimer = dynamic_cast<FakeTimer*>(timer);
@@ -653,3 +673,238 @@ TEST_F(ApplicationTests, dontRespawnIfClosedWhileStillStartingUp)
     EXPECT_EQ(Application::InternalState::Stopped, application->internalState());
     EXPECT_EQ(0, spyStartProcess.count());
 }
+
+TEST_F(ApplicationTests, memoryReclaimerStopsLeastRecentlyUsedSuspendedApplications)
+{
+    using namespace ::testing;
+
+    auto procInfo = QSharedPointer<NiceMock<MockProcInfo>>::create();
+    ON_CALL(*procInfo, memoryUsage(_)).WillByDefault(Return(ProcInfo::MemoryUsage{4096, 2048}));
+    MemoryReclaimer reclaimer(procInfo, fakeTimeSource);
+    QSignalSpy reclaimRequestedSpy(&reclaimer, &MemoryReclaimer::reclaimRequested);
+
+    QScopedPointer<Application> running(createApplicationWithFakes());
+    running->setProcessState(Application::ProcessRunning);
+    FakeSession *runningSession = new FakeSession;
+    running->addSession(runningSession);
+    runningSession->setState(SessionInterface::Running);
+    reclaimer.addApplication(running.data());
+
+    QScopedPointer<Application> exempt(createApplicationWithFakes());
+    exempt->setExemptFromLifecycle(true);
+    reclaimer.addApplication(exempt.data());
+
+    fakeTimeSource->m_msecsSinceReference += 100;
+    QScopedPointer<Application> older(createSuspendedApplicationWithFakes());
+    ASSERT_EQ(Application::InternalState::Suspended, older->internalState());
+    reclaimer.addApplication(older.data());
+
+    fakeTimeSource->m_msecsSinceReference += 100;
+    QScopedPointer<Application> newer(createSuspendedApplicationWithFakes());
+    reclaimer.addApplication(newer.data());
+
+    EXPECT_EQ(older.data(), reclaimer.reclaim());
+    ASSERT_EQ(1, reclaimRequestedSpy.count());
+    EXPECT_EQ(2048, reclaimer.stats().reclaimedBytes);
+
+    reclaimer.removeApplication(older.data());
+    EXPECT_EQ(newer.data(), reclaimer.reclaim());
+
+    reclaimer.removeApplication(newer.data());
+    EXPECT_TRUE(reclaimer.reclaim() == nullptr);
+
+    EXPECT_EQ(2u, reclaimer.stats().reclaimDecisions);
+    EXPECT_EQ(1u, reclaimer.stats().noCandidate);
+}
+
+TEST_F(ApplicationTests, measuresLaunchSuspendAndResumeLatencies)
+{
+    using namespace ::testing;
+
+    QScopedPointer<Application> application(createApplicationWithFakes());
+    application->setTimeSource(fakeTimeSource);
+    QSignalSpy latenciesChangedSpy(application.data(), &Application::lifecycleLatenciesChanged);
+
+    const qint64 launchTime = fakeTimeSource->m_msecsSinceReference;
+    application->setProcessState(Application::ProcessRunning);
+    Session *session = createSessionWithFakes();
+    application->addSession(session);
+
+    FakeMirSurface *surface = new FakeMirSurface;
+    session->registerSurface(surface);
+
+    fakeTimeSource->m_msecsSinceReference += 700;
+    surface->setReady();
+
+    ASSERT_EQ(Application::InternalState::Running, application->internalState());
+    ASSERT_EQ(1, latenciesChangedSpy.count());
+    EXPECT_EQ(700, application->lifecycleLatencies()["launchToFirstFrame"].toLongLong());
+    EXPECT_EQ(launchTime + 700, application->firstFrameTimestamp());
+
+    const qint64 suspendTime = fakeTimeSource->m_msecsSinceReference;
+    application->setRequestedState(Application::RequestedSuspended);
+    ASSERT_EQ(Application::InternalState::SuspendingWaitSession, application->internalState());
+    passTimeUntilTimerTimesOut(session->suspendTimer());
+    ASSERT_EQ(Application::InternalState::SuspendingWaitProcess, application->internalState());
+
+    fakeTimeSource->m_msecsSinceReference += 30;
+    application->setProcessState(Application::ProcessSuspended);
+
+    // includes the wait for the session, not only for the process
+    ASSERT_EQ(2, latenciesChangedSpy.count());
+    EXPECT_EQ(fakeTimeSource->m_msecsSinceReference - suspendTime,
+              application->lifecycleLatencies()["suspendAcknowledgment"].toLongLong());
+    EXPECT_LT(30, application->lifecycleLatencies()["suspendAcknowledgment"].toLongLong());
+
+    fakeTimeSource->m_msecsSinceReference += 5000;
+    const qint64 resumeTime = fakeTimeSource->m_msecsSinceReference;
+    application->setRequestedState(Application::RequestedRunning);
+    EXPECT_EQ(resumeTime, application->stateTimestamp(Application::InternalState::Running));
+
+    fakeTimeSource->m_msecsSinceReference += 120;
+    Q_EMIT surface->framesPosted();
+    Q_EMIT surface->framesPosted(); // only the first frame after resuming counts
+
+    ASSERT_EQ(3, latenciesChangedSpy.count());
+    EXPECT_EQ(120, application->lifecycleLatencies()["resumeToFirstFrame"].toLongLong());
+
+    delete surface;
+}
+
+TEST_F(ApplicationTests, resourceUsageIsSampledForAllProcessesAndSurfaces)
+{
+    using namespace ::testing;
+
+    int argc = 0;
+    char* argv[0];
+    QCoreApplication qtApp(argc, argv); // event loop for the sampler thread to report back
+
+    QScopedPointer<Application> application(createApplicationWithFakes());
+    application->setProcessState(Application::ProcessRunning);
+    Session *session = createSessionWithFakes();
+    application->addSession(session);
+
+    FakeMirSurface *surface = new FakeMirSurface;
+    surface->resize(100, 50);
+    session->registerSurface(surface);
+    surface->setReady();
+
+    ProcInfo::MemoryUsage memoryUsage;
+    memoryUsage.rssBytes = 20 * 1024 * 1024;
+    memoryUsage.pssBytes = 12 * 1024 * 1024;
+    EXPECT_CALL(procInfo, memoryUsage(1234)).WillRepeatedly(Return(memoryUsage));
+    EXPECT_CALL(procInfo, cpuTimeMs(1234)).WillRepeatedly(Return(100));
+
+    ResourceSampler sampler(QSharedPointer<ProcInfo>(&procInfo, [](ProcInfo *){}));
+    sampler.addApplication(application.data());
+    QSignalSpy usageChangedSpy(&sampler, &ResourceSampler::usageChanged);
+
+    sampler.sample();
+    ASSERT_TRUE(usageChangedSpy.wait());
+    EXPECT_EQ(QStringList{application->appId()}, usageChangedSpy.takeFirst().at(0).toStringList());
+
+    ResourceUsage usage = sampler.usage(application->appId());
+    EXPECT_EQ(memoryUsage.rssBytes, usage.rssBytes);
+    EXPECT_EQ(memoryUsage.pssBytes, usage.pssBytes);
+    EXPECT_EQ(-1, usage.cgroupMemoryBytes);
+    EXPECT_EQ(100 * 50 * 4 * ResourceSampler::buffersPerSurface, usage.bufferBytes);
+
+    // Nothing changed significantly, so the GUI doesn't hear about it
+    sampler.sample();
+    EXPECT_FALSE(usageChangedSpy.wait(100));
+
+    delete surface;
+}
+
+TEST_F(ApplicationTests, priorityFollowsLifecycleAndBoostsResumingFocusedApp)
+{
+    using namespace ::testing;
+
+    int argc = 0;
+    char* argv[0];
+    QCoreApplication qtApp(argc, argv); // for the queued flush
+
+    QScopedPointer<Application> application(createApplicationWithFakes());
+    application->setProcessState(Application::ProcessRunning);
+    Session *session = createSessionWithFakes();
+    application->addSession(session);
+
+    FakeMirSurface *surface = new FakeMirSurface;
+    session->registerSurface(surface);
+    surface->setReady();
+    ASSERT_EQ(Application::InternalState::Running, application->internalState());
+
+    PriorityPolicy policy(QStringLiteral("/proc"));
+    policy.setMode(PriorityPolicy::DryRun);
+    policy.addApplication(application.data());
+    policy.waitForWrites();
+
+    QList<PriorityPolicy::Write> writes = policy.dryRunWrites();
+    ASSERT_EQ(1, writes.count());
+    EXPECT_EQ(QStringLiteral("/proc/1234/oom_score_adj"), writes.last().path);
+    EXPECT_EQ(QByteArray::number(PriorityPolicy::priorityOf(PriorityPolicy::Visible, false).oomScoreAdj),
+              writes.last().value);
+
+    // Intermediate states of the same batch don't get written
+    application->setRequestedState(Application::RequestedSuspended);
+    passTimeUntilTimerTimesOut(session->suspendTimer());
+    application->setProcessState(Application::ProcessSuspended);
+    ASSERT_EQ(Application::InternalState::Suspended, application->internalState());
+    policy.waitForWrites();
+
+    writes = policy.dryRunWrites();
+    ASSERT_EQ(2, writes.count());
+    EXPECT_EQ(QByteArray::number(PriorityPolicy::priorityOf(PriorityPolicy::Suspended, false).oomScoreAdj),
+              writes.last().value);
+    EXPECT_EQ(2u, policy.stats().batches);
+
+    surface->setFocused(true);
+    application->setRequestedState(Application::RequestedRunning);
+    ASSERT_EQ(Application::InternalState::Running, application->internalState());
+    EXPECT_TRUE(policy.isBoosted(application.data()));
+
+    // The boost ends with the first frame after resuming
+    Q_EMIT surface->framesPosted();
+    EXPECT_FALSE(policy.isBoosted(application.data()));
+    policy.waitForWrites();
+
+    writes = policy.dryRunWrites();
+    ASSERT_EQ(3, writes.count());
+    EXPECT_EQ(QByteArray::number(PriorityPolicy::priorityOf(PriorityPolicy::Focused, false).oomScoreAdj),
+              writes.last().value);
+
+    delete surface;
+}
+
+TEST_F(ApplicationTests, refusedPriorityWritesAreCounted)
+{
+    using namespace ::testing;
+
+    int argc = 0;
+    char* argv[0];
+    QCoreApplication qtApp(argc, argv); // for the queued flush
+
+    QScopedPointer<Application> application(createApplicationWithFakes());
+    application->setProcessState(Application::ProcessRunning);
+    Session *session = createSessionWithFakes();
+    application->addSession(session);
+
+    FakeMirSurface *surface = new FakeMirSurface;
+    session->registerSurface(surface);
+    surface->setReady();
+
+    // A directory where oom_score_adj is expected can't be written to, like a value below
+    // oom_score_adj_min wouldn't be
+    QTemporaryDir procDir;
+    ASSERT_TRUE(QDir(procDir.path()).mkpath(QStringLiteral("1234/oom_score_adj")));
+
+    PriorityPolicy policy(procDir.path());
+    policy.setMode(PriorityPolicy::Enabled);
+    policy.addApplication(application.data());
+    policy.waitForWrites();
+
+    EXPECT_EQ(1u, policy.stats().writes);
+    EXPECT_EQ(1u, policy.stats().failedWrites);
+
+    delete surface;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Unity/Application/cgroupfs.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <gtest/gtest.h>
+
+using namespace qtmir;
+
+class CGroupFsTest : public ::testing::Test
+{
+protected:
+    void writeFile(const QString &relativePath, const QByteArray &contents)
+    {
+        const QString path = root.path() + relativePath;
+        QDir().mkpath(QFileInfo(path).path());
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(contents);
+    }
+
+    void mount(const QByteArray &mountPoint, const QByteArray &fsType, const QByteArray &superOptions)
+    {
+        mountInfo += "30 25 0:27 / " + root.path().toUtf8() + mountPoint + " rw,nosuid shared:9 - "
+                + fsType + " cgroup " + superOptions + "\n";
+        writeFile("/mountinfo", mountInfo);
+    }
+
+    QString procPath() const { return root.path() + "/proc"; }
+    QString mountInfoPath() const { return root.path() + "/mountinfo"; }
+
+    QTemporaryDir root;
+    QByteArray mountInfo;
+};
+
+TEST_F(CGroupFsTest, readsLegacyControllerHierarchy)
+{
+    mount("/cgroup/freezer", "cgroup", "rw,freezer");
+    mount("/cgroup/systemd", "cgroup", "rw,xattr,name=systemd");
+    writeFile("/proc/42/cgroup", "5:freezer:/user.slice/upstart/application-gedit\n1:name=systemd:/user.slice\n");
+    writeFile("/cgroup/freezer/user.slice/upstart/application-gedit/cgroup.procs", "42\n43\n");
+
+    CGroupFs cgroupFs(procPath(), mountInfoPath());
+    ASSERT_TRUE(cgroupFs.isAvailable());
+
+    const QString cgroup = cgroupFs.cgroupOfPid("freezer", 42);
+    EXPECT_EQ(QString("/user.slice/upstart/application-gedit"), cgroup);
+    EXPECT_EQ(QSet<pid_t>({42, 43}), cgroupFs.processes("freezer", cgroup, 42));
+}
+
+TEST_F(CGroupFsTest, fallsBackToUnifiedHierarchy)
+{
+    mount("/cgroup/unified", "cgroup2", "rw,nsdelegate");
+    writeFile("/proc/42/cgroup", "0::/user.slice/app.slice/app-gedit.scope\n");
+    writeFile("/cgroup/unified/user.slice/app.slice/app-gedit.scope/cgroup.procs", "42\n");
+
+    CGroupFs cgroupFs(procPath(), mountInfoPath());
+
+    const QString cgroup = cgroupFs.cgroupOfPid("freezer", 42);
+    EXPECT_EQ(QString("/user.slice/app.slice/app-gedit.scope"), cgroup);
+    EXPECT_EQ(QSet<pid_t>({42}), cgroupFs.processes("freezer", cgroup, 42));
+}
+
+TEST_F(CGroupFsTest, cachedProcessesAreRefreshedWhenMissingKnownMember)
+{
+    mount("/cgroup/unified", "cgroup2", "rw");
+    writeFile("/cgroup/unified/app/cgroup.procs", "42\n");
+
+    CGroupFs cgroupFs(procPath(), mountInfoPath());
+    EXPECT_EQ(QSet<pid_t>({42}), cgroupFs.processes("freezer", "/app", 42));
+    EXPECT_EQ(1, cgroupFs.cachedCGroupCount());
+
+    writeFile("/cgroup/unified/app/cgroup.procs", "42\n44\n");
+
+    // still answered from the cache
+    EXPECT_EQ(QSet<pid_t>({42}), cgroupFs.processes("freezer", "/app", 42));
+
+    // but 44 is known to be in there
+    EXPECT_EQ(QSet<pid_t>({42, 44}), cgroupFs.processes("freezer", "/app", 44));
+}
+
+TEST_F(CGroupFsTest, unavailableWithoutCGroupMounts)
+{
+    mount("/tmp", "tmpfs", "rw");
+
+    CGroupFs cgroupFs(procPath(), mountInfoPath());
+
+    EXPECT_FALSE(cgroupFs.isAvailable());
+    EXPECT_TRUE(cgroupFs.cgroupOfPid("freezer", 42).isNull());
+}
+
+TEST_F(CGroupFsTest, freezesThroughLegacyAndUnifiedInterfaces)
+{
+    mount("/cgroup/unified", "cgroup2", "rw");
+    writeFile("/cgroup/unified/user.slice/app.slice/app-gedit.scope/cgroup.freeze", "0\n");
+
+    {
+        CGroupFs cgroupFs(procPath(), mountInfoPath());
+        ASSERT_TRUE(cgroupFs.setFrozen("/user.slice/app.slice/app-gedit.scope", true));
+
+        QFile file(root.path() + "/cgroup/unified/user.slice/app.slice/app-gedit.scope/cgroup.freeze");
+        ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+        EXPECT_EQ(QByteArray("1"), file.readAll());
+    }
+
+    mount("/cgroup/freezer", "cgroup", "rw,freezer");
+    writeFile("/cgroup/freezer/upstart/application-gedit/freezer.state", "THAWED\n");
+
+    CGroupFs cgroupFs(procPath(), mountInfoPath());
+    ASSERT_TRUE(cgroupFs.setFrozen("/upstart/application-gedit", true));
+
+    QFile file(root.path() + "/cgroup/freezer/upstart/application-gedit/freezer.state");
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    EXPECT_EQ(QByteArray("FROZEN"), file.readAll());
+
+    EXPECT_FALSE(cgroupFs.setFrozen("/no/such/cgroup", true));
+}
+
+TEST_F(CGroupFsTest, recognizesApplicationCGroups)
+{
+    EXPECT_TRUE(CGroupFs::isApplicationCGroup("/user.slice/user-32011.slice/session-c3.scope/upstart/application-legacy-gedit-"));
+    EXPECT_TRUE(CGroupFs::isApplicationCGroup("/user.slice/user-1000.slice/user@1000.service/app.slice/app-gedit-1234.scope"));
+    EXPECT_FALSE(CGroupFs::isApplicationCGroup("/user.slice/user-1000.slice/user@1000.service/app.slice"));
+    EXPECT_FALSE(CGroupFs::isApplicationCGroup("/user.slice/user-1000.slice/session-2.scope"));
+}
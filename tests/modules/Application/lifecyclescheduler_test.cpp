@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Unity/Application/lifecyclescheduler.h>
+#include <Unity/Application/timer.h>
+
+#include <QSignalSpy>
+
+#include <gtest/gtest.h>
+
+using namespace qtmir;
+
+class LifecycleSchedulerTest : public ::testing::Test
+{
+protected:
+    LifecycleSchedulerTest()
+        : fakeTimeSource(new FakeTimeSource)
+        , scheduler(SharedTimeSource(fakeTimeSource))
+    {}
+
+    void startAt(qint64 msecs, BatchedTimer &timer)
+    {
+        fakeTimeSource->m_msecsSinceReference = msecs;
+        timer.setInterval(1500);
+        timer.start();
+    }
+
+    void runAt(qint64 msecs)
+    {
+        fakeTimeSource->m_msecsSinceReference = msecs;
+        scheduler.runDueWork();
+    }
+
+    FakeTimeSource *fakeTimeSource;
+    LifecycleScheduler scheduler;
+};
+
+TEST_F(LifecycleSchedulerTest, timersStartedCloseTogetherFireInOneBatch)
+{
+    BatchedTimer first(&scheduler), second(&scheduler), third(&scheduler);
+    QSignalSpy firstSpy(&first, &AbstractTimer::timeout);
+    QSignalSpy secondSpy(&second, &AbstractTimer::timeout);
+    QSignalSpy thirdSpy(&third, &AbstractTimer::timeout);
+
+    startAt(10, first);
+    startAt(100, second);
+    startAt(200, third);
+    EXPECT_EQ(3, scheduler.pendingCount());
+
+    // due at 1510, but fires along with the others
+    runAt(1600);
+    EXPECT_EQ(0, firstSpy.count());
+
+    runAt(1750);
+    EXPECT_EQ(1, firstSpy.count());
+    EXPECT_EQ(1, secondSpy.count());
+    EXPECT_EQ(1, thirdSpy.count());
+    EXPECT_FALSE(first.isRunning());
+    EXPECT_EQ(0, scheduler.pendingCount());
+
+    EXPECT_EQ(1u, scheduler.batchStats().batches);
+    EXPECT_EQ(3u, scheduler.batchStats().timersFired);
+    EXPECT_EQ(3, scheduler.batchStats().largestBatch);
+}
+
+TEST_F(LifecycleSchedulerTest, stoppedOrRestartedTimersDoNotFire)
+{
+    BatchedTimer stopped(&scheduler), restarted(&scheduler);
+    QSignalSpy stoppedSpy(&stopped, &AbstractTimer::timeout);
+    QSignalSpy restartedSpy(&restarted, &AbstractTimer::timeout);
+
+    startAt(0, stopped);
+    startAt(0, restarted);
+
+    stopped.stop();
+    startAt(1000, restarted);
+
+    runAt(1500);
+    EXPECT_EQ(0, stoppedSpy.count());
+    EXPECT_EQ(0, restartedSpy.count());
+
+    runAt(2500);
+    EXPECT_EQ(0, stoppedSpy.count());
+    EXPECT_EQ(1, restartedSpy.count());
+}
+
+TEST_F(LifecycleSchedulerTest, timerDestroyedByAnotherOfTheSameBatchIsNotFired)
+{
+    BatchedTimer first(&scheduler);
+    BatchedTimer *second = new BatchedTimer(&scheduler);
+
+    QObject::connect(&first, &AbstractTimer::timeout, [&]() { delete second; second = nullptr; });
+    QObject::connect(second, &AbstractTimer::timeout, [&]() { FAIL(); });
+
+    startAt(0, first);
+    startAt(0, *second);
+
+    runAt(1500);
+    EXPECT_TRUE(second == nullptr);
+}
+
+TEST_F(LifecycleSchedulerTest, recordsTransitionLatencies)
+{
+    scheduler.recordTransition(LifecycleScheduler::SessionSuspend, 10);
+    scheduler.recordTransition(LifecycleScheduler::SessionSuspend, 30);
+
+    auto stats = scheduler.transitionStats(LifecycleScheduler::SessionSuspend);
+    EXPECT_EQ(2u, stats.count);
+    EXPECT_EQ(40, stats.totalMs);
+    EXPECT_EQ(30, stats.maxMs);
+
+    EXPECT_EQ(0u, scheduler.transitionStats(LifecycleScheduler::ApplicationStop).count);
+}
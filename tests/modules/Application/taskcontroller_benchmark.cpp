@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  Compares upstart::TaskController with and without its cache of UAL applications, doing what
+  ApplicationManager does when authorizing a session (appIdHasProcessId) and when starting an
+  application (getInfoForApp). Needs a UAL registry, so run it on a device or desktop session.
+
+  Usage: taskcontroller_benchmark <appId> [iterations]
+ */
+
+#include <Unity/Application/applicationinfo.h>
+#include <Unity/Application/upstart/taskcontroller.h>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <unistd.h>
+
+using namespace qtmir;
+
+namespace {
+
+template<typename F>
+double measureMicroseconds(int iterations, F f)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        f();
+    }
+    return timer.nsecsElapsed() / 1000.0 / iterations;
+}
+
+void compare(const char *path, upstart::TaskController &taskController, int iterations,
+             const std::function<void()> &f)
+{
+    taskController.setCacheEnabled(false);
+    const double uncachedUs = measureMicroseconds(iterations, f);
+
+    taskController.setCacheEnabled(true);
+    f(); // warm the cache up
+    const double cachedUs = measureMicroseconds(iterations, f);
+
+    printf("%s\n", path);
+    printf("  uncached: %10.2f us per call\n", uncachedUs);
+    printf("  cached:   %10.2f us per call\n", cachedUs);
+    printf("  speedup:  %10.2fx\n", uncachedUs / cachedUs);
+}
+
+} // namespace {
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <appId> [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    const QString appId = QString::fromLocal8Bit(argv[1]);
+    const int iterations = argc > 2 ? atoi(argv[2]) : 1000;
+
+    upstart::TaskController taskController;
+    if (!taskController.getInfoForApp(appId)) {
+        fprintf(stderr, "UAL does not know about %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("%s, %d iterations\n", argv[1], iterations);
+
+    const pid_t pid = getpid(); // not one of the app's, so all of its instances get checked
+    compare("authorizeSession (appIdHasProcessId)", taskController, iterations,
+            [&]() { taskController.appIdHasProcessId(appId, pid); });
+
+    compare("startApplication (getInfoForApp)", taskController, iterations,
+            [&]() { taskController.getInfoForApp(appId); });
+
+    const auto stats = taskController.cacheStats();
+    printf("cache hits %llu, misses %llu\n",
+           static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses));
+
+    return 0;
+}
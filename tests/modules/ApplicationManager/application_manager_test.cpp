@@ -16,8 +16,12 @@
 
 #define MIR_INCLUDE_DEPRECATED_EVENT_HEADER
 
+#include <chrono>
 #include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <QSignalSpy>
+#include <QThreadPool>
 
 #include <Unity/Application/session.h>
 #include <Unity/Application/timer.h>
@@ -217,6 +221,104 @@ TEST_F(ApplicationManagerTests,testAppIdGuessFromDesktopFileNameWithLongAppId)
     EXPECT_EQ(shortAppId, app->appId());
 }
 
+/*
+ * Test that once an application is reported as started, connections from its processes are
+ * authorized from the resolved process ids, without asking the task controller again
+ */
+TEST_F(ApplicationManagerTests,processesOfStartedApplicationAreAuthorizedWithoutQueryingTaskController)
+{
+    using namespace ::testing;
+    const pid_t procId = 5921;
+    const QString appId("my-app");
+
+    EXPECT_CALL(*taskController, start(appId, _)).WillOnce(Return(true));
+    ON_CALL(*taskController, processIds(appId)).WillByDefault(Return(QVector<pid_t>{procId}));
+
+    Application *application = applicationManager.startApplication(appId);
+    ASSERT_EQ(Application::Starting, application->state());
+
+    Q_EMIT taskController->applicationStarted(appId);
+    QThreadPool::globalInstance()->waitForDone();
+
+    EXPECT_CALL(*taskController, appIdHasProcessId(_, _)).Times(0);
+
+    bool authed = false;
+    applicationManager.authorizeSession(procId, authed);
+
+    EXPECT_TRUE(authed);
+    EXPECT_EQ(1u, applicationManager.processIdCacheStats().hits);
+}
+
+/*
+ * Test that processes resolved after their application stopped don't get in the way of the
+ * application which gets their pid recycled
+ */
+TEST_F(ApplicationManagerTests,lateProcessResolutionDoesNotRejectRecycledPid)
+{
+    using namespace ::testing;
+    const pid_t procId = 5921;
+    const QString stoppedAppId("my-app");
+    const QString startingAppId("other-app");
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopped = false;
+
+    EXPECT_CALL(*taskController, start(_, _)).WillRepeatedly(Return(true));
+    ON_CALL(*taskController, processIds(stoppedAppId)).WillByDefault(Invoke([&](const QString &) {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&]() { return stopped; });
+        return QVector<pid_t>{procId};
+    }));
+
+    applicationManager.startApplication(stoppedAppId);
+    Q_EMIT taskController->applicationStarted(stoppedAppId);
+    Q_EMIT taskController->processStopped(stoppedAppId);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    condition.notify_all();
+    QThreadPool::globalInstance()->waitForDone();
+
+    Application *application = applicationManager.startApplication(startingAppId);
+    ASSERT_EQ(Application::Starting, application->state());
+    EXPECT_CALL(*taskController, appIdHasProcessId(startingAppId, procId)).WillOnce(Return(true));
+
+    bool authed = false;
+    applicationManager.authorizeSession(procId, authed);
+
+    EXPECT_TRUE(authed);
+}
+
+/*
+ * Test that a process is still authorized when the task controller takes longer than the
+ * authorization deadline to resolve it
+ */
+TEST_F(ApplicationManagerTests,slowProcessResolutionStillAuthorizes)
+{
+    using namespace ::testing;
+    const pid_t procId = 5921;
+    const QString slowAppId("slow-app");
+    const QString startingAppId("my-app");
+
+    EXPECT_CALL(*taskController, start(_, _)).WillRepeatedly(Return(true));
+    applicationManager.startApplication(slowAppId);
+    Application *application = applicationManager.startApplication(startingAppId);
+    ASSERT_EQ(Application::Starting, application->state());
+
+    ON_CALL(*taskController, appIdHasProcessId(slowAppId, procId)).WillByDefault(Invoke([](const QString &, pid_t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        return false;
+    }));
+    EXPECT_CALL(*taskController, appIdHasProcessId(startingAppId, procId)).WillOnce(Return(true));
+
+    bool authed = false;
+    applicationManager.authorizeSession(procId, authed);
+
+    EXPECT_TRUE(authed);
+}
+
 TEST_F(ApplicationManagerTests,bug_case_1281075_session_ptrs_always_distributed_to_last_started_app)
 {
     using namespace ::testing;
@@ -709,6 +811,48 @@ TEST_F(ApplicationManagerTests,onceAppAddedToApplicationLists_upstartStartingEve
     EXPECT_EQ(Application::Starting, theApp->state());
 }
 
+/*
+ * Test that launching a pre-started application counts as a warm start once it's running
+ */
+TEST_F(ApplicationManagerTests,promotedWarmApplicationIsCountedAsWarmStart)
+{
+    using namespace ::testing;
+    const QString appId("testAppId");
+    const pid_t procId = 5551;
+
+    ON_CALL(settings, get(QString("warmStartPoolSize"))).WillByDefault(Return(QVariant(1)));
+    ON_CALL(settings, get(QString("warmStartMemoryBudget"))).WillByDefault(Return(QVariant(512)));
+    Q_EMIT settings.changed("warmStartPoolSize");
+    Q_EMIT settings.changed("warmStartMemoryBudget");
+
+    ON_CALL(*taskController, appIdHasProcessId(appId, procId)).WillByDefault(Return(true));
+    EXPECT_CALL(*taskController, start(appId, _)).WillRepeatedly(Return(true));
+
+    // launched often enough to be worth keeping pre-started
+    for (int i = 0; i < 2; ++i) {
+        applicationManager.startApplication(appId);
+        applicationManager.onProcessStopped(appId);
+    }
+    QMetaObject::invokeMethod(&applicationManager, "refillWarmStartPool");
+    ASSERT_EQ(nullptr, applicationManager.findApplication(appId));
+
+    Application *application = applicationManager.startApplication(appId);
+    ASSERT_NE(nullptr, application);
+    EXPECT_EQ(application, applicationManager.findApplication(appId));
+
+    auto appInfo = createApplicationInfoFor("", procId);
+    bool authed = false;
+    applicationManager.authorizeSession(procId, authed);
+    taskController->onSessionStarting(appInfo);
+
+    FakeMirSurface surface;
+    onSessionCreatedSurface(appInfo, &surface);
+    surface.setReady();
+    ASSERT_EQ(Application::Running, application->state());
+
+    EXPECT_EQ(1u, applicationManager.warmStartStats().hits);
+}
+
 /*
  * Test that an application in the Starting state reacts correctly to the Mir sessionStarted
  * event for that application (i.e. the Session is associated)
@@ -1952,3 +2096,52 @@ TEST_F(ApplicationManagerTests,surfaceFocusRequestGeneratesApplicationFocusReque
 
     EXPECT_EQ(1, focusRequestedSpy.count());
 }
+
+TEST_F(ApplicationManagerTests,dataChangesOfAnApplicationAreMergedIntoOneEmission)
+{
+    using namespace ::testing;
+
+    int argc = 0;
+    char* argv[0];
+    QCoreApplication qtApp(argc, argv);
+
+    const QString appId("testAppId");
+    quint64 procId = 5551;
+
+    ON_CALL(*taskController, appIdHasProcessId(appId, procId)).WillByDefault(Return(true));
+    EXPECT_CALL(*taskController, start(appId, _))
+        .Times(1)
+        .WillOnce(Return(true));
+
+    auto app = applicationManager.startApplication(appId);
+    applicationManager.onProcessStarting(appId);
+    auto appInfo = createApplicationInfoFor("", procId);
+    bool authed = false;
+    applicationManager.authorizeSession(procId, authed);
+    taskController->onSessionStarting(appInfo);
+
+    FakeMirSurface surface;
+    surface.setSession(app->sessions()[0]);
+    onSessionCreatedSurface(appInfo, &surface);
+    surface.setReady();
+    qtApp.processEvents(); // process queued signal-slot connections
+
+    EXPECT_EQ(app, applicationManager.findApplicationWithSurface(&surface));
+    EXPECT_EQ(app, applicationManager.findApplication(appId));
+
+    QSignalSpy dataChangedSpy(&applicationManager, &QAbstractItemModel::dataChanged);
+
+    surface.setFocused(true);
+    Q_EMIT applicationManager.resourceSampler()->usageChanged(QStringList{appId});
+    Q_EMIT applicationManager.resourceSampler()->usageChanged(QStringList{appId});
+    EXPECT_EQ(0, dataChangedSpy.count());
+
+    qtApp.processEvents(); // process queued signal-slot connections
+
+    ASSERT_EQ(1, dataChangedSpy.count());
+    EXPECT_EQ(0, dataChangedSpy.at(0).at(0).toModelIndex().row());
+    const QVector<int> roles = dataChangedSpy.at(0).at(2).value<QVector<int>>();
+    EXPECT_EQ(2, roles.count());
+    EXPECT_TRUE(roles.contains(ApplicationManager::RoleFocused));
+    EXPECT_TRUE(roles.contains(ApplicationManager::RoleResourceUsage));
+}
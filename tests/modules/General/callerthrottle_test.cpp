@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Unity/Application/callerthrottle.h>
+
+#include <gtest/gtest.h>
+
+using namespace qtmir;
+
+class CallerThrottleTest : public ::testing::Test
+{
+protected:
+    CallerThrottleTest()
+        : timeSource(new FakeTimeSource)
+        , throttle(SharedTimeSource(timeSource), 5 /* burst */, 10 /* per second */)
+    {}
+
+    FakeTimeSource *timeSource;
+    CallerThrottle throttle;
+};
+
+TEST_F(CallerThrottleTest, burstIsAdmittedThenRejectedUntilRefilled)
+{
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(throttle.admit(":1.42"));
+    }
+    EXPECT_FALSE(throttle.admit(":1.42"));
+
+    // other callers have their own budget
+    EXPECT_TRUE(throttle.admit(":1.43"));
+
+    timeSource->m_msecsSinceReference += 100;
+    EXPECT_TRUE(throttle.admit(":1.42"));
+    EXPECT_FALSE(throttle.admit(":1.42"));
+
+    EXPECT_EQ(7u, throttle.stats().admitted);
+    EXPECT_EQ(2u, throttle.stats().rejected);
+}
+
+TEST_F(CallerThrottleTest, consecutiveUnknownLookupsAreHeldBackIncreasingly)
+{
+    throttle.admit(":1.42");
+    EXPECT_EQ(0, throttle.recordLookup(":1.42", true));
+
+    throttle.admit(":1.42");
+    EXPECT_EQ(CallerThrottle::basePenaltyMs, throttle.recordLookup(":1.42", false));
+    throttle.admit(":1.42");
+    EXPECT_EQ(2 * CallerThrottle::basePenaltyMs, throttle.recordLookup(":1.42", false));
+
+    throttle.admit(":1.42");
+    EXPECT_EQ(4 * CallerThrottle::basePenaltyMs, throttle.recordLookup(":1.42", false));
+}
+
+TEST_F(CallerThrottleTest, lookingUpAKnownIdEndsTheStreak)
+{
+    throttle.admit(":1.42");
+    EXPECT_EQ(CallerThrottle::basePenaltyMs, throttle.recordLookup(":1.42", false));
+    throttle.admit(":1.42");
+    EXPECT_EQ(2 * CallerThrottle::basePenaltyMs, throttle.recordLookup(":1.42", false));
+
+    // e.g. an input method asking about a surface which exists but isn't focused
+    throttle.admit(":1.42");
+    EXPECT_EQ(0, throttle.recordLookup(":1.42", true));
+    throttle.admit(":1.42");
+    EXPECT_EQ(CallerThrottle::basePenaltyMs, throttle.recordLookup(":1.42", false));
+}
+
+TEST_F(CallerThrottleTest, penaltyIsCappedAndForgottenAfterQuietPeriod)
+{
+    int delay = 0;
+    for (int i = 0; i < 30; ++i) {
+        timeSource->m_msecsSinceReference += 1000;
+        throttle.admit(":1.42");
+        delay = throttle.recordLookup(":1.42", false);
+    }
+    EXPECT_EQ(CallerThrottle::maxPenaltyMs, delay);
+
+    timeSource->m_msecsSinceReference += CallerThrottle::penaltyResetMs + 1;
+    throttle.admit(":1.42");
+    EXPECT_EQ(CallerThrottle::basePenaltyMs, throttle.recordLookup(":1.42", false));
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Unity/Application/framepacer.h>
+
+#include <gtest/gtest.h>
+
+using namespace qtmir;
+
+namespace {
+const qint64 msecs = 1000000;
+}
+
+TEST(FramePacerTest, unpacedConsumesEveryFrame)
+{
+    FramePacer pacer;
+    pacer.frameConsumed(0);
+    EXPECT_TRUE(pacer.isFrameDue(1));
+}
+
+TEST(FramePacerTest, consumptionFromFasterScreenIsPacedToRefreshRate)
+{
+    FramePacer pacer;
+    pacer.setRefreshRate(60);
+
+    // Rendered by a 144Hz screen for 2 seconds
+    int consumed = 0;
+    for (qint64 now = 0; now < 2000 * msecs; now += 1000 * msecs / 144) {
+        if (pacer.isFrameDue(now)) {
+            pacer.frameConsumed(now);
+            ++consumed;
+        } else {
+            pacer.frameHeld();
+        }
+    }
+
+    EXPECT_NEAR(120, consumed, 3);
+    EXPECT_NEAR(60, pacer.effectiveFps(), 2);
+    EXPECT_GT(pacer.framesHeld(), 0u);
+}
+
+TEST(FramePacerTest, slowerScreenIsNotThrottledFurther)
+{
+    FramePacer pacer;
+    pacer.setRefreshRate(144);
+
+    for (int frame = 0; frame < 60; ++frame) {
+        const qint64 now = frame * 1000 * msecs / 60;
+        ASSERT_TRUE(pacer.isFrameDue(now));
+        pacer.frameConsumed(now);
+    }
+    EXPECT_EQ(0u, pacer.framesHeld());
+}
+
+TEST(FramePacerTest, pacingRestartsAfterClientStall)
+{
+    FramePacer pacer;
+    pacer.setRefreshRate(60);
+
+    pacer.frameConsumed(0);
+    EXPECT_FALSE(pacer.isFrameDue(5 * msecs));
+
+    // client didn't draw for a second, its next frame is shown right away and pacing follows it
+    EXPECT_TRUE(pacer.isFrameDue(1000 * msecs));
+    pacer.frameConsumed(1000 * msecs);
+    EXPECT_FALSE(pacer.isFrameDue(1005 * msecs));
+    EXPECT_TRUE(pacer.isFrameDue(1016 * msecs));
+}
+
+TEST(FramePacerTest, heldFrameIsDueAfterTheTimeLeft)
+{
+    FramePacer pacer;
+    pacer.setRefreshRate(60);
+    EXPECT_EQ(0, pacer.nsUntilDue(0));
+
+    pacer.frameConsumed(0);
+    const qint64 left = pacer.nsUntilDue(5 * msecs);
+    EXPECT_GT(left, 0);
+
+    EXPECT_FALSE(pacer.isFrameDue(5 * msecs + left - 1));
+    EXPECT_TRUE(pacer.isFrameDue(5 * msecs + left));
+    EXPECT_EQ(0, pacer.nsUntilDue(5 * msecs + left));
+}
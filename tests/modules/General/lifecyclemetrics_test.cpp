@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Unity/Application/lifecyclemetrics.h>
+
+#include <gtest/gtest.h>
+
+using namespace qtmir;
+
+TEST(LatencyHistogramTest, bucketsAndPercentiles)
+{
+    LatencyHistogram histogram;
+    EXPECT_EQ(0, histogram.percentile(50));
+
+    for (int i = 0; i < 9; ++i) {
+        histogram.add(100); // 64 <= 100 < 128
+    }
+    histogram.add(3000); // 2048 <= 3000 < 4096
+
+    EXPECT_EQ(10u, histogram.count());
+    EXPECT_EQ(100, histogram.min());
+    EXPECT_EQ(3000, histogram.max());
+    EXPECT_EQ(390, histogram.mean());
+    EXPECT_EQ(9u, histogram.bucket(4));
+    EXPECT_EQ(1u, histogram.bucket(9));
+
+    EXPECT_EQ(128, histogram.percentile(50));
+    EXPECT_EQ(128, histogram.percentile(90));
+    EXPECT_EQ(3000, histogram.percentile(99)); // capped to the maximum seen
+}
+
+TEST(LatencyHistogramTest, hugeValuesEndUpInLastBucket)
+{
+    LatencyHistogram histogram;
+    histogram.add(Q_INT64_C(10000000));
+    EXPECT_EQ(1u, histogram.bucket(LatencyHistogram::bucketCount - 1));
+}
+
+TEST(LifecycleMetricsTest, recordsPerApplicationAndOverall)
+{
+    LifecycleMetrics metrics;
+    metrics.record("gedit", LifecycleMetrics::LaunchToFirstFrame, 800);
+    metrics.record("gedit", LifecycleMetrics::LaunchToFirstFrame, 600);
+    metrics.record("calculator", LifecycleMetrics::LaunchToFirstFrame, 300);
+    metrics.record("calculator", LifecycleMetrics::ResumeToFirstFrame, 40);
+
+    EXPECT_EQ(2u, metrics.histogram("gedit", LifecycleMetrics::LaunchToFirstFrame).count());
+    EXPECT_EQ(700, metrics.histogram("gedit", LifecycleMetrics::LaunchToFirstFrame).mean());
+    EXPECT_EQ(0u, metrics.histogram("gedit", LifecycleMetrics::ResumeToFirstFrame).count());
+    EXPECT_EQ(0u, metrics.histogram("unknown", LifecycleMetrics::LaunchToFirstFrame).count());
+
+    EXPECT_EQ(3u, metrics.overall(LifecycleMetrics::LaunchToFirstFrame).count());
+    EXPECT_EQ(300, metrics.overall(LifecycleMetrics::LaunchToFirstFrame).min());
+
+    const QString dump = metrics.dump();
+    EXPECT_TRUE(dump.contains("gedit launchToFirstFrame count=2 min=600 mean=700"));
+    EXPECT_TRUE(dump.contains("calculator resumeToFirstFrame count=1"));
+    EXPECT_FALSE(dump.contains("gedit resumeToFirstFrame"));
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <Unity/Application/processidcache.h>
+
+#include <gtest/gtest.h>
+
+using namespace qtmir;
+
+TEST(ProcessIdCacheTest, insertedProcessesAreFound)
+{
+    ProcessIdCache cache;
+    cache.insert("gallery", cache.generation("gallery"), QVector<pid_t>{100, 101});
+
+    EXPECT_EQ(QString("gallery"), cache.appIdFor(100));
+    EXPECT_EQ(QString("gallery"), cache.appIdFor(101));
+    EXPECT_TRUE(cache.appIdFor(102).isNull());
+}
+
+TEST(ProcessIdCacheTest, resolutionFinishingAfterTheAppStoppedIsDropped)
+{
+    ProcessIdCache cache;
+    const quint64 generation = cache.generation("gallery");
+
+    // the application stops while its processes are being resolved
+    cache.removeApp("gallery");
+    cache.insert("gallery", generation, QVector<pid_t>{100});
+
+    EXPECT_TRUE(cache.appIdFor(100).isNull());
+
+    // the next instance
+    cache.insert("gallery", cache.generation("gallery"), 200);
+    EXPECT_EQ(QString("gallery"), cache.appIdFor(200));
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  Compares ProcInfo with the QFile::readLine + QRegularExpression implementation it replaced, doing
+  what ApplicationManager::authorizeSession does for a process without upstart: read its command
+  line and environment, and look for a desktop file hint in both.
+
+  Usage: procinfo_benchmark [pid] [iterations]
+ */
+
+#include <Unity/Application/proc_info.h>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRegularExpression>
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace qtmir;
+
+namespace {
+
+// The implementation ProcInfo used to have
+namespace legacy {
+
+QByteArray readProcFile(pid_t pid, const char *name)
+{
+    QFile file(QStringLiteral("/proc/%1/%2").arg(pid).arg(name));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QByteArray();
+    }
+    return file.readLine().replace('\0', ' ');
+}
+
+QString getParameter(const QByteArray &data, const QString &pattern)
+{
+    QRegularExpression regExp(pattern);
+    QRegularExpressionMatch regExpMatch = regExp.match(data);
+    if (!regExpMatch.hasMatch()) {
+        return QString();
+    }
+    return regExpMatch.captured(1);
+}
+
+QString desktopFileHint(pid_t pid)
+{
+    const QByteArray commandLine = readProcFile(pid, "cmdline");
+    QString hint = getParameter(commandLine, QRegularExpression::escape("--desktop_file_hint=") + "(\\S+)");
+    if (hint.isNull()) {
+        const QByteArray environment = readProcFile(pid, "environ");
+        if (environment.contains("DESKTOP_FILE_HINT")) {
+            hint = getParameter(environment, QRegularExpression::escape("DESKTOP_FILE_HINT") + "=(\\S+)");
+        }
+    }
+    return hint;
+}
+
+} // namespace legacy
+
+QString desktopFileHint(ProcInfo &procInfo, pid_t pid)
+{
+    auto commandLine = procInfo.commandLine(pid);
+    QString hint = commandLine->getParameter("--desktop_file_hint=");
+    if (hint.isNull()) {
+        auto environment = procInfo.environment(pid);
+        if (environment->contains("DESKTOP_FILE_HINT")) {
+            hint = environment->getParameter("DESKTOP_FILE_HINT");
+        }
+    }
+    return hint;
+}
+
+template<typename F>
+double measureMicroseconds(int iterations, F f)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        f();
+    }
+    return timer.nsecsElapsed() / 1000.0 / iterations;
+}
+
+} // namespace {
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    const pid_t pid = argc > 1 ? atoi(argv[1]) : getpid();
+    const int iterations = argc > 2 ? atoi(argv[2]) : 10000;
+
+    ProcInfo procInfo;
+    if (!procInfo.commandLine(pid)) {
+        fprintf(stderr, "Cannot read the command line of pid %d\n", pid);
+        return 1;
+    }
+
+    const double legacyUs = measureMicroseconds(iterations, [pid]() { legacy::desktopFileHint(pid); });
+    const double currentUs = measureMicroseconds(iterations, [&procInfo, pid]() { desktopFileHint(procInfo, pid); });
+
+    printf("pid %d, %d iterations\n", pid, iterations);
+    printf("readLine + QRegularExpression: %8.2f us per lookup\n", legacyUs);
+    printf("ProcInfo:                      %8.2f us per lookup\n", currentUs);
+    printf("speedup:                       %8.2fx\n", legacyUs / currentUs);
+
+    return 0;
+}
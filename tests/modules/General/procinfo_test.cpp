@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Unity/Application/proc_info.h>
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+using namespace qtmir;
+
+namespace {
+QByteArray nulSeparated(std::initializer_list<const char*> entries)
+{
+    QByteArray result;
+    for (const char *entry : entries) {
+        result.append(entry);
+        result.append('\0');
+    }
+    return result;
+}
+}
+
+TEST(ProcInfoTest, commandLineArgumentsKeepTheirSpaces)
+{
+    ProcInfo::CommandLine commandLine(nulSeparated({"/usr/bin/app", "--title=Hello World", "--desktop_file_hint=/opt/my app.desktop"}));
+
+    EXPECT_EQ(QStringList({"/usr/bin/app", "--title=Hello World", "--desktop_file_hint=/opt/my app.desktop"}),
+              commandLine.asStringList());
+    EXPECT_EQ(QString("/opt/my app.desktop"), commandLine.getParameter("--desktop_file_hint="));
+    EXPECT_TRUE(commandLine.getParameter("--missing=").isNull());
+    EXPECT_TRUE(commandLine.startsWith("/usr/bin/"));
+    EXPECT_FALSE(commandLine.startsWith("--title"));
+    EXPECT_TRUE(commandLine.contains("Hello World"));
+}
+
+TEST(ProcInfoTest, environmentValuesMayContainNewlines)
+{
+    ProcInfo::Environment environment(nulSeparated({"HOME=/home/user", "MULTILINE=first\nsecond", "DESKTOP_FILE_HINT=app.desktop"}));
+
+    EXPECT_EQ(QString("first\nsecond"), environment.getParameter("MULTILINE"));
+    EXPECT_TRUE(environment.contains("DESKTOP_FILE_HINT"));
+    EXPECT_EQ(QString("app.desktop"), environment.getParameter("DESKTOP_FILE_HINT"));
+    EXPECT_FALSE(environment.contains("HOM"));
+    EXPECT_TRUE(environment.getParameter("PATH").isNull());
+}
+
+TEST(ProcInfoTest, firstDefinitionOfEnvironmentVariableWins)
+{
+    ProcInfo::Environment environment(nulSeparated({"VAR=first", "VAR=second"}));
+
+    EXPECT_EQ(QString("first"), environment.getParameter("VAR"));
+}
+
+TEST(ProcInfoTest, readsOwnProcess)
+{
+    ProcInfo procInfo;
+
+    auto commandLine = procInfo.commandLine(getpid());
+    ASSERT_TRUE(commandLine != nullptr);
+    EXPECT_FALSE(commandLine->arguments().isEmpty());
+
+    EXPECT_TRUE(procInfo.environment(getpid()) != nullptr);
+    EXPECT_TRUE(procInfo.memoryUsage(getpid()).isValid());
+}
+
+TEST(ProcInfoTest, missingProcessGivesNothing)
+{
+    ProcInfo procInfo;
+
+    EXPECT_TRUE(procInfo.commandLine(-1) == nullptr);
+    EXPECT_TRUE(procInfo.environment(-1) == nullptr);
+    EXPECT_FALSE(procInfo.memoryUsage(-1).isValid());
+    EXPECT_EQ(-1, procInfo.cpuTimeMs(-1));
+}
+
+TEST(ProcInfoTest, memoryUsageIsReadFromSmapsRollup)
+{
+    auto usage = ProcInfo::MemoryUsage::fromSmapsRollup(
+            "55d4c7a6d000-7ffd5d1f1000 ---p 00000000 00:00 0                          [rollup]\n"
+            "Rss:               45320 kB\n"
+            "Pss:               20123 kB\n"
+            "Shared_Clean:      25484 kB\n"
+            "Private_Dirty:      6228 kB\n");
+
+    EXPECT_EQ(45320 * 1024, usage.rssBytes);
+    EXPECT_EQ(20123 * 1024, usage.pssBytes);
+}
+
+TEST(ProcInfoTest, cpuTimeIsReadFromStat)
+{
+    // comm with spaces and parentheses, utime 250 and stime 50 ticks
+    const QByteArray stat("1234 (my (odd) app) S 1 1234 1234 0 -1 4194560 2710 0 0 0 250 50 0 0 20 0 4 0 9147 "
+                          "1092292608 11314 18446744073709551615 1 1 0 0 0 0 0 4096 0 0 0 0 17 2 0 0 0 0 0\n");
+
+    EXPECT_EQ(300 * 1000 / sysconf(_SC_CLK_TCK), ProcInfo::cpuTimeMsFromStat(stat));
+    EXPECT_EQ(-1, ProcInfo::cpuTimeMsFromStat("garbage"));
+}
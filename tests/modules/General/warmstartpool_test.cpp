@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Unity/Application/warmstartpool.h>
+
+#include <gtest/gtest.h>
+
+using namespace qtmir;
+
+class WarmStartPoolTest : public ::testing::Test
+{
+protected:
+    WarmStartPoolTest()
+        : timeSource(new FakeTimeSource)
+        , pool(SharedTimeSource(timeSource))
+    {
+        pool.setCapacity(2);
+        pool.setMemoryBudget(3 * WarmStartPool::defaultMemoryEstimate);
+    }
+
+    void launch(const QString &appId, int times)
+    {
+        for (int i = 0; i < times; ++i) {
+            pool.recordLaunch(appId);
+        }
+    }
+
+    FakeTimeSource *timeSource;
+    WarmStartPool pool;
+};
+
+TEST_F(WarmStartPoolTest, mostFrequentlyLaunchedAppsAreCandidates)
+{
+    launch("gallery", 3);
+    launch("terminal", 5);
+    launch("camera", 4);
+    launch("notes", 1);
+
+    EXPECT_EQ(QStringList({"terminal", "camera"}), pool.candidates());
+
+    // already in use
+    EXPECT_EQ(QStringList({"camera", "gallery"}), pool.candidates({"terminal"}));
+}
+
+TEST_F(WarmStartPoolTest, appsLaunchedOnceAreNotCandidates)
+{
+    launch("notes", 1);
+
+    EXPECT_TRUE(pool.candidates().isEmpty());
+}
+
+TEST_F(WarmStartPoolTest, candidatesFitInMemoryBudget)
+{
+    launch("browser", 5);
+    launch("camera", 4);
+    launch("clock", 3);
+    pool.setMemoryEstimate("browser", 2 * WarmStartPool::defaultMemoryEstimate + 1);
+
+    EXPECT_EQ(QStringList({"browser"}), pool.candidates()); // camera doesn't fit next to it
+
+    pool.setMemoryEstimate("browser", WarmStartPool::defaultMemoryEstimate);
+    EXPECT_EQ(QStringList({"browser", "camera"}), pool.candidates());
+}
+
+TEST_F(WarmStartPoolTest, oldLaunchesFadeAway)
+{
+    launch("camera", 4);
+    timeSource->m_msecsSinceReference += 2 * WarmStartPool::halfLifeMs;
+    launch("clock", 2);
+
+    EXPECT_DOUBLE_EQ(1.0, pool.launchFrequency("camera"));
+    EXPECT_EQ(QStringList({"clock"}), pool.candidates());
+}
+
+TEST_F(WarmStartPoolTest, hitsAreComparedWithColdStarts)
+{
+    pool.recordColdStart("camera", 1000);
+    pool.recordWarmStart("camera", 100);
+
+    EXPECT_EQ(1u, pool.stats().hits);
+    EXPECT_EQ(1u, pool.stats().misses);
+    EXPECT_EQ(900, pool.stats().msSaved);
+    EXPECT_DOUBLE_EQ(0.5, pool.hitRate());
+}
+
+TEST_F(WarmStartPoolTest, disabledPoolHasNoCandidates)
+{
+    launch("terminal", 5);
+    pool.setCapacity(0);
+
+    EXPECT_TRUE(pool.candidates().isEmpty());
+}
@@ -284,6 +284,44 @@ TEST_F(SharedWakelockTest, wakelockAcquireReleaseAcquireWithDelays)
     EXPECT_TRUE(found);
 }
 
+TEST_F(SharedWakelockTest, releaseDelayAbsorbsReleaseAcquireCycles)
+{
+    implementRequestSysState();
+    implementClearSysState();
+
+    SharedWakelock wakelock(dbus.systemConnection(), 500);
+
+    QSignalSpy wakelockEnabledSpy(&wakelock, SIGNAL( enabledChanged(bool) ));
+
+    QScopedPointer<QObject> object(new QObject);
+    wakelock.acquire(object.data());
+    wakelockEnabledSpy.wait();
+    ASSERT_TRUE(wakelock.enabled());
+
+    QSignalSpy wakelockDBusMethodSpy(&powerdMockInterface(), SIGNAL(MethodCalled(const QString &, const QVariantList &)));
+
+    wakelock.release(object.data());
+    EXPECT_TRUE(wakelock.enabled()); // held for a while longer
+    wakelock.acquire(object.data());
+    wakelock.release(object.data());
+    wakelock.acquire(object.data());
+
+    wakelockDBusMethodSpy.wait(800); // past the release delay
+    EXPECT_TRUE(wakelockDBusMethodSpy.empty());
+    EXPECT_TRUE(wakelock.enabled());
+    EXPECT_EQ(4u, wakelock.stats().dbusCallsAvoided);
+    EXPECT_EQ(1u, wakelock.stats().dbusCalls);
+
+    // Released for good once nobody wants it for long enough
+    wakelock.release(object.data());
+    wakelockDBusMethodSpy.wait();
+
+    EXPECT_FALSE(wakelockDBusMethodSpy.empty());
+    EXPECT_CALL(wakelockDBusMethodSpy, 0, "clearSysState",
+                QVariantList() << QString("cookie"));
+    EXPECT_FALSE(wakelock.enabled());
+}
+
 TEST_F(SharedWakelockTest, nullOwnerAcquireIgnored)
 {
     implementRequestSysState();
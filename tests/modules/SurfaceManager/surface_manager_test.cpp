@@ -473,3 +473,124 @@ TEST_F(SurfaceManagerTests, surfaceManagerDoesNotDeleteLiveMirSurfaceWhenStopsBe
     // Check result
     ASSERT_EQ(0, mirSurfaceDestroyedSpy.count());
 }
+
+/*
+ * Test that the window stack snapshot is only published once a MirAL transaction ends,
+ * and that it then reflects all changes made during that transaction
+ */
+TEST_F(SurfaceManagerTests, windowStackSnapshotIsPublishedAtEndOfTransaction)
+{
+    QPoint newPosition(222,333);
+
+    // Setup: add window outside of any transaction
+    Q_EMIT wmNotifier.windowAdded(windowInfo);
+    qtApp->sendPostedEvents();
+    auto snapshotBefore = WindowStackSnapshot::current();
+    ASSERT_EQ(1, snapshotBefore->entries().count());
+
+    // Test
+    Q_EMIT wmNotifier.modificationsStarted();
+    Q_EMIT wmNotifier.windowMoved(windowInfo, newPosition);
+    Q_EMIT wmNotifier.windowFocusChanged(windowInfo, true);
+    qtApp->sendPostedEvents();
+
+    EXPECT_EQ(snapshotBefore, WindowStackSnapshot::current());
+
+    Q_EMIT wmNotifier.modificationsEnded();
+    qtApp->sendPostedEvents();
+
+    // Check result
+    auto snapshot = WindowStackSnapshot::current();
+    ASSERT_EQ(1, snapshot->entries().count());
+    EXPECT_EQ(newPosition, snapshot->entries().first().geometry.topLeft());
+    EXPECT_TRUE(snapshot->entries().first().focused);
+}
+
+/*
+ * Test that the window stack snapshot is ordered bottom to top and follows raises
+ */
+TEST_F(SurfaceManagerTests, windowStackSnapshotFollowsStackingOrder)
+{
+    const std::shared_ptr<StubSurface> otherStubSurface{std::make_shared<StubSurface>()};
+    const miral::Window otherWindow{stubSession, otherStubSurface};
+    const miral::WindowInfo otherWindowInfo{otherWindow, spec};
+
+    Q_EMIT wmNotifier.windowAdded(windowInfo);
+    Q_EMIT wmNotifier.windowAdded(otherWindowInfo);
+    Q_EMIT wmNotifier.windowMoved(otherWindowInfo, QPoint(10, 10));
+    qtApp->sendPostedEvents();
+
+    auto snapshot = WindowStackSnapshot::current();
+    ASSERT_EQ(2, snapshot->entries().count());
+    EXPECT_EQ(QPoint(10, 10), snapshot->entries().last().geometry.topLeft());
+
+    // Test
+    Q_EMIT wmNotifier.windowsRaised({window});
+    qtApp->sendPostedEvents();
+
+    // Check result
+    snapshot = WindowStackSnapshot::current();
+    ASSERT_EQ(2, snapshot->entries().count());
+    EXPECT_EQ(QPoint(10, 10), snapshot->entries().first().geometry.topLeft());
+}
+
+/*
+ * Test that windows removed during a MirAL transaction have their MirSurfaces destroyed
+ * together in a single sweep once the transaction ends
+ */
+TEST_F(SurfaceManagerTests, surfacesRemovedInTransactionAreDestroyedInOneSweep)
+{
+    const std::shared_ptr<StubSurface> otherStubSurface{std::make_shared<StubSurface>()};
+    const miral::Window otherWindow{stubSession, otherStubSurface};
+    const miral::WindowInfo otherWindowInfo{otherWindow, spec};
+
+    Q_EMIT wmNotifier.windowAdded(windowInfo);
+    Q_EMIT wmNotifier.windowAdded(otherWindowInfo);
+    qtApp->sendPostedEvents();
+
+    QSignalSpy mirSurfaceDestroyedSpy(surfaceManager->find(windowInfo), &QObject::destroyed);
+    QSignalSpy otherMirSurfaceDestroyedSpy(surfaceManager->find(otherWindowInfo), &QObject::destroyed);
+    const auto statsBefore = surfaceManager->sweepStats();
+
+    // Test
+    Q_EMIT wmNotifier.modificationsStarted();
+    Q_EMIT wmNotifier.windowRemoved(windowInfo);
+    Q_EMIT wmNotifier.windowRemoved(otherWindowInfo);
+    qtApp->sendPostedEvents();
+
+    EXPECT_FALSE(surfaceManager->find(windowInfo));
+    EXPECT_EQ(0, mirSurfaceDestroyedSpy.count());
+
+    Q_EMIT wmNotifier.modificationsEnded();
+    qtApp->sendPostedEvents();
+    qtApp->sendPostedEvents(); // the sweep is posted when the transaction ends
+
+    // Check result
+    EXPECT_NE(0, mirSurfaceDestroyedSpy.count());
+    EXPECT_NE(0, otherMirSurfaceDestroyedSpy.count());
+    EXPECT_EQ(statsBefore.sweeps + 1, surfaceManager->sweepStats().sweeps);
+    EXPECT_EQ(statsBefore.surfacesDestroyed + 2, surfaceManager->sweepStats().surfacesDestroyed);
+}
+
+/*
+ * Test that the memory of a destroyed MirSurface gets reused for the next one
+ */
+TEST_F(SurfaceManagerTests, mirSurfaceMemoryIsReused)
+{
+    Q_EMIT wmNotifier.windowAdded(windowInfo);
+    qtApp->sendPostedEvents();
+    Q_EMIT wmNotifier.windowRemoved(windowInfo);
+    qtApp->sendPostedEvents();
+
+    const auto statsBefore = MirSurface::surfacePoolStats();
+
+    // Test
+    Q_EMIT wmNotifier.windowAdded(windowInfo);
+    qtApp->sendPostedEvents();
+
+    // Check result
+    const auto stats = MirSurface::surfacePoolStats();
+    EXPECT_EQ(statsBefore.allocations + 1, stats.allocations);
+    EXPECT_EQ(statsBefore.reuses + 1, stats.reuses);
+    EXPECT_EQ(statsBefore.slabs, stats.slabs);
+}
@@ -40,6 +40,7 @@ struct MirEvent {}; // otherwise won't compile otherwise due to incomplete type
 // tests/framework
 #include "stub_buffer.h"
 #include "stub_windowcontroller.h"
+#include "mock_window_controller.h"
 #include "mock_renderable.h"
 
 // tests/modules/common
@@ -110,6 +111,52 @@ TEST_F(MirSurfaceTest, UpdateTextureBeforeDraw)
     ASSERT_TRUE(spyFrameDropped.count() > 0);
 }
 
+/*
+ * Test that a frame held back as it came too early for the screen still gets shown once it is due,
+ * without the client posting another one.
+ */
+TEST_F(MirSurfaceTest, HeldFrameIsRenderedWhenDue)
+{
+    int argc = 0;
+    char* argv[0];
+    QCoreApplication qtApp(argc, argv); // for the timers
+
+    auto mockSurface = std::make_shared<NiceMock<MockSurface>>();
+    miral::Window mockWindow(stubSession, mockSurface);
+    ms::SurfaceCreationParameters spec;
+    miral::WindowInfo mockWindowInfo(mockWindow, spec);
+    auto mockRenderable = std::make_shared<NiceMock<mir::graphics::MockRenderable>>();
+
+    EXPECT_CALL(*mockSurface.get(),buffers_ready_for_compositor(_))
+        .WillRepeatedly(Return(1));
+
+    EXPECT_CALL(*mockSurface.get(),generate_renderables(_))
+        .WillRepeatedly(Return(mir::graphics::RenderableList{mockRenderable}));
+
+    EXPECT_CALL(*mockRenderable.get(),buffer())
+        .WillRepeatedly(Return(std::make_shared<mir::graphics::StubBuffer>()));
+
+    MirSurface surface(mockWindowInfo, nullptr);
+    surface.setPacingRefreshRate(20); // a frame every 50ms
+    auto texture = surface.texture();
+
+    EXPECT_TRUE(surface.updateTexture());
+    const unsigned int firstFrame = surface.currentFrameNumber();
+    surface.onCompositorSwappedBuffers();
+
+    // The client's next, and last, frame is already queued: too early, it is held
+    QSignalSpy spyFramesPosted(&surface, SIGNAL(framesPosted()));
+    EXPECT_TRUE(surface.updateTexture());
+    EXPECT_EQ(firstFrame, surface.currentFrameNumber());
+    EXPECT_EQ(1u, surface.framesHeldForPacing());
+
+    // A render is asked for once it is due, well before the frame dropper would step in
+    ASSERT_TRUE(spyFramesPosted.wait(150));
+    EXPECT_TRUE(surface.updateTexture());
+    EXPECT_EQ(firstFrame + 1, surface.currentFrameNumber());
+    EXPECT_EQ(1u, surface.framesHeldForPacing());
+}
+
 /*
  * Test that MirSurface.visible is recalculated after the client swaps the first frame.
  * A surface is not considered visible unless it has a non-hidden & non-minimized state, and
@@ -184,3 +231,67 @@ TEST_F(MirSurfaceTest, failedSurfaceCloseEventuallyDestroysSurface)
     surface.setLive(false);
     surface.unregisterView(view);
 }
+
+/*
+ * Test that while a resize is waiting for the client to post a frame of the requested size,
+ * further resize requests are coalesced and only the latest one gets sent afterwards.
+ */
+TEST_F(MirSurfaceTest, ResizesAreCoalescedUntilClientPostsFrameOfRequestedSize)
+{
+    int argc = 0;
+    char* argv[0];
+    QCoreApplication qtApp(argc, argv);
+
+    miral::Window window(stubSession, stubSurface);
+    ms::SurfaceCreationParameters spec;
+    miral::WindowInfo windowInfo(window, spec);
+    NiceMock<MockWindowController> controller;
+
+    MirSurface surface(windowInfo, &controller);
+
+    EXPECT_CALL(controller, resize(_, QSize(100, 100))).Times(1);
+    EXPECT_CALL(controller, resize(_, QSize(200, 200))).Times(0);
+    EXPECT_CALL(controller, resize(_, QSize(300, 300))).Times(1);
+
+    surface.resize(100, 100);
+    surface.resize(200, 200);
+    surface.resize(300, 300);
+
+    // a frame of the old size doesn't release the pending resize
+    surface.surfaceObserver()->frame_posted(1, mir::geometry::Size{50, 50});
+    // but one of the requested size does
+    surface.surfaceObserver()->frame_posted(1, mir::geometry::Size{100, 100});
+
+    auto stats = surface.resizeStats();
+    EXPECT_EQ(2u, stats.configuresSent);
+    EXPECT_EQ(1u, stats.requestsCoalesced);
+    EXPECT_EQ(1u, stats.framesAtRequestedSize);
+    EXPECT_EQ(1u, stats.framesAtOtherSize);
+}
+
+/*
+ * Test that a client which doesn't redraw after a resize doesn't hold up further resizes forever
+ */
+TEST_F(MirSurfaceTest, PendingResizeIsSentWhenClientDoesNotPostFrame)
+{
+    int argc = 0;
+    char* argv[0];
+    QCoreApplication qtApp(argc, argv);
+
+    miral::Window window(stubSession, stubSurface);
+    ms::SurfaceCreationParameters spec;
+    miral::WindowInfo windowInfo(window, spec);
+    NiceMock<MockWindowController> controller;
+
+    MirSurface surface(windowInfo, &controller);
+
+    EXPECT_CALL(controller, resize(_, QSize(100, 100))).Times(1);
+    EXPECT_CALL(controller, resize(_, QSize(200, 200))).Times(1);
+
+    surface.resize(100, 100);
+    surface.resize(200, 200);
+
+    QTest::qWait(300);
+
+    EXPECT_GE(surface.resizeStats().ackTimeouts, 1u);
+}
@@ -21,6 +21,7 @@ struct MirEvent {}; // otherwise won't compile otherwise due to incomplete type
 #include <gtest/gtest.h>
 
 #include <QLoggingCategory>
+#include <QQuickWindow>
 #include <QTest>
 #include <private/qquickitem_p.h>
 
@@ -164,6 +165,30 @@ TEST_F(MirSurfaceItemTest, AggregateSurfaceVisibility)
     delete fakeSurface;
 }
 
+/*
+  Tests that a surface shown in a window which isn't exposed, eg. as its display is off, is
+  reported as not exposed either, so that its client stops drawing.
+ */
+TEST_F(MirSurfaceItemTest, SurfaceNotExposedWhileItsWindowIsNot)
+{
+    QQuickWindow window; // never shown, thus not exposed
+
+    MirSurfaceItem *surfaceItem = new MirSurfaceItem;
+    FakeMirSurface *fakeSurface = new FakeMirSurface;
+    surfaceItem->setSurface(fakeSurface);
+    EXPECT_TRUE(fakeSurface->visible());
+
+    surfaceItem->setParentItem(window.contentItem());
+    EXPECT_TRUE(surfaceItem->isVisible());
+    EXPECT_FALSE(fakeSurface->visible());
+
+    surfaceItem->setParentItem(nullptr);
+    EXPECT_TRUE(fakeSurface->visible());
+
+    delete surfaceItem;
+    delete fakeSurface;
+}
+
 TEST_F(MirSurfaceItemTest, NoSurfaceActiveFocusIfItemDoesNotConsumeInput)
 {
     using namespace testing;